@@ -27,10 +27,13 @@ public:
 	// Target/Output sample rate
 	uint32 GetSampleRate() const;
 
+	// Number of audio device callbacks that could not be mixed in time (since Init)
+	uint32 GetOverrunCount() const;
+
 	// Private
 	class Audio_Impl* GetImpl();
 
-	// Calculated audio latency by the audio driver (currently unused)
+	// Audio latency in milliseconds added by the output processing (the master limiter's look-ahead)
 	int64 audioLatency;
 
 private:
@@ -1,4 +1,5 @@
 #pragma once
+#include <atomic>
 
 /*
 	Base class for Digital Signal Processors
@@ -11,14 +12,23 @@ public:
 	virtual ~DSP();
 	// Process <numSamples> amount of samples in stereo float format
 	virtual void Process(float* out, uint32 numSamples) = 0;
+	// Number of samples the output of this DSP lags behind its input
+	virtual uint32 GetLatency() const { return 0; }
 
 	float mix = 1.0f;
 	uint32 priority = 0;
 	uint32 startTime = 0;
 	int32 chartOffset = 0;
 	int32 lastTimingPoint = 0;
+	// Playback position of audioBase at the first sample of the block passed to Process, at the mixer's sample rate
+	//	set by the mixer before every call to Process
+	int64 blockStartSample = 0;
 	class AudioBase* audioBase = nullptr;
 	class Audio_Impl* audio = nullptr;
+
+protected:
+	// Number of samples at the start of a block of numSamples that come before startTime, these are left untouched
+	uint32 m_GetStartOffset(uint32 numSamples) const;
 };
 
 /*
@@ -33,6 +43,9 @@ public:
 	
 	// Gets the playback position in millisecond
 	virtual int32 GetPosition() const = 0;
+	// Gets the playback position in samples at the mixer's sample rate
+	//	the default implementation converts the millisecond position
+	virtual int64 GetSamplePosition() const;
 
 	// Get the sample rate of this audio stream
 	virtual uint32 GetSampleRate() const = 0;
@@ -40,7 +53,6 @@ public:
 	// Gets pcm data from a decoded stream, nullptr if not available
 	virtual float* GetPCM() = 0;
 
-	void ProcessDSPs(float*& out, uint32 numSamples);
 	// Adds a signal processor to the audio
 	void AddDSP(DSP* dsp);
 	// Removes a signal processor from the audio
@@ -59,9 +71,17 @@ public:
 		return m_volume;
 	}
 
+	// Sorted by priority, owned by the main thread
+	// the mixer keeps its own copy which is updated through Audio_Impl::UpdateDSPs
 	Vector<DSP*> DSPs;
 	float PlaybackSpeed = 1.0;
+	// Combined latency of the DSPs on this audio in samples
+	//	set when DSPs are added or removed and kept up to date by the mixer, read from other threads
+	std::atomic<uint32> DSPLatency = { 0 };
 	class Audio_Impl* audio = nullptr;
 private:
+	// Sets DSPLatency right away so positions don't jump while the mixer picks up the change
+	void m_UpdateDSPLatency();
+
 	float m_volume = 1.0f;
 };
\ No newline at end of file
@@ -0,0 +1,53 @@
+/*
+	Vectorized sample processing kernels used by the mixer
+	All kernels operate on flat float arrays (interleaved stereo is simply 2 * numSamples values)
+	and produce exactly the same output as their scalar versions
+*/
+#pragma once
+
+namespace AudioKernels
+{
+	enum class Path : uint8
+	{
+		Scalar = 0,
+		SSE2,
+		AVX2,
+	};
+
+	// The best path supported by the CPU this is running on
+	Path GetSupportedPath();
+	// Path currently used by the kernels, defaults to the supported path
+	Path GetActivePath();
+	// Overrides the kernel path (clamped to what the CPU supports), used for testing/benchmarking
+	void SetActivePath(Path path);
+	const char* GetPathName(Path path);
+
+	// dst[i] += src[i] * gain
+	void MixGain(float* dst, const float* src, float gain, uint32 count);
+	// dst[i] = (int16)(0x7FFF * clamp(src[i], -1, 1))
+	void ConvertToInt16(int16* dst, const float* src, uint32 count);
+	// Returns max(abs(src[i])), NaN values are ignored
+	float PeakAbs(const float* src, uint32 count);
+	// For numSamples interleaved stereo samples:
+	// dst[i] = clamp(src[i] * (gain + step * (frame + 1)), -limit, limit)
+	void GainRampClamp(float* dst, const float* src, float gain, float step, float limit, uint32 numSamples);
+
+	// Biquad coefficients, normalized so that a0 = 1
+	struct BiquadCoefficients
+	{
+		float b0 = 1.0f;
+		float b1 = 0.0f;
+		float b2 = 0.0f;
+		float a1 = 0.0f;
+		float a2 = 0.0f;
+	};
+	// Transposed direct form II delay elements for the left and right channel
+	struct BiquadState
+	{
+		float s1[2] = { 0.0f };
+		float s2[2] = { 0.0f };
+	};
+	// Filters numSamples interleaved stereo samples in place
+	//	the coefficients are linearly interpolated from 'from' to 'to' over the length of the block
+	void Biquad(float* buf, uint32 numSamples, BiquadState& state, const BiquadCoefficients& from, const BiquadCoefficients& to);
+}
@@ -19,4 +19,6 @@ public:
 	// Sets the playback position in milliseconds
 	// negative time alowed, which will produce no audio for a certain amount of time
 	virtual void SetPosition(int32 pos) = 0;
+	// Gets the playback position in seconds, without rounding it to milliseconds
+	virtual double GetPositionSeconds() const = 0;
 };
@@ -1,16 +1,21 @@
 #pragma once
 #include "AudioOutput.hpp"
 #include "AudioBase.hpp"
+#include <Shared/LockFreeQueue.hpp>
 
 // Threading
 #include <thread>
 #include <mutex>
+#include <atomic>
 using std::thread;
 using std::mutex;
 
 class Audio_Impl : public IMixer
 {
 public:
+	// Maximum number of DSP's that can be active on a single item
+	static const uint32 maxItemDSPs = 16;
+
 	void Start();
 	void Stop();
 	// Get samples
@@ -18,15 +23,19 @@ public:
 	// Registers an AudioBase to be rendered
 	void Register(AudioBase* audio);
 	// Removes an AudioBase so it is no longer rendered
+	// after this returns the mixer is guaranteed to no longer access the item
 	void Deregister(AudioBase* audio);
+	// Sends the current DSP list of an item to the mixer
+	// after this returns the mixer is guaranteed to no longer access any removed DSP
+	void UpdateDSPs(AudioBase* audio);
 
 	uint32 GetSampleRate() const;
 	double GetSecondsPerSample() const;
 
 	float globalVolume = 1.0f;
 
+	// Only used to serialize threads sending commands to the mixer, never locked by the audio thread
 	mutex lock;
-	Vector<AudioBase*> itemsToRender;
 	Vector<DSP*> globalDSPs;
 
 	class LimiterDSP* limiter = nullptr;
@@ -36,7 +45,54 @@ public:
 	uint32 m_sampleBufferLength = 384;
 	uint32 m_remainingSamples = 0;
 
+	// Number of device callbacks that took longer to mix than the duration of audio they produced
+	std::atomic<uint32> overrunCount = { 0 };
+
 	thread audioThread;
 	bool runAudioThread = false;
 	AudioOutput* output = nullptr;
-};
\ No newline at end of file
+
+private:
+	// Mixer side state of a registered item, only accessed by the audio thread
+	struct Voice
+	{
+		AudioBase* item;
+		DSP* dsps[maxItemDSPs];
+		uint32 numDSPs;
+	};
+	struct Command
+	{
+		enum Type : uint8
+		{
+			AddVoice,
+			RemoveVoice,
+			SetDSPs,
+		};
+		Type type;
+		AudioBase* item;
+		DSP* dsps[maxItemDSPs];
+		uint32 numDSPs;
+	};
+
+	void m_SendCommand(const Command& cmd, bool waitForMixer);
+	bool m_ApplyCommandDirectly(const Command& cmd);
+	void m_ProcessCommands();
+	Voice* m_FindVoice(AudioBase* item);
+	void m_RenderItems();
+
+	LockFreeQueue<Command, 256> m_commands;
+	// Incremented before and after each rendered block, odd while the mixer is rendering
+	std::atomic<uint64> m_mixEpoch = { 0 };
+	// Set while the output is started, commands are applied by the sender when it is not
+	std::atomic<bool> m_mixerRunning = { false };
+	// Held by the mixer for each callback, or by a sender applying commands in its place
+	std::atomic<bool> m_mixerBusy = { false };
+	// Voices that did not fit in the voice list, logged by the sending thread
+	std::atomic<uint32> m_droppedVoices = { 0 };
+
+	// Preallocated mixer buffers
+	Voice* m_voices = nullptr;
+	uint32 m_numVoices = 0;
+	uint32 m_maxVoices = 256;
+	float* m_itemBuffer = nullptr;
+};
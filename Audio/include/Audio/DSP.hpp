@@ -3,6 +3,7 @@
 */
 #pragma once
 #include "AudioBase.hpp"
+#include "AudioKernels.hpp"
 #include <Shared/Interpolation.hpp>
 
 class PanDSP : public DSP
@@ -19,16 +20,10 @@ public:
 class BQFDSP : public DSP
 {
 public:
-	float b0 = 1.0f;
-	float b1 = 0.0f;
-	float b2 = 0.0f;
-	float a0 = 1.0f;
-	float a1 = 0.0f;
-	float a2 = 0.0f;
-
 	virtual void Process(float* out, uint32 numSamples);
 
 	// Sets the filter parameters
+	//	the filter smoothly moves to the new coefficients over the next processed block
 	void SetPeaking(float q, float freq, float gain);
 	void SetLowPass(float q, float freq);
 	void SetHighPass(float q, float freq);
@@ -37,12 +32,29 @@ public:
 	void SetLowPass(float q, float freq, float sampleRate);
 	void SetHighPass(float q, float freq, float sampleRate);
 private:
-	// Delayed samples
-	static const uint32 order = 2;
-	// FIR Delay buffers
-	float zb[2][order];
-	// IIR Delay buffers
-	float za[2][order];
+	enum class FilterType : uint8
+	{
+		None = 0,
+		LowPass,
+		HighPass,
+		Peaking,
+	};
+	// Returns false when the parameters did not change since the last call, in which case the coefficients don't need to be recalculated
+	bool m_SetParameters(FilterType type, float q, float freq, float gain, float sampleRate);
+	// Normalizes and stores the coefficients for the next processed block
+	void m_SetCoefficients(double b0, double b1, double b2, double a0, double a1, double a2);
+
+	FilterType m_type = FilterType::None;
+	float m_q = 0.0f;
+	float m_freq = 0.0f;
+	float m_gain = 0.0f;
+	float m_sampleRate = 0.0f;
+	bool m_hasCoefficients = false;
+
+	// Coefficients used at the end of the last processed block and the ones to move towards in the next one
+	AudioKernels::BiquadCoefficients m_current;
+	AudioKernels::BiquadCoefficients m_target;
+	AudioKernels::BiquadState m_state;
 };
 
 // Combinded Low/High-pass and Peaking filter
@@ -58,15 +70,36 @@ private:
 	BQFDSP peak;
 };
 
-// Basic limiter
+// Look-ahead limiter
+//	the output is delayed by two chunks, so the gain is already lowered when a peak comes out
+//	the output never exceeds the ceiling, anything that gets past the gain reduction is clipped
 class LimiterDSP : public DSP
 {
 public:
+	// Maximum output amplitude
+	float ceiling = 0.9f;
+	// Time in seconds for the gain to mostly recover after a peak
 	float releaseTime = 0.1f;
+	// Gain applied to the input before limiting
+	float gain = 1.0f;
+
+	LimiterDSP();
 	virtual void Process(float* out, uint32 numSamples);
+	virtual uint32 GetLatency() const override;
 private:
-	float m_currentMaxVolume = 1.0f;
-	float m_currentReleaseTimer = releaseTime;
+	// Length of a chunk in samples, the gain is calculated once per chunk
+	static const uint32 chunkLength = 32;
+	float m_TargetGain(float peak) const;
+
+	// The chunk currently being output, which is replaced with the input, and the next one
+	float m_chunks[2][chunkLength * 2];
+	float m_peaks[2] = { 0.0f };
+	uint32 m_outputChunk = 0;
+	uint32 m_position = 0;
+	float m_inputPeak = 0.0f;
+
+	float m_currentGain = 1.0f;
+	float m_gainStep = 0.0f;
 };
 
 class BitCrusherDSP : public DSP
@@ -236,6 +269,22 @@ private:
 	size_t m_time = 0;
 };
 
+// Delays the audio by a fixed number of samples
+class DelayDSP : public DSP
+{
+public:
+	// Allocates the delay line, call before adding the DSP to a track
+	void SetDelay(uint32 numSamples);
+
+	virtual void Process(float* out, uint32 numSamples);
+	virtual uint32 GetLatency() const override;
+private:
+	uint32 m_delay = 0;
+	uint32 m_position = 0;
+	Vector<float> m_buffer;
+};
+
+// Output is delayed by GetLatency samples, also when mix is 0, so it can stay on a track without changing its timing
 class PitchShiftDSP : public DSP
 {
 public:
@@ -246,6 +295,7 @@ public:
 	~PitchShiftDSP();
 
 	virtual void Process(float* out, uint32 numSamples);
+	virtual uint32 GetLatency() const override;
 private:
 	class PitchShiftDSP_Impl* m_impl;
 };
\ No newline at end of file
@@ -4,25 +4,28 @@
 #include "Audio_Impl.hpp"
 #include "AudioOutput.hpp"
 #include "DSP.hpp"
+#include "AudioKernels.hpp"
 
 Audio* g_audio = nullptr;
 Audio_Impl impl;
 
-void Audio_Impl::Mix(void* data, uint32& numSamples)
-{
 #if _DEBUG
-	static const uint32 guardBand = 1024;
+static const uint32 guardBand = 1024;
 #else
-	static const uint32 guardBand = 0;
+static const uint32 guardBand = 0;
 #endif
 
-	// Per-Channel data buffer
-	float* tempData = new float[m_sampleBufferLength * 2 + guardBand];
-	uint32* guardBuffer = (uint32*)tempData + 2 * m_sampleBufferLength;
-	double adv = GetSecondsPerSample();
+// Time without any mixed block after which a full command queue is assumed to belong to a lost device
+static const double maxMixerStall = 0.5;
+
+void Audio_Impl::Mix(void* data, uint32& numSamples)
+{
+	// Used to detect callbacks that did not finish within the time they are supposed to fill
+	Timer callbackTimer;
 
 	uint32 outputChannels = this->output->GetNumChannels();
-	if (output->IsIntegerFormat())
+	const bool integerFormat = output->IsIntegerFormat();
+	if (integerFormat)
 	{
 		memset(data, 0, numSamples * sizeof(int16) * outputChannels);
 	}
@@ -31,6 +34,10 @@ void Audio_Impl::Mix(void* data, uint32& numSamples)
 		memset(data, 0, numSamples * sizeof(float) * outputChannels);
 	}
 
+	// A sender is applying commands in place of a stalled mixer, output silence for this callback
+	if(m_mixerBusy.exchange(true))
+		return;
+
 	uint32 currentNumberOfSamples = 0;
 	while(currentNumberOfSamples < numSamples)
 	{
@@ -41,53 +48,21 @@ void Audio_Impl::Mix(void* data, uint32& numSamples)
 			memset(m_sampleBuffer, 0, sizeof(float) * 2 * m_sampleBufferLength);
 
 			// Render items
-			lock.lock();
-			for(auto& item : itemsToRender)
-			{
-				// Clearn per-channel data (and guard buffer in debug mode)
-				memset(tempData, 0, sizeof(float) * (2 * m_sampleBufferLength + guardBand));
-				item->Process(tempData, m_sampleBufferLength);
-#if _DEBUG
-				// Check for memory corruption
-				for(uint32 i = 0; i < guardBand; i++)
-				{
-					assert(guardBuffer[i] == 0);
-				}
-#endif
-				item->ProcessDSPs(tempData, m_sampleBufferLength);
-#if _DEBUG
-				// Check for memory corruption
-				for(uint32 i = 0; i < guardBand; i++)
-				{
-					assert(guardBuffer[i] == 0);
-				}
-#endif
-
-				// Mix into buffer and apply volume scaling
-				for(uint32 i = 0; i < m_sampleBufferLength; i++)
-				{
-					m_sampleBuffer[i * 2 + 0] += tempData[i * 2] * item->GetVolume();
-					m_sampleBuffer[i * 2 + 1] += tempData[i * 2 + 1] * item->GetVolume();
-				}
-			}
+			m_mixEpoch++;
+			m_ProcessCommands();
+			m_RenderItems();
 
 			// Process global DSPs
 			for(auto dsp : globalDSPs)
 			{
 				dsp->Process(m_sampleBuffer, m_sampleBufferLength);
 			}
-			lock.unlock();
+			m_mixEpoch++;
 
-			// Apply volume levels
-			for(uint32 i = 0; i < m_sampleBufferLength; i++)
-			{
-				m_sampleBuffer[i * 2 + 0] *= globalVolume;
-				m_sampleBuffer[i * 2 + 1] *= globalVolume;
-				// Safety clamp to [-1, 1] that should help protect speakers a bit in case of corruption
-				// this will clip, but so will values outside [-1, 1] anyway
-				m_sampleBuffer[i * 2 + 0] = fmin(fmax(m_sampleBuffer[i * 2 + 0], -1.f), 1.f);
-				m_sampleBuffer[i * 2 + 1] = fmin(fmax(m_sampleBuffer[i * 2 + 1], -1.f), 1.f);
-			}
+			// Apply volume levels and limit the output
+			// the limiter also clips to its ceiling, to protect speakers a bit in case of corruption
+			limiter->gain = globalVolume;
+			limiter->Process(m_sampleBuffer, m_sampleBufferLength);
 
 			// Set new remaining buffer data
 			m_remainingSamples = m_sampleBufferLength;
@@ -96,20 +71,30 @@ void Audio_Impl::Mix(void* data, uint32& numSamples)
 		// Copy samples from sample buffer
 		uint32 sampleOffset = m_sampleBufferLength - m_remainingSamples;
 		uint32 maxSamples = Math::Min(numSamples - currentNumberOfSamples, m_remainingSamples);
-		for(uint32 c = 0; c < outputChannels; c++)
+		const float* src = m_sampleBuffer + sampleOffset * 2;
+		if(outputChannels == 2)
 		{
-			if(c < 2)
+			// Output layout matches the sample buffer, convert/copy in one go
+			if(integerFormat)
+				AudioKernels::ConvertToInt16((int16*)data + currentNumberOfSamples * 2, src, maxSamples * 2);
+			else
+				memcpy((float*)data + currentNumberOfSamples * 2, src, maxSamples * 2 * sizeof(float));
+		}
+		else
+		{
+			for(uint32 c = 0; c < outputChannels && c < 2; c++)
 			{
-				for(uint32 i = 0; i < maxSamples; i++)
+				if(integerFormat)
 				{
-					if (output->IsIntegerFormat())
-					{
-						((int16*)data)[(currentNumberOfSamples + i) * outputChannels + c] = (int16)(0x7FFF * Math::Clamp(m_sampleBuffer[(sampleOffset + i) * 2 + c],-1.f,1.f));
-					}
-					else
-					{
-						((float*)data)[(currentNumberOfSamples + i) * outputChannels + c] = m_sampleBuffer[(sampleOffset + i) * 2 + c];
-					}
+					int16* dst = (int16*)data + currentNumberOfSamples * outputChannels + c;
+					for(uint32 i = 0; i < maxSamples; i++)
+						dst[i * outputChannels] = (int16)(0x7FFF * Math::Clamp(src[i * 2 + c], -1.f, 1.f));
+				}
+				else
+				{
+					float* dst = (float*)data + currentNumberOfSamples * outputChannels + c;
+					for(uint32 i = 0; i < maxSamples; i++)
+						dst[i * outputChannels] = src[i * 2 + c];
 				}
 			}
 			// TODO: Mix to surround channels as well?
@@ -118,43 +103,235 @@ void Audio_Impl::Mix(void* data, uint32& numSamples)
 		currentNumberOfSamples += maxSamples;
 	}
 
-	delete[] tempData;
+	m_mixerBusy = false;
+
+	if(callbackTimer.SecondsAsDouble() > (double)numSamples * GetSecondsPerSample())
+		overrunCount++;
+}
+void Audio_Impl::m_RenderItems()
+{
+	// Per-Channel data buffer
+	float* tempData = m_itemBuffer;
+	uint32* guardBuffer = (uint32*)tempData + 2 * m_sampleBufferLength;
+
+	for(uint32 v = 0; v < m_numVoices; v++)
+	{
+		Voice& voice = m_voices[v];
+		AudioBase* item = voice.item;
+
+		// Position of the first sample in this block, the DSPs use this to find where their effect starts
+		int64 blockStartSample = item->GetSamplePosition();
+
+		// Clearn per-channel data (and guard buffer in debug mode)
+		memset(tempData, 0, sizeof(float) * (2 * m_sampleBufferLength + guardBand));
+		item->Process(tempData, m_sampleBufferLength);
+#if _DEBUG
+		// Check for memory corruption
+		for(uint32 i = 0; i < guardBand; i++)
+		{
+			assert(guardBuffer[i] == 0);
+		}
+#endif
+		uint32 latency = 0;
+		for(uint32 d = 0; d < voice.numDSPs; d++)
+		{
+			voice.dsps[d]->blockStartSample = blockStartSample;
+			voice.dsps[d]->Process(tempData, m_sampleBufferLength);
+			latency += voice.dsps[d]->GetLatency();
+		}
+		item->DSPLatency = latency;
+#if _DEBUG
+		// Check for memory corruption
+		for(uint32 i = 0; i < guardBand; i++)
+		{
+			assert(guardBuffer[i] == 0);
+		}
+#endif
+
+		// Mix into buffer and apply volume scaling
+		AudioKernels::MixGain(m_sampleBuffer, tempData, item->GetVolume(), 2 * m_sampleBufferLength);
+	}
+}
+Audio_Impl::Voice* Audio_Impl::m_FindVoice(AudioBase* item)
+{
+	for(uint32 v = 0; v < m_numVoices; v++)
+	{
+		if(m_voices[v].item == item)
+			return &m_voices[v];
+	}
+	return nullptr;
+}
+void Audio_Impl::m_ProcessCommands()
+{
+	// Apply voice changes sent by other threads, this never blocks and never allocates
+	Command cmd;
+	while(m_commands.Pop(cmd))
+	{
+		Voice* voice = m_FindVoice(cmd.item);
+		switch(cmd.type)
+		{
+		case Command::AddVoice:
+			if(!voice)
+			{
+				if(m_voices && m_numVoices < m_maxVoices)
+				{
+					voice = &m_voices[m_numVoices++];
+					voice->item = cmd.item;
+					voice->numDSPs = 0;
+				}
+				else
+				{
+					m_droppedVoices++;
+				}
+			}
+			break;
+		case Command::RemoveVoice:
+			if(voice)
+			{
+				// Keep rendering order
+				Voice* last = m_voices + m_numVoices;
+				std::move(voice + 1, last, voice);
+				m_numVoices--;
+			}
+			break;
+		case Command::SetDSPs:
+			if(voice)
+			{
+				memcpy(voice->dsps, cmd.dsps, sizeof(DSP*) * cmd.numDSPs);
+				voice->numDSPs = cmd.numDSPs;
+			}
+			break;
+		}
+	}
+}
+void Audio_Impl::m_SendCommand(const Command& cmd, bool waitForMixer)
+{
+	lock.lock();
+	bool applied = false;
+	if(!m_mixerRunning)
+	{
+		// Nothing would empty the queue, apply it here
+		applied = m_ApplyCommandDirectly(cmd);
+	}
+	else
+	{
+		Timer stallTimer;
+		uint64 lastEpoch = m_mixEpoch;
+		while(!m_commands.Push(cmd))
+		{
+			// Queue full, the mixer should empty it on the next block
+			uint64 epoch = m_mixEpoch;
+			if(epoch != lastEpoch)
+			{
+				lastEpoch = epoch;
+				stallTimer.Restart();
+			}
+			else if(stallTimer.SecondsAsDouble() > maxMixerStall)
+			{
+				// The output stopped calling the mixer (device lost)
+				applied = m_ApplyCommandDirectly(cmd);
+				if(applied)
+					break;
+			}
+			std::this_thread::yield();
+		}
+	}
+
+	// Commands are applied at the start of the next block,
+	// so only a block that was already being rendered can still be using the old state
+	if(waitForMixer && !applied)
+	{
+		uint64 epoch = m_mixEpoch;
+		if(epoch & 1)
+		{
+			while(m_mixEpoch == epoch)
+				std::this_thread::yield();
+		}
+	}
+	lock.unlock();
+
+	uint32 droppedVoices = m_droppedVoices.exchange(0);
+	if(droppedVoices > 0)
+		Logf("Too many playing audio items, %d were not added (limit is %d)", Logger::Warning, droppedVoices, m_maxVoices);
+}
+bool Audio_Impl::m_ApplyCommandDirectly(const Command& cmd)
+{
+	// Fails if the mixer is currently rendering
+	if(m_mixerBusy.exchange(true))
+		return false;
+
+	// Apply anything still queued first to keep the command order
+	m_ProcessCommands();
+	m_commands.Push(cmd);
+	m_ProcessCommands();
+
+	m_mixerBusy = false;
+	return true;
 }
 void Audio_Impl::Start()
 {
 	m_sampleBuffer = new float[2 * m_sampleBufferLength];
+	m_itemBuffer = new float[2 * m_sampleBufferLength + guardBand];
+	m_voices = new Voice[m_maxVoices];
+	m_numVoices = 0;
 
 	limiter = new LimiterDSP();
 	limiter->audio = this;
 	limiter->releaseTime = 0.2f;
-	globalDSPs.Add(limiter);
+	m_mixerRunning = true;
 	output->Start(this);
 }
 void Audio_Impl::Stop()
 {
 	output->Stop();
+	m_mixerRunning = false;
 	delete limiter;
-	globalDSPs.Remove(limiter);
+	limiter = nullptr;
 
 	delete[] m_sampleBuffer;
 	m_sampleBuffer = nullptr;
+	delete[] m_itemBuffer;
+	m_itemBuffer = nullptr;
+	delete[] m_voices;
+	m_voices = nullptr;
+	m_numVoices = 0;
 }
 void Audio_Impl::Register(AudioBase* audio)
 {
 	if (audio)
 	{
-		lock.lock();
-		itemsToRender.AddUnique(audio);
 		audio->audio = this;
-		lock.unlock();
+		Command cmd;
+		cmd.type = Command::AddVoice;
+		cmd.item = audio;
+		cmd.numDSPs = 0;
+		m_SendCommand(cmd, false);
+		if(!audio->DSPs.empty())
+			UpdateDSPs(audio);
 	}
 }
 void Audio_Impl::Deregister(AudioBase* audio)
 {
-	lock.lock();
-	itemsToRender.Remove(audio);
+	Command cmd;
+	cmd.type = Command::RemoveVoice;
+	cmd.item = audio;
+	cmd.numDSPs = 0;
+	m_SendCommand(cmd, true);
 	audio->audio = nullptr;
-	lock.unlock();
+}
+void Audio_Impl::UpdateDSPs(AudioBase* audio)
+{
+	Command cmd;
+	cmd.type = Command::SetDSPs;
+	cmd.item = audio;
+	cmd.numDSPs = (uint32)audio->DSPs.size();
+	if(cmd.numDSPs > maxItemDSPs)
+	{
+		Logf("Too many DSP's on a single audio item (%d), only the first %d will be processed", Logger::Warning, cmd.numDSPs, maxItemDSPs);
+		cmd.numDSPs = maxItemDSPs;
+	}
+	memcpy(cmd.dsps, audio->DSPs.data(), sizeof(DSP*) * cmd.numDSPs);
+	m_SendCommand(cmd, true);
 }
 uint32 Audio_Impl::GetSampleRate() const
 {
@@ -196,6 +373,7 @@ bool Audio::Init(bool exclusive)
 	}
 
 	impl.Start();
+	audioLatency = (int64)impl.limiter->GetLatency() * 1000 / impl.GetSampleRate();
 
 	return m_initialized = true;
 }
@@ -207,6 +385,10 @@ uint32 Audio::GetSampleRate() const
 {
 	return impl.output->GetSampleRate();
 }
+uint32 Audio::GetOverrunCount() const
+{
+	return impl.overrunCount;
+}
 class Audio_Impl* Audio::GetImpl()
 {
 	return &impl;
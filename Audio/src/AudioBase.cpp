@@ -8,6 +8,13 @@ DSP::~DSP()
 	// Make sure this is removed from parent
 	assert(!audioBase);
 }
+uint32 DSP::m_GetStartOffset(uint32 numSamples) const
+{
+	if(!audio)
+		return 0;
+	int64 startSample = (int64)startTime * audio->GetSampleRate() / 1000;
+	return (uint32)Math::Clamp<int64>(startSample - blockStartSample, 0, numSamples);
+}
 
 AudioBase::~AudioBase()
 {
@@ -15,16 +22,12 @@ AudioBase::~AudioBase()
 	assert(!audio);
 	assert(DSPs.empty());
 }
-void AudioBase::ProcessDSPs(float*& out, uint32 numSamples)
+int64 AudioBase::GetSamplePosition() const
 {
-	for(DSP* dsp : DSPs)
-	{
-		dsp->Process(out, numSamples);
-	}
+	return (int64)GetPosition() * audio->GetSampleRate() / 1000;
 }
 void AudioBase::AddDSP(DSP* dsp)
 {
-	audio->lock.lock();
 	DSPs.AddUnique(dsp);
 	// Sort by priority
 	DSPs.Sort([](DSP* l, DSP* r)
@@ -35,16 +38,26 @@ void AudioBase::AddDSP(DSP* dsp)
 	});
 	dsp->audioBase = this;
 	dsp->audio = audio;
-	audio->lock.unlock();
+	m_UpdateDSPLatency();
+	audio->UpdateDSPs(this);
 }
 void AudioBase::RemoveDSP(DSP* dsp)
 {
 	assert(DSPs.Contains(dsp));
-	audio->lock.lock();
 	DSPs.Remove(dsp);
+	m_UpdateDSPLatency();
+	// Wait for the mixer to drop the DSP before unbinding it
+	audio->UpdateDSPs(this);
 	dsp->audioBase = nullptr;
 	dsp->audio = nullptr;
-	audio->lock.unlock();
+}
+
+void AudioBase::m_UpdateDSPLatency()
+{
+	uint32 latency = 0;
+	for(DSP* dsp : DSPs)
+		latency += dsp->GetLatency();
+	DSPLatency = latency;
 }
 
 void AudioBase::Deregister()
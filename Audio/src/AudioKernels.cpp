@@ -0,0 +1,368 @@
+#include "stdafx.h"
+#include "AudioKernels.hpp"
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AUDIO_KERNELS_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC allows using AVX intrinsics without compiling the whole file for AVX
+#define AUDIO_KERNELS_AVX2
+#else
+#define AUDIO_KERNELS_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace AudioKernels
+{
+	// Scalar reference implementations
+	// these define the exact output the vectorized versions need to match
+	static void MixGain_Scalar(float* dst, const float* src, float gain, uint32 count)
+	{
+		for(uint32 i = 0; i < count; i++)
+		{
+			dst[i] += src[i] * gain;
+		}
+	}
+	static void ConvertToInt16_Scalar(int16* dst, const float* src, uint32 count)
+	{
+		for(uint32 i = 0; i < count; i++)
+		{
+			dst[i] = (int16)(0x7FFF * Math::Clamp(src[i], -1.f, 1.f));
+		}
+	}
+	static float PeakAbs_Scalar(const float* src, uint32 count)
+	{
+		float peak = 0.0f;
+		for(uint32 i = 0; i < count; i++)
+		{
+			peak = fmax(fabsf(src[i]), peak);
+		}
+		return peak;
+	}
+	// Processes frames [begin, end), also used for the leftover frames of the vectorized versions
+	static void GainRampClampFrames(float* dst, const float* src, float gain, float step, float limit, uint32 begin, uint32 end)
+	{
+		for(uint32 i = begin; i < end; i++)
+		{
+			float g = gain + step * (float)(i + 1);
+			for(uint32 c = 0; c < 2; c++)
+			{
+				dst[i * 2 + c] = fmin(fmax(src[i * 2 + c] * g, -limit), limit);
+			}
+		}
+	}
+	static void GainRampClamp_Scalar(float* dst, const float* src, float gain, float step, float limit, uint32 numSamples)
+	{
+		GainRampClampFrames(dst, src, gain, step, limit, 0, numSamples);
+	}
+	// The coefficients are stepped by delta before each sample, the vectorized version does the same operations in the same order
+	static void Biquad_Scalar(float* buf, uint32 numSamples, BiquadState& state, const BiquadCoefficients& from, const BiquadCoefficients& delta)
+	{
+		BiquadCoefficients c = from;
+		float s1[2] = { state.s1[0], state.s1[1] };
+		float s2[2] = { state.s2[0], state.s2[1] };
+		for(uint32 i = 0; i < numSamples; i++)
+		{
+			c.b0 += delta.b0;
+			c.b1 += delta.b1;
+			c.b2 += delta.b2;
+			c.a1 += delta.a1;
+			c.a2 += delta.a2;
+			for(uint32 ch = 0; ch < 2; ch++)
+			{
+				float x = buf[i * 2 + ch];
+				float y = c.b0 * x + s1[ch];
+				s1[ch] = (c.b1 * x - c.a1 * y) + s2[ch];
+				s2[ch] = c.b2 * x - c.a2 * y;
+				buf[i * 2 + ch] = y;
+			}
+		}
+		for(uint32 ch = 0; ch < 2; ch++)
+		{
+			state.s1[ch] = s1[ch];
+			state.s2[ch] = s2[ch];
+		}
+	}
+
+#ifdef AUDIO_KERNELS_X86
+	// Note that the min/max order is important here, _mm_max_ps returns the second operand for NaN inputs
+	// which gives the same result as fmax in the scalar path
+	static void MixGain_SSE2(float* dst, const float* src, float gain, uint32 count)
+	{
+		const __m128 g = _mm_set1_ps(gain);
+		uint32 i = 0;
+		for(; i + 4 <= count; i += 4)
+		{
+			__m128 d = _mm_loadu_ps(dst + i);
+			__m128 s = _mm_loadu_ps(src + i);
+			_mm_storeu_ps(dst + i, _mm_add_ps(d, _mm_mul_ps(s, g)));
+		}
+		MixGain_Scalar(dst + i, src + i, gain, count - i);
+	}
+	static void ConvertToInt16_SSE2(int16* dst, const float* src, uint32 count)
+	{
+		const __m128 scale = _mm_set1_ps((float)0x7FFF);
+		const __m128 lo = _mm_set1_ps(-1.f);
+		const __m128 hi = _mm_set1_ps(1.f);
+		uint32 i = 0;
+		for(; i + 8 <= count; i += 8)
+		{
+			__m128 a = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i), lo), hi);
+			__m128 b = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 4), lo), hi);
+			// Truncating conversion, same as the scalar cast
+			__m128i ia = _mm_cvttps_epi32(_mm_mul_ps(a, scale));
+			__m128i ib = _mm_cvttps_epi32(_mm_mul_ps(b, scale));
+			_mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(ia, ib));
+		}
+		ConvertToInt16_Scalar(dst + i, src + i, count - i);
+	}
+	static float PeakAbs_SSE2(const float* src, uint32 count)
+	{
+		const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+		__m128 peak = _mm_setzero_ps();
+		uint32 i = 0;
+		for(; i + 4 <= count; i += 4)
+		{
+			// NaN in the first operand returns the second one
+			peak = _mm_max_ps(_mm_and_ps(_mm_loadu_ps(src + i), absMask), peak);
+		}
+		float lanes[4];
+		_mm_storeu_ps(lanes, peak);
+		float result = PeakAbs_Scalar(src + i, count - i);
+		for(uint32 l = 0; l < 4; l++)
+			result = fmax(lanes[l], result);
+		return result;
+	}
+	static void GainRampClamp_SSE2(float* dst, const float* src, float gain, float step, float limit, uint32 numSamples)
+	{
+		const __m128 g = _mm_set1_ps(gain);
+		const __m128 s = _mm_set1_ps(step);
+		const __m128 lo = _mm_set1_ps(-limit);
+		const __m128 hi = _mm_set1_ps(limit);
+		// Two stereo frames per vector, frame numbers are converted from integers just like the scalar version
+		__m128i frame = _mm_setr_epi32(1, 1, 2, 2);
+		const __m128i frameStep = _mm_set1_epi32(2);
+		uint32 i = 0;
+		for(; i + 2 <= numSamples; i += 2)
+		{
+			__m128 gains = _mm_add_ps(g, _mm_mul_ps(s, _mm_cvtepi32_ps(frame)));
+			__m128 v = _mm_mul_ps(_mm_loadu_ps(src + i * 2), gains);
+			_mm_storeu_ps(dst + i * 2, _mm_min_ps(_mm_max_ps(v, lo), hi));
+			frame = _mm_add_epi32(frame, frameStep);
+		}
+		GainRampClampFrames(dst, src, gain, step, limit, i, numSamples);
+	}
+	// Filters the left and right channel at once in the lower two lanes
+	// every sample depends on the previous one, so there is no wider AVX2 version of this
+	static void Biquad_SSE2(float* buf, uint32 numSamples, BiquadState& state, const BiquadCoefficients& from, const BiquadCoefficients& delta)
+	{
+		__m128 b0 = _mm_set1_ps(from.b0);
+		__m128 b1 = _mm_set1_ps(from.b1);
+		__m128 b2 = _mm_set1_ps(from.b2);
+		__m128 a1 = _mm_set1_ps(from.a1);
+		__m128 a2 = _mm_set1_ps(from.a2);
+		const __m128 db0 = _mm_set1_ps(delta.b0);
+		const __m128 db1 = _mm_set1_ps(delta.b1);
+		const __m128 db2 = _mm_set1_ps(delta.b2);
+		const __m128 da1 = _mm_set1_ps(delta.a1);
+		const __m128 da2 = _mm_set1_ps(delta.a2);
+		__m128 s1 = _mm_setr_ps(state.s1[0], state.s1[1], 0.0f, 0.0f);
+		__m128 s2 = _mm_setr_ps(state.s2[0], state.s2[1], 0.0f, 0.0f);
+		for(uint32 i = 0; i < numSamples; i++)
+		{
+			b0 = _mm_add_ps(b0, db0);
+			b1 = _mm_add_ps(b1, db1);
+			b2 = _mm_add_ps(b2, db2);
+			a1 = _mm_add_ps(a1, da1);
+			a2 = _mm_add_ps(a2, da2);
+
+			double* frame = (double*)(buf + i * 2);
+			__m128 x = _mm_castpd_ps(_mm_load_sd(frame));
+			__m128 y = _mm_add_ps(_mm_mul_ps(b0, x), s1);
+			s1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), s2);
+			s2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+			_mm_store_sd(frame, _mm_castps_pd(y));
+		}
+		float out[4];
+		_mm_storeu_ps(out, s1);
+		state.s1[0] = out[0];
+		state.s1[1] = out[1];
+		_mm_storeu_ps(out, s2);
+		state.s2[0] = out[0];
+		state.s2[1] = out[1];
+	}
+
+	AUDIO_KERNELS_AVX2 static void MixGain_AVX2(float* dst, const float* src, float gain, uint32 count)
+	{
+		// Separate mul/add, a fused multiply-add would round differently from the scalar path
+		const __m256 g = _mm256_set1_ps(gain);
+		uint32 i = 0;
+		for(; i + 8 <= count; i += 8)
+		{
+			__m256 d = _mm256_loadu_ps(dst + i);
+			__m256 s = _mm256_loadu_ps(src + i);
+			_mm256_storeu_ps(dst + i, _mm256_add_ps(d, _mm256_mul_ps(s, g)));
+		}
+		MixGain_Scalar(dst + i, src + i, gain, count - i);
+	}
+	AUDIO_KERNELS_AVX2 static float PeakAbs_AVX2(const float* src, uint32 count)
+	{
+		const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+		__m256 peak = _mm256_setzero_ps();
+		uint32 i = 0;
+		for(; i + 8 <= count; i += 8)
+		{
+			peak = _mm256_max_ps(_mm256_and_ps(_mm256_loadu_ps(src + i), absMask), peak);
+		}
+		float lanes[8];
+		_mm256_storeu_ps(lanes, peak);
+		float result = PeakAbs_Scalar(src + i, count - i);
+		for(uint32 l = 0; l < 8; l++)
+			result = fmax(lanes[l], result);
+		return result;
+	}
+	AUDIO_KERNELS_AVX2 static void GainRampClamp_AVX2(float* dst, const float* src, float gain, float step, float limit, uint32 numSamples)
+	{
+		const __m256 g = _mm256_set1_ps(gain);
+		const __m256 s = _mm256_set1_ps(step);
+		const __m256 lo = _mm256_set1_ps(-limit);
+		const __m256 hi = _mm256_set1_ps(limit);
+		__m256i frame = _mm256_setr_epi32(1, 1, 2, 2, 3, 3, 4, 4);
+		const __m256i frameStep = _mm256_set1_epi32(4);
+		uint32 i = 0;
+		for(; i + 4 <= numSamples; i += 4)
+		{
+			// Separate mul/add, same as MixGain
+			__m256 gains = _mm256_add_ps(g, _mm256_mul_ps(s, _mm256_cvtepi32_ps(frame)));
+			__m256 v = _mm256_mul_ps(_mm256_loadu_ps(src + i * 2), gains);
+			_mm256_storeu_ps(dst + i * 2, _mm256_min_ps(_mm256_max_ps(v, lo), hi));
+			frame = _mm256_add_epi32(frame, frameStep);
+		}
+		GainRampClampFrames(dst, src, gain, step, limit, i, numSamples);
+	}
+	AUDIO_KERNELS_AVX2 static void ConvertToInt16_AVX2(int16* dst, const float* src, uint32 count)
+	{
+		const __m256 scale = _mm256_set1_ps((float)0x7FFF);
+		const __m256 lo = _mm256_set1_ps(-1.f);
+		const __m256 hi = _mm256_set1_ps(1.f);
+		uint32 i = 0;
+		for(; i + 8 <= count; i += 8)
+		{
+			__m256 v = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(src + i), lo), hi);
+			__m256i iv = _mm256_cvttps_epi32(_mm256_mul_ps(v, scale));
+			// 256 bit packs work per 128 bit lane, so pack the two halves instead
+			__m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(iv), _mm256_extracti128_si256(iv, 1));
+			_mm_storeu_si128((__m128i*)(dst + i), packed);
+		}
+		ConvertToInt16_Scalar(dst + i, src + i, count - i);
+	}
+#endif
+
+	struct KernelTable
+	{
+		void(*mixGain)(float*, const float*, float, uint32);
+		void(*convertToInt16)(int16*, const float*, uint32);
+		void(*biquad)(float*, uint32, BiquadState&, const BiquadCoefficients&, const BiquadCoefficients&);
+		float(*peakAbs)(const float*, uint32);
+		void(*gainRampClamp)(float*, const float*, float, float, float, uint32);
+	};
+	static KernelTable SelectKernels(Path path)
+	{
+#ifdef AUDIO_KERNELS_X86
+		if(path == Path::AVX2)
+			return { &MixGain_AVX2, &ConvertToInt16_AVX2, &Biquad_SSE2, &PeakAbs_AVX2, &GainRampClamp_AVX2 };
+		if(path == Path::SSE2)
+			return { &MixGain_SSE2, &ConvertToInt16_SSE2, &Biquad_SSE2, &PeakAbs_SSE2, &GainRampClamp_SSE2 };
+#endif
+		return { &MixGain_Scalar, &ConvertToInt16_Scalar, &Biquad_Scalar, &PeakAbs_Scalar, &GainRampClamp_Scalar };
+	}
+	static Path DetectPath()
+	{
+#ifdef AUDIO_KERNELS_X86
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if(info[0] >= 7)
+		{
+			__cpuid(info, 1);
+			bool osxsave = (info[2] & (1 << 27)) != 0;
+			__cpuidex(info, 7, 0);
+			bool avx2 = (info[1] & (1 << 5)) != 0;
+			// Make sure the OS saves the AVX registers
+			if(osxsave && avx2 && (_xgetbv(0) & 0x6) == 0x6)
+				return Path::AVX2;
+		}
+#else
+		if(__builtin_cpu_supports("avx2"))
+			return Path::AVX2;
+#endif
+		return Path::SSE2;
+#else
+		return Path::Scalar;
+#endif
+	}
+
+	static const Path g_supportedPath = DetectPath();
+	static Path g_activePath = g_supportedPath;
+	static KernelTable g_kernels = SelectKernels(g_supportedPath);
+
+	Path GetSupportedPath()
+	{
+		return g_supportedPath;
+	}
+	Path GetActivePath()
+	{
+		return g_activePath;
+	}
+	void SetActivePath(Path path)
+	{
+		if((uint8)path > (uint8)g_supportedPath)
+			path = g_supportedPath;
+		g_activePath = path;
+		g_kernels = SelectKernels(path);
+	}
+	const char* GetPathName(Path path)
+	{
+		switch(path)
+		{
+		case Path::AVX2:
+			return "AVX2";
+		case Path::SSE2:
+			return "SSE2";
+		default:
+			return "Scalar";
+		}
+	}
+
+	void MixGain(float* dst, const float* src, float gain, uint32 count)
+	{
+		g_kernels.mixGain(dst, src, gain, count);
+	}
+	void ConvertToInt16(int16* dst, const float* src, uint32 count)
+	{
+		g_kernels.convertToInt16(dst, src, count);
+	}
+	float PeakAbs(const float* src, uint32 count)
+	{
+		return g_kernels.peakAbs(src, count);
+	}
+	void GainRampClamp(float* dst, const float* src, float gain, float step, float limit, uint32 numSamples)
+	{
+		g_kernels.gainRampClamp(dst, src, gain, step, limit, numSamples);
+	}
+	void Biquad(float* buf, uint32 numSamples, BiquadState& state, const BiquadCoefficients& from, const BiquadCoefficients& to)
+	{
+		if(numSamples == 0)
+			return;
+		// Calculated once here so all paths step the coefficients identically
+		BiquadCoefficients delta;
+		const float invLength = 1.0f / (float)numSamples;
+		delta.b0 = (to.b0 - from.b0) * invLength;
+		delta.b1 = (to.b1 - from.b1) * invLength;
+		delta.b2 = (to.b2 - from.b2) * invLength;
+		delta.a1 = (to.a1 - from.a1) * invLength;
+		delta.a2 = (to.a2 - from.a2) * invLength;
+		g_kernels.biquad(buf, numSamples, state, from, delta);
+	}
+}
@@ -99,7 +99,17 @@ double AudioStreamBase::m_getPositionSeconds(bool allowFreezeSkip /*= true*/) co
 }
 int32 AudioStreamBase::GetPosition() const
 {
-	return (int32)(m_getPositionSeconds() * 1000.0);
+	return (int32)(GetPositionSeconds() * 1000.0);
+}
+int64 AudioStreamBase::GetSamplePosition() const
+{
+	// Unlike GetPosition this is not smoothed with the stream timer, the mixer needs the exact position of the decoded samples
+	return m_samplePos * (int64)m_audio->GetSampleRate() / const_cast<AudioStreamBase*>(this)->GetStreamRate_Internal();
+}
+double AudioStreamBase::GetPositionSeconds() const
+{
+	// What is heard lags behind the stream position by the latency of the DSPs
+	return m_getPositionSeconds() - (double)DSPLatency / (double)m_audio->GetSampleRate();
 }
 void AudioStreamBase::SetPosition(int32 pos)
 {
@@ -67,6 +67,8 @@ public:
 	virtual bool HasEnded() const override;
 	double SamplesToSeconds(int64 s) const;
 	virtual int32 GetPosition() const override;
+	virtual int64 GetSamplePosition() const override;
+	virtual double GetPositionSeconds() const override;
 	virtual void SetPosition(int32 pos) override;
 	virtual float* GetPCM() override;
 	virtual uint32 GetSampleRate() const override;
@@ -3,10 +3,19 @@
 #include <vorbis/vorbisfile.h>
 
 
+// Amount of audio decoded before a preloaded stream is returned, the rest is decoded in the background
+static const double preloadPrefixSeconds = 2.0;
+
 AudioStreamOgg::~AudioStreamOgg()
 {
 	Deregister();
 
+	if(m_decodeThread.joinable())
+	{
+		m_stopDecoding = true;
+		m_decodeThread.join();
+	}
+
 	for (size_t i = 0; i < m_numChannels; i++)
 	{
 		delete[] m_readBuffer[i];
@@ -45,45 +54,102 @@ bool AudioStreamOgg::Init(Audio* audio, const String& path, bool preload)
 
 	if (preload)
 	{
-		float** readBuffer;
-		int r;
-		int totalRead = 0;
-		while (true)
+		m_playPos = 0;
+		int64 total = ov_pcm_total(&m_ovf, -1);
+		if(total > 0)
 		{
-			r = ov_read_float(&m_ovf, &readBuffer, 1024, 0);
-			if (r < 0)
-				continue;
-			if (r == 0)
-				break;
+			m_pcm.resize((size_t)total * 2);
+			m_samplesTotal = total;
+
+			// Playback can start as soon as the first part is decoded
+			if(m_Decode((int64)(preloadPrefixSeconds * m_info.rate), false))
+			{
+				m_decodeThread = Thread(&AudioStreamOgg::m_DecodeRemaining, this, total);
+			}
 			else
 			{
-				if (m_info.channels == 2)
-				{
-					for (size_t i = 0; i < r; i++)
-					{
-						m_pcm.Add(readBuffer[0][i]);
-						m_pcm.Add(readBuffer[1][i]);
-					}
-				}
-				else if (m_info.channels == 1)
-				{
-					for (size_t i = 0; i < r; i++)
-					{
-						m_pcm.Add(readBuffer[0][i]);
-						m_pcm.Add(readBuffer[0][i]);
-					}
-				}
-				totalRead += r;
+				m_FinishDecoding();
 			}
 		}
-		m_samplesTotal = totalRead;
-		ov_clear(&m_ovf);
-		m_playPos = 0;
+		else
+		{
+			// Unknown length, decode everything now
+			m_Decode(INT64_MAX, true);
+			m_FinishDecoding();
+		}
+		m_UpdateSamplesTotal();
 	}
 	m_initSampling(m_info.rate);
 	return true;
 }
 
+bool AudioStreamOgg::m_Decode(int64 numSamples, bool canGrow)
+{
+	// Only written by the thread that is decoding
+	int64 decoded = m_decodedSamples;
+	while(decoded < numSamples)
+	{
+		if(m_stopDecoding)
+			return false;
+
+		float** readBuffer;
+		int32 r = ov_read_float(&m_ovf, &readBuffer, 4096, 0);
+		if(r == OV_HOLE)
+			continue;
+		if(r <= 0)
+			return false;
+
+		int64 capacity = (int64)m_pcm.size() / 2;
+		if(decoded + r > capacity)
+		{
+			if(canGrow)
+			{
+				m_pcm.resize((size_t)Math::Max(capacity * 2, decoded + r) * 2);
+			}
+			else
+			{
+				// Stream is longer than reported
+				r = (int32)(capacity - decoded);
+				if(r <= 0)
+					return false;
+			}
+		}
+
+		float* dst = m_pcm.data() + decoded * 2;
+		const float* left = readBuffer[0];
+		const float* right = m_info.channels == 1 ? readBuffer[0] : readBuffer[1];
+		for(int32 i = 0; i < r; i++)
+		{
+			dst[i * 2] = left[i];
+			dst[i * 2 + 1] = right[i];
+		}
+		decoded += r;
+		m_decodedSamples.store(decoded, std::memory_order_release);
+	}
+	return true;
+}
+void AudioStreamOgg::m_DecodeRemaining(int64 total)
+{
+	m_Decode(total, false);
+	m_FinishDecoding();
+}
+void AudioStreamOgg::m_FinishDecoding()
+{
+	ov_clear(&m_ovf);
+
+	// The compressed data is no longer needed
+	m_data.clear();
+	m_data.shrink_to_fit();
+
+	m_decodedLength.store(m_decodedSamples.load(std::memory_order_relaxed), std::memory_order_release);
+}
+void AudioStreamOgg::m_UpdateSamplesTotal()
+{
+	int64 length = m_decodedLength.load(std::memory_order_acquire);
+	if(length >= 0 && (uint64)length != m_samplesTotal)
+		m_samplesTotal = length;
+}
+
 void AudioStreamOgg::SetPosition_Internal(int32 pos)
 {
 	if (m_preloaded)
@@ -127,9 +193,12 @@ int32 AudioStreamOgg::DecodeData_Internal()
 {
 	if (m_preloaded)
 	{
+		m_UpdateSamplesTotal();
+
 		uint32 samplesPerRead = 128;
 		int32 retVal = samplesPerRead;
 		bool earlyOut = false;
+		const int64 decoded = m_decodedSamples.load(std::memory_order_acquire);
 		for (size_t i = 0; i < samplesPerRead; i++)
 		{
 			if (m_playPos < 0)
@@ -139,6 +208,13 @@ int32 AudioStreamOgg::DecodeData_Internal()
 				m_playPos++;
 				continue;
 			}
+			else if (m_playPos >= decoded && m_playPos < m_samplesTotal)
+			{
+				// Background decoding has not reached this point yet, wait for it
+				m_readBuffer[0][i] = 0;
+				m_readBuffer[1][i] = 0;
+				continue;
+			}
 			else if (m_playPos >= m_samplesTotal)
 			{
 				m_currentBufferSize = m_bufferSize;
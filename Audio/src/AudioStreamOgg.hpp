@@ -2,6 +2,8 @@
 #include "stdafx.h"
 #include "AudioStreamBase.hpp"
 #include <vorbis/vorbisfile.h>
+#include <Shared/Thread.hpp>
+#include <atomic>
 
 class AudioStreamOgg : public AudioStreamBase
 {
@@ -11,6 +13,15 @@ protected:
 	Vector<float> m_pcm;
 	int64 m_playPos;
 
+	// Preloaded streams are decoded in the background after the first part is decoded by Init
+	//	m_pcm is allocated for the whole stream up front, so it never moves while this thread fills it
+	Thread m_decodeThread;
+	std::atomic<int64> m_decodedSamples = { 0 };
+	// Length of the stream once it is fully decoded, -1 until then
+	//	m_samplesTotal is only updated from this by the thread that plays the stream
+	std::atomic<int64> m_decodedLength = { -1 };
+	std::atomic<bool> m_stopDecoding = { false };
+
 	AudioStreamOgg() = default;
 	~AudioStreamOgg();
 	bool Init(Audio* audio, const String& path, bool preload) override;
@@ -21,6 +32,16 @@ protected:
 	uint32 GetSampleRate_Internal() const override;
 	int32 DecodeData_Internal() override;
 private:
+	// Decodes into m_pcm until at least numSamples have been decoded, returns false once the stream ended
+	//	m_pcm is only grown when canGrow is set, otherwise anything past its size is dropped
+	bool m_Decode(int64 numSamples, bool canGrow);
+	// Decodes the rest of a preloaded stream, runs on m_decodeThread
+	void m_DecodeRemaining(int64 total);
+	// Releases the decoder and compressed data after the whole stream has been decoded and publishes the decoded length
+	void m_FinishDecoding();
+	// Applies the decoded length to m_samplesTotal once it is known, called with m_lock held or before the stream is shared
+	void m_UpdateSamplesTotal();
+
 	static size_t m_Read(void* ptr, size_t size, size_t nmemb, AudioStreamOgg* self);
 	static int m_Seek(AudioStreamOgg* self, int64 offset, int whence);
 	static long m_Tell(AudioStreamOgg* self);
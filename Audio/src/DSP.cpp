@@ -2,6 +2,7 @@
 #include "DSP.hpp"
 #include "AudioOutput.hpp"
 #include "Audio_Impl.hpp"
+#include "Audio.hpp"
 #include <Shared/Interpolation.hpp>
 
 void PanDSP::Process(float* out, uint32 numSamples)
@@ -17,48 +18,49 @@ void PanDSP::Process(float* out, uint32 numSamples)
 
 void BQFDSP::Process(float* out, uint32 numSamples)
 {
-	for(uint32 c = 0; c < 2; c++)
-	{
-		for(uint32 i = 0; i < numSamples; i++)
-		{
-			float& sample = out[i * 2 + c];
-			float src = sample;
-
-			float filtered = 
-				(b0 / a0) * src + 
-				(b1 / a0) * zb[c][0] + 
-				(b2 / a0) * zb[c][1] - 
-				(a1 / a0) * za[c][0] - 
-				(a2 / a0) * za[c][1];
-
-			// Shift delay buffers
-			zb[c][1] = zb[c][0];
-			zb[c][0] = src;
-
-			// Feedback the calculated value into the IIR delay buffers
-			za[c][1] = za[c][0];
-			za[c][0] = filtered;
+	AudioKernels::Biquad(out, numSamples, m_state, m_current, m_target);
+	m_current = m_target;
+}
+bool BQFDSP::m_SetParameters(FilterType type, float q, float freq, float gain, float sampleRate)
+{
+	// Effects set their parameters every tick, most of the time without changing them
+	if(m_type == type && m_q == q && m_freq == freq && m_gain == gain && m_sampleRate == sampleRate)
+		return false;
+	m_type = type;
+	m_q = q;
+	m_freq = freq;
+	m_gain = gain;
+	m_sampleRate = sampleRate;
+	return true;
+}
+void BQFDSP::m_SetCoefficients(double b0, double b1, double b2, double a0, double a1, double a2)
+{
+	m_target.b0 = (float)(b0 / a0);
+	m_target.b1 = (float)(b1 / a0);
+	m_target.b2 = (float)(b2 / a0);
+	m_target.a1 = (float)(a1 / a0);
+	m_target.a2 = (float)(a2 / a0);
 
-			sample = filtered;
-		}
+	// Don't fade in from the initial pass-through state
+	if(!m_hasCoefficients)
+	{
+		m_current = m_target;
+		m_hasCoefficients = true;
 	}
 }
 void BQFDSP::SetLowPass(float q, float freq, float sampleRate)
 {
 	// Limit q
 	q = Math::Max(q, 0.01f);
+	if(!m_SetParameters(FilterType::LowPass, q, freq, 0.0f, sampleRate))
+		return;
 
 	// Sampling frequency
 	double w0 = (2 * Math::pi * freq) / sampleRate;
 	double cw0 = cos(w0);
-	float alpha = (float)(sin(w0) / (2 * q));
+	double alpha = sin(w0) / (2 * q);
 
-	b0 = (float)((1 - cw0) / 2);
-	b1 = (float)(1 - cw0);
-	b2 = (float)((1 - cw0) / 2);
-	a0 = 1 + alpha;
-	a1 = (float)(-2 * cw0);
-	a2 = 1 - alpha;
+	m_SetCoefficients((1 - cw0) / 2, 1 - cw0, (1 - cw0) / 2, 1 + alpha, -2 * cw0, 1 - alpha);
 }
 void BQFDSP::SetLowPass(float q, float freq)
 {
@@ -68,18 +70,15 @@ void BQFDSP::SetHighPass(float q, float freq, float sampleRate)
 {
 	// Limit q
 	q = Math::Max(q, 0.01f);
+	if(!m_SetParameters(FilterType::HighPass, q, freq, 0.0f, sampleRate))
+		return;
 
 	assert(freq < sampleRate);
 	double w0 = (2 * Math::pi * freq) / sampleRate;
 	double cw0 = cos(w0);
-	float alpha = (float)(sin(w0) / (2 * q));
+	double alpha = sin(w0) / (2 * q);
 
-	b0 = (float)((1 + cw0) / 2);
-	b1 = (float)-(1 + cw0);
-	b2 = float((1 + cw0) / 2);
-	a0 = 1 + alpha;
-	a1 = (float)(-2 * cw0);
-	a2 = 1 - alpha;
+	m_SetCoefficients((1 + cw0) / 2, -(1 + cw0), (1 + cw0) / 2, 1 + alpha, -2 * cw0, 1 - alpha);
 }
 void BQFDSP::SetHighPass(float q, float freq)
 {
@@ -89,52 +88,78 @@ void BQFDSP::SetPeaking(float q, float freq, float gain, float sampleRate)
 {
 	// Limit q
 	q = Math::Max(q, 0.01f);
+	if(!m_SetParameters(FilterType::Peaking, q, freq, gain, sampleRate))
+		return;
 
 	double w0 = (2 * Math::pi * freq) / sampleRate;
 	double cw0 = cos(w0);
-	float alpha = (float)(sin(w0) / (2 * q));
+	double alpha = sin(w0) / (2 * q);
 	double A = pow(10, (gain / 40));
 
-	b0 = 1 + (float)(alpha * A);
-	b1 = -2 * (float)cw0;
-	b2 = 1 - (float)(alpha*A);
-	a0 = 1 + (float)(alpha / A);
-	a1 = -2 * (float)cw0;
-	a2 = 1 - (float)(alpha / A);
+	m_SetCoefficients(1 + alpha * A, -2 * cw0, 1 - alpha * A, 1 + alpha / A, -2 * cw0, 1 - alpha / A);
 }
 void BQFDSP::SetPeaking(float q, float freq, float gain)
 {
 	SetPeaking(q, freq, gain, (float)audio->GetSampleRate());
 }
 
+LimiterDSP::LimiterDSP()
+{
+	memset(m_chunks, 0, sizeof(m_chunks));
+}
+float LimiterDSP::m_TargetGain(float peak) const
+{
+	peak *= gain;
+	if(peak <= ceiling)
+		return 1.0f;
+	return ceiling / peak;
+}
 void LimiterDSP::Process(float* out, uint32 numSamples)
 {
-	float secondsPerSample = (float)audio->GetSecondsPerSample();
-	for(uint32 i = 0; i < numSamples; i++)
+	// Fraction of the remaining gain reduction to recover per chunk
+	const float release = 1.0f - (float)exp(-(double)chunkLength / (releaseTime * (double)audio->GetSampleRate()));
+
+	float delayed[chunkLength * 2];
+	uint32 i = 0;
+	while(i < numSamples)
 	{
-		float currentGain = 1.0f;
-		if(m_currentReleaseTimer < releaseTime)
-		{
-			float t = (1.0f - m_currentReleaseTimer / releaseTime);
-			currentGain = (1.0f / m_currentMaxVolume) * t + (1.0f - t);
-		}
-	
-		float maxVolume = Math::Max(abs(out[i*2]), abs(out[i * 2 + 1]));
-		out[i * 2] *= currentGain * 0.9f;
-		out[i * 2 + 1] *= currentGain * 0.9f;
-	
-		float currentMax = 1.0f / currentGain;
-		if(maxVolume > currentMax)
+		if(m_position == 0)
 		{
-			m_currentMaxVolume = maxVolume;
-			m_currentReleaseTimer = 0.0f;
+			// Ramp the gain so that it is low enough for both this chunk and the start of the next one
+			float target = Math::Min(m_TargetGain(m_peaks[m_outputChunk]), m_TargetGain(m_peaks[1 - m_outputChunk]));
+			float end = target;
+			if(target > m_currentGain)
+				end = Math::Min(target, m_currentGain + (1.0f - m_currentGain) * release);
+			m_gainStep = (end - m_currentGain) / (float)chunkLength;
 		}
-		else
+
+		uint32 count = Math::Min(numSamples - i, chunkLength - m_position);
+		float* block = out + i * 2;
+		float* chunk = m_chunks[m_outputChunk] + m_position * 2;
+
+		// Swap the input with the delayed samples
+		m_inputPeak = Math::Max(m_inputPeak, AudioKernels::PeakAbs(block, count * 2));
+		float startGain = m_currentGain + m_gainStep * (float)m_position;
+		AudioKernels::GainRampClamp(delayed, chunk, startGain * gain, m_gainStep * gain, ceiling, count);
+		memcpy(chunk, block, count * 2 * sizeof(float));
+		memcpy(block, delayed, count * 2 * sizeof(float));
+
+		m_position += count;
+		i += count;
+		if(m_position == chunkLength)
 		{
-			m_currentReleaseTimer += secondsPerSample;
+			m_currentGain += m_gainStep * (float)chunkLength;
+			m_peaks[m_outputChunk] = m_inputPeak;
+			m_inputPeak = 0.0f;
+			m_outputChunk = 1 - m_outputChunk;
+			m_position = 0;
 		}
 	}
 }
+uint32 LimiterDSP::GetLatency() const
+{
+	return chunkLength * 2;
+}
 
 void BitCrusherDSP::SetPeriod(float period /*= 0*/)
 {
@@ -183,15 +208,8 @@ void GateDSP::Process(float* out, uint32 numSamples)
 	if(m_length < 2)
 		return;
 
-	int32 startSample = startTime * audio->GetSampleRate() / 1000.0;
-	int32 currentSample = audioBase->GetPosition() * audio->GetSampleRate() / 1000.0;
-
-	for(uint32 i = 0; i < numSamples; i++)
+	for(uint32 i = m_GetStartOffset(numSamples); i < numSamples; i++)
 	{
-		if(currentSample + i < startSample)
-		{
-			continue;
-		}
 		float c = 1.0f;
 		if(m_currentSample < m_halfway)
 		{
@@ -230,15 +248,8 @@ void TapeStopDSP::SetLength(double length)
 }
 void TapeStopDSP::Process(float* out, uint32 numSamples)
 {
-	int32 startSample = startTime * audio->GetSampleRate() / 1000.0;
-	int32 currentSample = audioBase->GetPosition() * audio->GetSampleRate() / 1000.0;
-
-	for(uint32 i = 0; i < numSamples; i++)
+	for(uint32 i = m_GetStartOffset(numSamples); i < numSamples; i++)
 	{
-		if(currentSample + i < startSample)
-		{
-			continue;
-		}
 		float sampleRate = 1.0f - (float)m_currentSample / (float)m_length;
 		if(sampleRate == 0.0f)
 		{
@@ -299,19 +310,14 @@ void RetriggerDSP::Process(float* out, uint32 numSamples)
 
 	///TODO: Clean up casting
 	int32 startSample = (double)startTime * ((double)audio->GetSampleRate() / 1000.0);
-	int32 nowSample = (double)audioBase->GetPosition() * ((double)audio->GetSampleRate() / 1000.0);
+	int32 nowSample = (int32)blockStartSample;
 	float* pcmSource = audioBase->GetPCM();
 	double rateMult = (double)audioBase->GetSampleRate() / audio->GetSampleRate();
 	int32 pcmStartSample = (double)lastTimingPoint * ((double)audioBase->GetSampleRate() / 1000.0);
 	int32 baseStartRepeat = (double)lastTimingPoint * ((double)audio->GetSampleRate() / 1000.0);
 
-	for(uint32 i = 0; i < numSamples; i++)
+	for(uint32 i = m_GetStartOffset(numSamples); i < numSamples; i++)
 	{
-		if(nowSample + i < startSample)
-		{
-			continue;
-		}
-
 		int startOffset = 0;
 		if (m_resetDuration > 0)
 		{
@@ -348,31 +354,33 @@ void WobbleDSP::Process(float* out, uint32 numSamples)
 		return;
 
 	static Interpolation::CubicBezier easing(Interpolation::EaseInExpo);
-	int32 startSample = startTime * audio->GetSampleRate() / 1000.0;
-	int32 currentSample = audioBase->GetPosition() * audio->GetSampleRate() / 1000.0;
+	uint32 i = m_GetStartOffset(numSamples);
 
-	for(uint32 i = 0; i < numSamples; i++)
+	// The filter frequency is updated every few samples, the filter interpolates the coefficients in between
+	const uint32 updateInterval = 32;
+	float dry[updateInterval * 2];
+	while(i < numSamples)
 	{
-		if(currentSample + i < startSample)
-		{
-			continue;
-		}
+		uint32 count = Math::Min(numSamples - i, updateInterval);
+
+		// Sampled at the start of the block
 		float f = abs(2.0f * ((float)m_currentSample / (float)m_length) - 1.0f);
 		f = easing.Sample(f);
 		float freq = fmin + (fmax - fmin) * f;
 		SetLowPass(q, freq);
+		m_currentSample = (m_currentSample + count) % m_length;
 
-		float s[2] = { out[i * 2], out[i * 2 + 1] };
-
-		BQFDSP::Process(&out[i * 2], 1);
+		float* block = &out[i * 2];
+		memcpy(dry, block, count * 2 * sizeof(float));
+		BQFDSP::Process(block, count);
 
 		// Apply slight mixing
 		float mix = 0.5f;
-		out[i * 2 + 0] = out[i * 2 + 0] * mix + s[0] * (1.0f - mix);
-		out[i * 2 + 1] = out[i * 2 + 1] * mix + s[1] * (1.0f - mix);
-
-		m_currentSample++;
-		m_currentSample %= m_length;
+		for(uint32 j = 0; j < count * 2; j++)
+		{
+			block[j] = block[j] * mix + dry[j] * (1.0f - mix);
+		}
+		i += count;
 	}
 }
 
@@ -386,15 +394,8 @@ void PhaserDSP::Process(float* out, uint32 numSamples)
 	if (m_length == 0)
 		return;
 
-	int32 startSample = startTime * audio->GetSampleRate() / 1000.0;
-	int32 currentSample = audioBase->GetPosition() * audio->GetSampleRate() / 1000.0;
-
-	for(uint32 i = 0; i < numSamples; i++)
+	for(uint32 i = m_GetStartOffset(numSamples); i < numSamples; i++)
 	{
-		if(currentSample + i < startSample)
-		{
-			continue;
-		}
 		//float f = ((float)time / (float)m_length) * Math::pi * 2.0f;
 		float f = abs(2.0f * ((float)time / (float)m_length) - 1.0f);
 
@@ -459,15 +460,8 @@ void FlangerDSP::Process(float* out, uint32 numSamples)
 	if(m_bufferLength <= 0)
 		return;
 
-	int32 startSample = startTime * audio->GetSampleRate() / 1000.0;
-	int32 currentSample = audioBase->GetPosition() * audio->GetSampleRate() / 1000.0;
-
-	for(uint32 i = 0; i < numSamples; i++)
+	for(uint32 i = m_GetStartOffset(numSamples); i < numSamples; i++)
 	{
-		if(currentSample + i < startSample)
-		{
-			continue;
-		}
 		// Determine where we want to sample past samples
 		float f =  fmodf(((float)m_time / (float)m_length), 1.f);
 		f = fabsf(f * 2 - 1);
@@ -509,16 +503,8 @@ void EchoDSP::Process(float* out, uint32 numSamples)
 	float* data = m_sampleBuffer.data();
 	if (!data)
 		return;
-	int32 startSample = startTime * audio->GetSampleRate() / 1000.0;
-	int32 currentSample = audioBase->GetPosition() * audio->GetSampleRate() / 1000.0;
-
-	for(uint32 i = 0; i < numSamples; i++)
+	for(uint32 i = m_GetStartOffset(numSamples); i < numSamples; i++)
 	{
-		if(currentSample + i < startSample)
-		{
-			continue;
-		}
-
 		float l0 = data[m_bufferOffset + 0];
 		float l1 = data[m_bufferOffset + 1];
 
@@ -553,15 +539,8 @@ void SidechainDSP::Process(float* out, uint32 numSamples)
 	if(m_length == 0)
 		return;
 
-	int32 startSample = startTime * audio->GetSampleRate() / 1000.0;
-	int32 currentSample = audioBase->GetPosition() * audio->GetSampleRate() / 1000.0;
-
-	for(uint32 i = 0; i < numSamples; i++)
+	for(uint32 i = m_GetStartOffset(numSamples); i < numSamples; i++)
 	{
-		if(currentSample + i < startSample)
-		{
-			continue;
-		}
 		float r = (float)m_time / (float)m_length;
 		// FadeIn
 		const float fadeIn = 0.08f;
@@ -607,10 +586,20 @@ class PitchShiftDSP_Impl
 public:
 	float pitch = 0.0f;
 	bool init = false;
+	// Delay between input and output in samples, both for the dry and the pitch shifted signal
+	uint32 latency = 0;
 
 private:
 	SoundTouch m_soundtouch;
-	Vector<float> m_receiveBuffer;
+	float m_currentPitch = 0.0f;
+	// Pitch shifted samples that are waiting to be output, allocated once in Init
+	Vector<float> m_outputBuffer;
+	uint32 m_outputCapacity = 0;
+	uint32 m_outputCount = 0;
+	DelayDSP m_dryDelay;
+
+	// Worst case of how far SoundTouch output lags behind the input, on top of one mixer block
+	static constexpr double maxProcessingDelay = 0.04;
 
 public:
 	PitchShiftDSP_Impl()
@@ -627,23 +616,51 @@ public:
 		m_soundtouch.setSetting(SETTING_SEQUENCE_MS, 5);
 		//m_soundtouch.setSetting(SETTING_SEEKWINDOW_MS, 10);
 		//m_soundtouch.setSetting(SETTING_OVERLAP_MS, 10);
+		m_soundtouch.setPitchSemiTones(pitch);
+		m_currentPitch = pitch;
+
+		// Output is always delayed by a fixed amount, so that SoundTouch never runs out of samples to return
+		// the output buffer starts out with that many samples of silence, every sample that goes in comes out latency samples later
+		const uint32 blockSize = audio->m_sampleBufferLength;
+		latency = (uint32)(audio->GetSampleRate() * maxProcessingDelay) + blockSize;
+		m_outputCapacity = latency * 2 + blockSize;
+		m_outputBuffer.resize(m_outputCapacity * 2);
+		m_outputCount = latency;
+		m_dryDelay.SetDelay(latency);
+		init = true;
 	}
-	void Process(float* out, uint32 numSamples)
+	void Process(float* out, uint32 numSamples, float mix)
 	{
-		m_receiveBuffer.resize(numSamples*2);
-		m_soundtouch.setPitchSemiTones(pitch);
-		m_soundtouch.putSamples(out, numSamples);
-		uint32 receivedSamples = m_soundtouch.receiveSamples(m_receiveBuffer.data(), numSamples);
-		if(receivedSamples > 0)
+		if(pitch != m_currentPitch)
 		{
-			memcpy(out, m_receiveBuffer.data(), receivedSamples * sizeof(float) * 2);
+			m_soundtouch.setPitchSemiTones(pitch);
+			m_currentPitch = pitch;
 		}
+
+		// SoundTouch keeps running while the mix is 0, so the shifted signal stays in sync when it is mixed in again
+		m_soundtouch.putSamples(out, numSamples);
+		m_outputCount += m_soundtouch.receiveSamples(m_outputBuffer.data() + m_outputCount * 2, m_outputCapacity - m_outputCount);
+
+		// Mix with the dry signal, delayed by the same amount
+		m_dryDelay.Process(out, numSamples);
+		uint32 available = Math::Min(m_outputCount, numSamples);
+		const float* shifted = m_outputBuffer.data();
+		for(uint32 i = 0; i < available * 2; i++)
+			out[i] = out[i] * (1.0f - mix) + shifted[i] * mix;
+		// This should not run out but fall back to silence for the shifted signal if it does
+		for(uint32 i = available * 2; i < numSamples * 2; i++)
+			out[i] *= 1.0f - mix;
+		m_outputCount -= available;
+		memmove(m_outputBuffer.data(), m_outputBuffer.data() + available * 2, m_outputCount * sizeof(float) * 2);
 	}
 };
 
 PitchShiftDSP::PitchShiftDSP()
 {
 	m_impl = new PitchShiftDSP_Impl();
+	// Allocate everything here, instead of on the audio thread
+	if(g_audio)
+		m_impl->Init(g_audio->GetImpl());
 }
 PitchShiftDSP::~PitchShiftDSP()
 {
@@ -654,5 +671,34 @@ void PitchShiftDSP::Process(float* out, uint32 numSamples)
 	m_impl->pitch = amount;
 	if(!m_impl->init)
 		m_impl->Init(audio);
-	m_impl->Process(out, numSamples);
+	m_impl->Process(out, numSamples, mix);
+}
+uint32 PitchShiftDSP::GetLatency() const
+{
+	return m_impl->latency;
+}
+
+void DelayDSP::SetDelay(uint32 numSamples)
+{
+	m_delay = numSamples;
+	m_position = 0;
+	m_buffer.resize(numSamples * 2);
+	memset(m_buffer.data(), 0, m_buffer.size() * sizeof(float));
+}
+void DelayDSP::Process(float* out, uint32 numSamples)
+{
+	if(m_delay == 0)
+		return;
+	// Swap every sample with the one that was written m_delay samples ago
+	for(uint32 i = 0; i < numSamples; i++)
+	{
+		float* delayed = &m_buffer[m_position * 2];
+		std::swap(out[i * 2], delayed[0]);
+		std::swap(out[i * 2 + 1], delayed[1]);
+		m_position = (m_position + 1) % m_delay;
+	}
+}
+uint32 DelayDSP::GetLatency() const
+{
+	return m_delay;
 }
@@ -18,12 +18,13 @@ public:
 	Audio* m_audio;
 	float* m_pcm = nullptr;
 
-	mutex m_lock;
+	// Play/Stop only set flags that are picked up by the mixer, so they never block the audio thread
+	std::atomic<bool> m_restart = { false };
+	std::atomic<bool> m_playing = { false };
+	std::atomic<bool> m_looping = { false };
 
 	uint64 m_playbackPointer = 0;
 	uint64 m_length = 0;
-	bool m_playing = false;
-	bool m_looping = false;
 
 public:
 	~Sample_Impl()
@@ -36,18 +37,14 @@ public:
 	}
 	virtual void Play(bool looping) override
 	{
-		m_lock.lock();
-		m_playing = true;
-		m_playbackPointer = 0;
 		m_looping = looping;
-		m_lock.unlock();	
+		m_restart = true;
+		m_playing = true;
 	}
 	virtual void Stop() override
 	{
-		m_lock.lock();
 		m_playing = false;
 		m_looping = false;
-		m_lock.unlock();
 	}
 	bool Init(const String& path)
 	{
@@ -66,7 +63,8 @@ public:
 		if(!m_playing)
 			return;
 
-		m_lock.lock();
+		if(m_restart.exchange(false))
+			m_playbackPointer = 0;
 
 		for(uint32 i = 0; i < numSamples; i++)
 		{
@@ -88,7 +86,6 @@ public:
 			out[i * 2 + 1] = m_pcm[m_playbackPointer * 2 + 1];
 			m_playbackPointer++;
 		}
-		m_lock.unlock();
 	}
 	const Buffer& GetData() const
 	{
@@ -1,6 +1,7 @@
 #pragma once
 #include "BeatmapObjects.hpp"
 #include "AudioEffects.hpp"
+#include "Shared/MemoryArena.hpp"
 
 /* Global settings stored in a beatmap */
 struct BeatmapSettings
@@ -93,9 +94,19 @@ public:
 	// Retrieves audio effect settings for a given filter effect id
 	AudioEffect GetFilter(EffectType type) const;
 
+	// Size of the memory holding all objects and control points of this map
+	size_t GetObjectMemoryUsage() const;
+
 private:
 	bool m_ProcessKShootMap(BinaryStream& input, bool metadataOnly);
 	bool m_Serialize(BinaryStream& stream, bool metadataOnly);
+	// Moves all objects into a new arena so each list is stored contiguously in time order
+	void m_CompactObjects();
+	// Sets the overlapsFXChip flag on all BT chips
+	void m_FindFXChipOverlaps();
+
+	// All objects, timing points and control points of the map are allocated from here
+	MemoryArena m_arena;
 
 	Map<EffectType, AudioEffect> m_customEffects;
 	Map<EffectType, AudioEffect> m_customFilters;
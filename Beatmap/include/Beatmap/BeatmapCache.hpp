@@ -0,0 +1,30 @@
+#pragma once
+#include "Beatmap.hpp"
+
+/*
+	On-disk cache of charts in the binary map format, which loads a lot faster than parsing KSH charts
+	cache entries are named after the chart's path and are only used while the chart's last write time matches,
+	the same write time that is stored in the map database (DifficultyIndex::lwt)
+*/
+class BeatmapCache
+{
+public:
+	BeatmapCache(const String& folder);
+
+	// Folder used by the game and the map database
+	static String GetDefaultFolder();
+
+	// Loads a chart from the cache if it has an entry for this version of the chart, which marks the entry as recently used
+	// otherwise the chart is parsed and added to the cache
+	bool Load(const String& chartPath, uint64 chartWriteTime, Beatmap& map);
+	// Adds a chart that was already parsed, replaces the existing entry for the same chart
+	void Store(const String& chartPath, uint64 chartWriteTime, const Beatmap& map);
+	// Removes the least recently used entries until the cache takes up at most maxSize bytes
+	void Evict(uint64 maxSize);
+
+private:
+	String m_GetEntryPath(const String& chartPath) const;
+	bool m_LoadEntry(const String& entryPath, const String& chartPath, uint64 chartWriteTime, Beatmap& map);
+
+	String m_folder;
+};
@@ -108,6 +108,9 @@ struct ObjectTypeData_Button
 	// Does this button have a sound sample attached
 	bool hasSample = false;
 
+	// Set on BT chips that are at the same time as an FX chip on the same side, calculated when the map is loaded
+	bool overlapsFXChip = false;
+
 	// Index of the sound sample
 	uint8 sampleIndex = 0xFF;
 
@@ -242,8 +245,6 @@ struct ObjectTypeData_Event
 // Object state with union data member
 struct MultiObjectState
 {
-	static bool StaticSerialize(BinaryStream &stream, MultiObjectState *&out);
-
 	// Position in ms when this object appears
 	MapTime time;
 	// Type of this object, determines the size of this struct and which type its data is
@@ -272,8 +273,6 @@ typedef TObjectState<ObjectTypeData_Event> EventObjectState;
 // Map timing point
 struct TimingPoint
 {
-	static bool StaticSerialize(BinaryStream &stream, TimingPoint *&out);
-
 	double GetWholeNoteLength() const { return beatDuration * 4; }
 	double GetBarDuration() const { return GetWholeNoteLength() * ((double)numerator / (double)denominator); }
 	double GetBPM() const { return 60000.0 / beatDuration; }
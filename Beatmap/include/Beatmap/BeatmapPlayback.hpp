@@ -40,6 +40,22 @@ public:
 	// Duration for objects to keep being returned by GetObjectsInRange after they have passed the current time
 	MapTime keepObjectDuration = 1000;
 
+	// Kinds of visible objects, in the order they should be drawn
+	enum VisibleObjectGroup
+	{
+		FXHolds = 0,
+		BTHolds,
+		FXChips,
+		BTChips,
+		Lasers,
+		NumVisibleObjectGroups,
+	};
+	// Updates the visible objects to the ones between the current time and current time + range, and objects that have not passed yet
+	// objects are only added or removed at the edges of the range, so this is cheap to call every frame
+	void UpdateVisibleObjects(MapTime range);
+	// Visible objects of a single kind sorted by time, as of the last call to UpdateVisibleObjects
+	const Vector<ObjectState*>& GetVisibleObjects(VisibleObjectGroup group) const;
+
 	// Get the timing point at the current time
 	const TimingPoint& GetCurrentTimingPoint() const;
 	// Get the timing point at a given time
@@ -56,7 +72,8 @@ public:
 	uint32 CountBeats(MapTime start, MapTime range, int32& startIndex, uint32 multiplier = 1) const;
 
 	// View coordinate conversions
-	// the input duration is looped throught the timing points that affect it and the resulting float is the number of 4th note offets
+	// the resulting float is the number of 4th note offsets between the given times, chart stops don't add any distance
+	// these are looked up in a table that is built on Reset, so they only cost a binary search
 	MapTime ViewDistanceToDuration(float distance);
 	float DurationToViewDistance(MapTime time);
 	float DurationToViewDistanceAtTime(MapTime time, MapTime duration);
@@ -109,7 +126,17 @@ private:
 	LaneHideTogglePoint** m_SelectLaneTogglePoint(MapTime time, bool allowReset = false);
 	ObjectState** m_SelectHitObject(MapTime time, bool allowReset = false);
 	ZoomControlPoint** m_SelectZoomObject(MapTime time);
-	Vector<ChartStop*> m_SelectChartStops(MapTime time, MapTime duration);
+
+	// Builds the view distance sections from the current timing points and chart stops
+	void m_BuildViewDistanceSections();
+	// Index of the last view distance section that starts before or at the given time, 0 if there are none
+	size_t m_FindViewDistanceSection(MapTime time) const;
+	// Number of 4th notes from the start of the map to the given time
+	double m_TimeToViewDistance(MapTime time, bool withStops) const;
+
+	// Group an object is drawn in, NumVisibleObjectGroups for objects that are not drawn
+	static VisibleObjectGroup m_GetVisibleObjectGroup(ObjectState* obj);
+	void m_ClearVisibleObjects();
 
 	// End object pointer, this is not a valid pointer, but points to the element after the last element
 	bool IsEndTiming(TimingPoint** obj);
@@ -117,6 +144,20 @@ private:
 	bool IsEndLaneToggle(LaneHideTogglePoint ** obj);
 	bool IsEndZoomPoint(ZoomControlPoint** obj);
 
+	// Part of the map where the scroll speed is constant, a new one starts at every timing point, chart stop start and end
+	struct ViewDistanceSection
+	{
+		MapTime time;
+		// Number of 4th notes passed at the start of this section
+		double distance;
+		// Same as distance, but without pausing for chart stops
+		double distanceNoStops;
+		// 4th notes per ms in this section, 0 during chart stops
+		double rate;
+		double rateNoStops;
+	};
+	Vector<ViewDistanceSection> m_viewDistanceSections;
+
 	// Current map position of this playback object
 	MapTime m_playbackTime;
 	Vector<TimingPoint*> m_timingPoints;
@@ -144,6 +185,10 @@ private:
 	// Hold buttons with effects that are active
 	Set<ObjectState*> m_effectObjects;
 
+	Vector<ObjectState*> m_visibleObjects[NumVisibleObjectGroups];
+	// Index of the first object that has not been added to the visible objects yet
+	size_t m_nextVisibleObject = 0;
+
 	// Current state of events
 	Map<EventKey, EventData> m_eventMapping;
 
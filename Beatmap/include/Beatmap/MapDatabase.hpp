@@ -74,6 +74,10 @@ public:
 	void Update();
 
 	bool IsSearching() const;
+	// Charts found while searching are loaded on the jobs of this sheduler, must be set before searching
+	void SetJobSheduler(class JobSheduler* sheduler);
+	// The chart cache in this folder is trimmed to its maximum size after each search, must be set before searching
+	void SetChartCacheFolder(const String& folder);
 	void StartSearching();
 	void StopSearching();
 
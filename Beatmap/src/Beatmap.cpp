@@ -2,50 +2,49 @@
 #include "Beatmap.hpp"
 #include "Shared/Profiling.hpp"
 
-static const uint32 c_mapVersion = 1;
+static const uint32 c_mapMagic = *(uint32*)"FXMM";
+static const uint32 c_mapVersion = 3;
 
 Beatmap::~Beatmap()
 {
-	// Perform cleanup
-	for(auto tp : m_timingPoints)
-		delete tp;
-	for(auto obj : m_objectStates)
-		delete obj;
-	for (auto z : m_zoomControlPoints)
-		delete z;
-	for (auto z : m_laneTogglePoints)
-		delete z;
-	for (auto cs : m_chartStops)
-		delete cs;
+	// Objects are released together with the arena
 }
 Beatmap::Beatmap(Beatmap&& other)
 {
-	m_timingPoints = std::move(other.m_timingPoints);
-	m_objectStates = std::move(other.m_objectStates);
-	m_zoomControlPoints = std::move(other.m_zoomControlPoints);
-	m_laneTogglePoints = std::move(other.m_laneTogglePoints);
-	m_settings = std::move(other.m_settings);
+	*this = std::move(other);
 }
 Beatmap& Beatmap::operator=(Beatmap&& other)
 {
-	// Perform cleanup
-	for(auto tp : m_timingPoints)
-		delete tp;
-	for(auto obj : m_objectStates)
-		delete obj;
-	for(auto z : m_zoomControlPoints)
-		delete z;
+	m_arena = std::move(other.m_arena);
+	m_customEffects = std::move(other.m_customEffects);
+	m_customFilters = std::move(other.m_customFilters);
 	m_timingPoints = std::move(other.m_timingPoints);
+	m_chartStops = std::move(other.m_chartStops);
 	m_objectStates = std::move(other.m_objectStates);
 	m_zoomControlPoints = std::move(other.m_zoomControlPoints);
 	m_laneTogglePoints = std::move(other.m_laneTogglePoints);
+	m_samplePaths = std::move(other.m_samplePaths);
+	m_switchablePaths = std::move(other.m_switchablePaths);
 	m_settings = std::move(other.m_settings);
+	// Moved from vectors are not guaranteed to be empty
+	other.m_timingPoints.clear();
+	other.m_chartStops.clear();
+	other.m_objectStates.clear();
+	other.m_zoomControlPoints.clear();
+	other.m_laneTogglePoints.clear();
 	return *this;
 }
 bool Beatmap::Load(BinaryStream& input, bool metadataOnly)
 {
 	ProfilerScope $("Load Beatmap");
 
+	// Binary maps are recognized by their header, no need to try parsing them as KSH
+	uint32 magic = 0;
+	bool isBinary = input.Serialize(&magic, sizeof(magic)) == sizeof(magic) && magic == c_mapMagic;
+	input.Seek(0);
+	if(isBinary)
+		return m_Serialize(input, metadataOnly);
+
 	if(!m_ProcessKShootMap(input, metadataOnly)) // Load KSH format first
 	{
 		// Load binary map format
@@ -53,6 +52,12 @@ bool Beatmap::Load(BinaryStream& input, bool metadataOnly)
 		if(!m_Serialize(input, metadataOnly))
 			return false;
 	}
+	else if(!metadataOnly)
+	{
+		// KSH objects are created out of order while parsing
+		m_CompactObjects();
+		m_FindFXChipOverlaps();
+	}
 
 	return true;
 }
@@ -99,6 +104,11 @@ const Vector<String>& Beatmap::GetSwitchablePaths() const
 	return m_switchablePaths;
 }
 
+size_t Beatmap::GetObjectMemoryUsage() const
+{
+	return m_arena.GetCapacity();
+}
+
 AudioEffect Beatmap::GetEffect(EffectType type) const
 {
 	if(type >= EffectType::UserDefined0)
@@ -119,73 +129,130 @@ AudioEffect Beatmap::GetFilter(EffectType type) const
 	}
 	return AudioEffect::GetDefault(type);
 }
-bool MultiObjectState::StaticSerialize(BinaryStream& stream, MultiObjectState*& obj)
+// Size of the data of an object of the given type, 0 for invalid types
+static size_t GetObjectSize(ObjectType type)
 {
-	uint8 type = 0;
+	switch(type)
+	{
+	case ObjectType::Single:
+		return sizeof(ButtonObjectState);
+	case ObjectType::Hold:
+		return sizeof(HoldObjectState);
+	case ObjectType::Laser:
+		return sizeof(LaserObjectState);
+	case ObjectType::Event:
+		return sizeof(EventObjectState);
+	default:
+		return 0;
+	}
+}
+// Object data is written as is
+static void SerializeObjectData(BinaryStream& stream, MultiObjectState* obj)
+{
+	size_t size = GetObjectSize(obj->type);
 	if(stream.IsReading())
 	{
-		// Read type and create appropriate object
-		stream << type;
-		switch((ObjectType)type)
-		{
-		case ObjectType::Single:
-			obj = (MultiObjectState*)new ButtonObjectState();
-			break;
-		case ObjectType::Hold:
-			obj = (MultiObjectState*)new HoldObjectState();
-			break;
-		case ObjectType::Laser:
-			obj = (MultiObjectState*)new LaserObjectState();
-			break;
-		case ObjectType::Event:
-			obj = (MultiObjectState*)new EventObjectState();
-			break;
-		}
+		// Links to other objects are restored by Beatmap::m_Serialize
+		stream.Serialize(obj, size);
 	}
 	else
 	{
-		// Write type
-		type = (uint8)obj->type;
-		stream << type;
+		// Links to other objects are written separately by Beatmap::m_Serialize, so they are cleared here
+		uint8 data[sizeof(MultiObjectState)];
+		memcpy(data, obj, size);
+		MultiObjectState* copy = (MultiObjectState*)data;
+		if(copy->type == ObjectType::Hold)
+			copy->hold.next = copy->hold.prev = nullptr;
+		else if(copy->type == ObjectType::Laser)
+			copy->laser.next = copy->laser.prev = nullptr;
+		stream.Serialize(data, size);
 	}
-
-	// Pointer is always initialized here, serialize data
-	stream << obj->time; // Time always set
-	switch(obj->type)
+}
+static void SerializeTimingPoint(BinaryStream& stream, TimingPoint& tp)
+{
+	stream << tp.time;
+	stream << tp.beatDuration;
+	stream << tp.numerator;
+	stream << tp.denominator;
+	stream << tp.tickrateOffset;
+}
+// Objects are prefixed by their type and allocated from the arena when reading
+static bool SerializeObjects(BinaryStream& stream, Vector<ObjectState*>& objects, MemoryArena& arena)
+{
+	uint32 count = (uint32)objects.size();
+	stream << count;
+	if(stream.IsReading())
+		objects.resize(count);
+	for(uint32 i = 0; i < count; i++)
 	{
-	case ObjectType::Single:
-		stream << obj->button.index;
-		break;
-	case ObjectType::Hold:
-		stream << obj->hold.index;
-		stream << obj->hold.duration;
-		stream << (uint16&)obj->hold.effectType;
-		stream << (int16&)obj->hold.effectParams[0];
-		stream << (int16&)obj->hold.effectParams[1];
-		break;
-	case ObjectType::Laser:
-		stream << obj->laser.index;
-		stream << obj->laser.duration;
-		stream << obj->laser.points[0];
-		stream << obj->laser.points[1];
-		stream << obj->laser.flags;
-		break;
-	case ObjectType::Event:
-		stream << (uint8&)obj->event.key;
-		stream << *&obj->event.data;
-		break;
+		uint8 type = stream.IsReading() ? 0 : (uint8)objects[i]->type;
+		stream << type;
+		if(stream.IsReading())
+		{
+			switch((ObjectType)type)
+			{
+			case ObjectType::Single:
+				objects[i] = *arena.New<ButtonObjectState>();
+				break;
+			case ObjectType::Hold:
+				objects[i] = *arena.New<HoldObjectState>();
+				break;
+			case ObjectType::Laser:
+				objects[i] = *arena.New<LaserObjectState>();
+				break;
+			case ObjectType::Event:
+				objects[i] = *arena.New<EventObjectState>();
+				break;
+			default:
+				objects.resize(i);
+				return false;
+			}
+		}
+		SerializeObjectData(stream, *objects[i]);
 	}
-
 	return true;
 }
-bool TimingPoint::StaticSerialize(BinaryStream& stream, TimingPoint*& out)
+static void SerializeTimingPoints(BinaryStream& stream, Vector<TimingPoint*>& timingPoints, MemoryArena& arena)
 {
+	uint32 count = (uint32)timingPoints.size();
+	stream << count;
 	if(stream.IsReading())
-		out = new TimingPoint();
-	stream << out->time;
-	stream << out->beatDuration;
-	stream << out->numerator;
-	return true;
+	{
+		timingPoints.resize(count);
+		for(TimingPoint*& tp : timingPoints)
+			tp = arena.New<TimingPoint>();
+	}
+	for(TimingPoint* tp : timingPoints)
+		SerializeTimingPoint(stream, *tp);
+}
+// Reads or writes objects that don't contain any pointers
+template<typename T>
+static void SerializePlainObjects(BinaryStream& stream, Vector<T*>& objects, MemoryArena& arena)
+{
+	static_assert(std::is_trivially_copyable<T>::value, "Object can not be serialized as is");
+	uint32 count = (uint32)objects.size();
+	stream << count;
+	if(stream.IsReading())
+	{
+		objects.resize(count);
+		for(T*& obj : objects)
+			obj = arena.New<T>();
+	}
+	for(T* obj : objects)
+		stream.Serialize(obj, sizeof(T));
+}
+
+// Changes whenever the layout of any object that is written as is changes
+static uint32 GetObjectLayoutHash()
+{
+	const uint32 sizes[] = {
+		sizeof(ButtonObjectState), sizeof(HoldObjectState), sizeof(LaserObjectState), sizeof(EventObjectState),
+		sizeof(LaneHideTogglePoint), sizeof(ZoomControlPoint), sizeof(ChartStop), sizeof(AudioEffect)
+	};
+	uint32 hash = 0;
+	for(uint32 size : sizes)
+		hash = hash * 31 + size;
+	return hash;
 }
 
 BinaryStream& operator<<(BinaryStream& stream, BeatmapSettings& settings)
@@ -217,16 +284,17 @@ BinaryStream& operator<<(BinaryStream& stream, BeatmapSettings& settings)
 }
 bool Beatmap::m_Serialize(BinaryStream& stream, bool metadataOnly)
 {
-	static const uint32 c_magic = *(uint32*)"FXMM";
-	uint32 magic = c_magic;
+	uint32 magic = c_mapMagic;
 	uint32 version = c_mapVersion;
+	uint32 layout = GetObjectLayoutHash();
 	stream << magic;
 	stream << version;
+	stream << layout;
 
 	// Validate headers when reading
 	if(stream.IsReading())
 	{
-		if(magic != c_magic)
+		if(magic != c_mapMagic)
 		{
 			Log("Invalid map format", Logger::Warning);
 			return false;
@@ -236,29 +304,87 @@ bool Beatmap::m_Serialize(BinaryStream& stream, bool metadataOnly)
 			Logf("Incompatible map version [%d], loader is version %d", Logger::Warning, version, c_mapVersion);
 			return false;
 		}
+		if(layout != GetObjectLayoutHash())
+		{
+			Log("Map was saved by an incompatible build", Logger::Warning);
+			return false;
+		}
 	}
 
 	stream << m_settings;
-	stream << m_timingPoints;
-	stream << reinterpret_cast<Vector<MultiObjectState*>&>(m_objectStates);
+	// Settings that are not stored in the map database metadata
+	stream << m_settings.total;
+	stream << m_settings.musicVolume;
+	stream << m_settings.backgroundPath;
+	stream << m_settings.foregroundPath;
+	if(metadataOnly && stream.IsReading())
+		return true;
+
+	SerializeTimingPoints(stream, m_timingPoints, m_arena);
+	SerializePlainObjects(stream, m_chartStops, m_arena);
+	SerializePlainObjects(stream, m_laneTogglePoints, m_arena);
+	SerializePlainObjects(stream, m_zoomControlPoints, m_arena);
+	stream << m_customEffects;
+	stream << m_customFilters;
+	stream << m_samplePaths;
+	stream << m_switchablePaths;
+	if(!SerializeObjects(stream, m_objectStates, m_arena))
+		return false;
+
+	// Hold and laser segments are linked by their index in the object list
+	Vector<int32> nextIndices;
+	if(stream.IsWriting())
+	{
+		Map<MultiObjectState*, int32> objectIndices;
+		for(size_t i = 0; i < m_objectStates.size(); i++)
+			objectIndices.Add(*m_objectStates[i], (int32)i);
+
+		nextIndices.resize(m_objectStates.size(), -1);
+		for(size_t i = 0; i < m_objectStates.size(); i++)
+		{
+			MultiObjectState* obj = *m_objectStates[i];
+			MultiObjectState* next = nullptr;
+			if(obj->type == ObjectType::Hold)
+				next = (MultiObjectState*)obj->hold.next;
+			else if(obj->type == ObjectType::Laser)
+				next = (MultiObjectState*)obj->laser.next;
+			if(next)
+				nextIndices[i] = objectIndices[next];
+		}
+	}
+	stream << nextIndices;
 
-	// Manually fix up laser next-prev pointers
-	LaserObjectState* prevLasers[2] = { 0 };
 	if(stream.IsReading())
 	{
+		if(nextIndices.size() != m_objectStates.size())
+			return false;
 		for(ObjectState* obj : m_objectStates)
 		{
-			if(obj->type == ObjectType::Laser)
+			MultiObjectState* mobj = *obj;
+			if(mobj->type == ObjectType::Hold)
+				mobj->hold.next = mobj->hold.prev = nullptr;
+			else if(mobj->type == ObjectType::Laser)
+				mobj->laser.next = mobj->laser.prev = nullptr;
+		}
+		for(size_t i = 0; i < m_objectStates.size(); i++)
+		{
+			int32 nextIndex = nextIndices[i];
+			if(nextIndex < 0)
+				continue;
+			if(nextIndex >= (int32)m_objectStates.size() || m_objectStates[nextIndex]->type != m_objectStates[i]->type)
+				return false;
+
+			MultiObjectState* obj = *m_objectStates[i];
+			MultiObjectState* next = *m_objectStates[nextIndex];
+			if(obj->type == ObjectType::Hold)
 			{
-				LaserObjectState* laser = (LaserObjectState*)obj;
-				LaserObjectState*& prev = prevLasers[laser->index];
-				if(prev && (prev->time + prev->duration) == laser->time)
-				{
-					prev->next = laser;
-					laser->prev = prev;
-				}
-
-				prev = laser;
+				obj->hold.next = (HoldObjectState*)next;
+				next->hold.prev = (HoldObjectState*)obj;
+			}
+			else
+			{
+				obj->laser.next = (LaserObjectState*)next;
+				next->laser.prev = (LaserObjectState*)obj;
 			}
 		}
 	}
@@ -266,6 +392,113 @@ bool Beatmap::m_Serialize(BinaryStream& stream, bool metadataOnly)
 	return true;
 }
 
+// Copies an object state into another arena
+template<typename T>
+static ObjectState* CopyObjectToArena(ObjectState* obj, MemoryArena& arena)
+{
+	// Object states are packed, so no alignment is needed between them
+	return *new(arena.Allocate(sizeof(T), 1)) T(*(T*)obj);
+}
+// Copies plain objects into another arena
+template<typename T>
+static void CopyToArena(Vector<T*>& objects, MemoryArena& arena)
+{
+	for(T*& obj : objects)
+		obj = arena.New<T>(*obj);
+}
+void Beatmap::m_FindFXChipOverlaps()
+{
+	// Objects are sorted by time, so all objects at the same time are next to each other
+	size_t start = 0;
+	while(start < m_objectStates.size())
+	{
+		MapTime time = m_objectStates[start]->time;
+		bool fxChips[2] = { false, false };
+		size_t end = start;
+		for(; end < m_objectStates.size() && m_objectStates[end]->time == time; end++)
+		{
+			MultiObjectState* obj = *m_objectStates[end];
+			if(obj->type == ObjectType::Single && obj->button.index >= 4)
+				fxChips[obj->button.index - 4] = true;
+		}
+
+		for(size_t i = start; i < end; i++)
+		{
+			MultiObjectState* obj = *m_objectStates[i];
+			if(obj->type == ObjectType::Single && obj->button.index < 4)
+				obj->button.overlapsFXChip = fxChips[obj->button.index < 2 ? 0 : 1];
+		}
+		start = end;
+	}
+}
+void Beatmap::m_CompactObjects()
+{
+	ProfilerScope $("Compact Beatmap Objects");
+
+	size_t totalSize = m_timingPoints.size() * sizeof(TimingPoint) + m_chartStops.size() * sizeof(ChartStop) +
+		m_laneTogglePoints.size() * sizeof(LaneHideTogglePoint) + m_zoomControlPoints.size() * sizeof(ZoomControlPoint);
+	for(ObjectState* obj : m_objectStates)
+		totalSize += GetObjectSize(obj->type);
+
+	// Allocate everything from a single block, with some room for alignment padding between the lists
+	MemoryArena arena;
+	arena.Reserve(totalSize + 64);
+	CopyToArena(m_timingPoints, arena);
+	CopyToArena(m_chartStops, arena);
+	CopyToArena(m_laneTogglePoints, arena);
+	CopyToArena(m_zoomControlPoints, arena);
+
+	for(ObjectState*& obj : m_objectStates)
+	{
+		ObjectState* copy = nullptr;
+		switch(obj->type)
+		{
+		case ObjectType::Single:
+			copy = CopyObjectToArena<ButtonObjectState>(obj, arena);
+			break;
+		case ObjectType::Hold:
+			copy = CopyObjectToArena<HoldObjectState>(obj, arena);
+			break;
+		case ObjectType::Laser:
+			copy = CopyObjectToArena<LaserObjectState>(obj, arena);
+			break;
+		case ObjectType::Event:
+			copy = CopyObjectToArena<EventObjectState>(obj, arena);
+			break;
+		default:
+			assert(false);
+			continue;
+		}
+		// The old object is no longer used, so its memory is used to store where it moved to
+		static_assert(sizeof(ButtonObjectState) >= sizeof(ObjectState*), "Object too small to store its new location");
+		new((void*)obj) ObjectState*(copy);
+		obj = copy;
+	}
+
+	// Relink hold and laser segments to their new locations
+	auto relink = [](auto*& link)
+	{
+		if(link)
+			link = (std::remove_reference_t<decltype(link)>)*(ObjectState**)link;
+	};
+	for(ObjectState* obj : m_objectStates)
+	{
+		MultiObjectState* mobj = *obj;
+		if(mobj->type == ObjectType::Hold)
+		{
+			relink(mobj->hold.next);
+			relink(mobj->hold.prev);
+		}
+		else if(mobj->type == ObjectType::Laser)
+		{
+			relink(mobj->laser.next);
+			relink(mobj->laser.prev);
+		}
+	}
+
+	m_arena = std::move(arena);
+}
+
 bool BeatmapSettings::StaticSerialize(BinaryStream& stream, BeatmapSettings*& settings)
 {
 	if(stream.IsReading())
@@ -273,3 +506,4 @@ bool BeatmapSettings::StaticSerialize(BinaryStream& stream, BeatmapSettings*& se
 	stream << *settings;
 	return true;
 }
+
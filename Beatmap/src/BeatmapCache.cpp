@@ -0,0 +1,155 @@
+#include "stdafx.h"
+#include "BeatmapCache.hpp"
+#include "TinySHA1.hpp"
+#include "Shared/Profiling.hpp"
+#include "Shared/Files.hpp"
+
+static const uint32 c_cacheMagic = *(uint32*)"FXMC";
+
+// Header of a cache entry, followed by the chart path and the map in the binary format
+struct CacheEntryHeader
+{
+	uint32 magic;
+	uint32 pathLength;
+	uint32 size;
+	uint32 reserved;
+	// Last write time of the chart this entry was made from
+	uint64 chartWriteTime;
+	// Hash of the map data, entries are only loaded if this matches
+	uint32 digest[5];
+};
+
+static void HashData(const void* data, size_t size, uint32* digest)
+{
+	sha1::SHA1 s;
+	s.processBytes(data, size);
+	s.getDigest(digest);
+}
+
+BeatmapCache::BeatmapCache(const String& folder) : m_folder(folder)
+{
+}
+
+String BeatmapCache::GetDefaultFolder()
+{
+	return Path::Absolute("cache/charts");
+}
+
+bool BeatmapCache::Load(const String& chartPath, uint64 chartWriteTime, Beatmap& map)
+{
+	ProfilerScope $("Load Cached Beatmap");
+
+	String entryPath = m_GetEntryPath(chartPath);
+	if(m_LoadEntry(entryPath, chartPath, chartWriteTime, map))
+	{
+		// Evict removes the entries with the oldest write time, so used entries are kept
+		File::UpdateLastWriteTime(entryPath);
+		return true;
+	}
+
+	File file;
+	if(!file.OpenRead(chartPath))
+		return false;
+	FileReader reader(file);
+	if(!map.Load(reader))
+		return false;
+	Store(chartPath, chartWriteTime, map);
+	return true;
+}
+
+String BeatmapCache::m_GetEntryPath(const String& chartPath) const
+{
+	uint32 digest[5];
+	HashData(chartPath.data(), chartPath.size(), digest);
+	return m_folder + Path::sep +
+		Utility::Sprintf("%08x%08x%08x%08x%08x.fxmm", digest[0], digest[1], digest[2], digest[3], digest[4]);
+}
+
+bool BeatmapCache::m_LoadEntry(const String& entryPath, const String& chartPath, uint64 chartWriteTime, Beatmap& map)
+{
+	if(!Path::FileExists(entryPath))
+		return false;
+
+	CacheEntryHeader header;
+	String entryChartPath;
+	Buffer mapData;
+	{
+		File file;
+		if(!file.OpenRead(entryPath))
+			return false;
+		if(file.Read(&header, sizeof(header)) != sizeof(header) || header.magic != c_cacheMagic)
+			return false;
+
+		// Outdated entries get replaced after the chart is parsed
+		if(header.chartWriteTime != chartWriteTime)
+			return false;
+		if(header.pathLength != chartPath.size() || (uint64)header.pathLength + header.size != file.GetSize() - sizeof(header))
+			return false;
+		entryChartPath.resize(header.pathLength);
+		if(file.Read(&entryChartPath[0], entryChartPath.size()) != entryChartPath.size() || entryChartPath != chartPath)
+			return false;
+
+		mapData.resize(header.size);
+		if(file.Read(mapData.data(), mapData.size()) != mapData.size())
+			return false;
+	}
+
+	// Validate the entry before loading it, a truncated or damaged map would not be detected while loading
+	uint32 digest[5];
+	HashData(mapData.data(), mapData.size(), digest);
+	if(memcmp(digest, header.digest, sizeof(digest)) != 0)
+	{
+		Logf("Damaged chart cache entry [%s]", Logger::Warning, entryPath);
+		return false;
+	}
+
+	MemoryReader reader(mapData);
+	Beatmap cached;
+	if(!cached.Load(reader))
+		return false;
+	map = std::move(cached);
+	return true;
+}
+
+void BeatmapCache::Store(const String& chartPath, uint64 chartWriteTime, const Beatmap& map)
+{
+	Buffer mapData;
+	MemoryWriter writer(mapData);
+	if(!map.Save(writer))
+		return;
+
+	CacheEntryHeader header = {};
+	header.magic = c_cacheMagic;
+	header.pathLength = (uint32)chartPath.size();
+	header.size = (uint32)mapData.size();
+	header.chartWriteTime = chartWriteTime;
+	HashData(mapData.data(), mapData.size(), header.digest);
+
+	if(!Path::IsDirectory(m_folder) && !Path::CreateDirRecursive(m_folder))
+	{
+		Logf("Failed to create chart cache folder [%s]", Logger::Warning, m_folder);
+		return;
+	}
+
+	// Written to a temporary file first so other loads never see a partially written entry
+	String entryPath = m_GetEntryPath(chartPath);
+	String tempPath = entryPath + ".tmp";
+	if(Path::FileExists(tempPath))
+		Path::Delete(tempPath); // Opening for writing does not truncate
+	{
+		File file;
+		if(!file.OpenWrite(tempPath))
+			return;
+		file.Write(&header, sizeof(header));
+		file.Write(chartPath.data(), chartPath.size());
+		file.Write(mapData.data(), mapData.size());
+	}
+	Path::Rename(tempPath, entryPath, true);
+}
+
+void BeatmapCache::Evict(uint64 maxSize)
+{
+	uint32 numDeleted = Files::DeleteOldest(m_folder, maxSize, "fxmm");
+	if(numDeleted > 0)
+		Logf("Removed %d old chart cache entries", Logger::Info, numDeleted);
+}
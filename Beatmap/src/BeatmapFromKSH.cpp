@@ -539,7 +539,7 @@ bool Beatmap::m_ProcessKShootMap(BinaryStream &input, bool metadataOnly)
 	Map<uint32, TimingPoint *> timingPointTicks;
 
 	// Process initial timing point
-	TimingPoint *lastTimingPoint = new TimingPoint();
+	TimingPoint *lastTimingPoint = m_arena.New<TimingPoint>();
 	lastTimingPoint->time = atol(*kshootMap.settings["o"]);
 	double bpm = atof(*kshootMap.settings["t"]);
 	lastTimingPoint->beatDuration = 60000.0 / bpm;
@@ -557,7 +557,7 @@ bool Beatmap::m_ProcessKShootMap(BinaryStream &input, bool metadataOnly)
 	int tickResolution = 240;
 
 	// Add First Lane Toggle Point
-	LaneHideTogglePoint *startLaneTogglePoint = new LaneHideTogglePoint();
+	LaneHideTogglePoint *startLaneTogglePoint = m_arena.New<LaneHideTogglePoint>();
 	startLaneTogglePoint->time = 0;
 	startLaneTogglePoint->duration = 1;
 	m_laneTogglePoints.Add(startLaneTogglePoint);
@@ -606,7 +606,7 @@ bool Beatmap::m_ProcessKShootMap(BinaryStream &input, bool metadataOnly)
 				// Does not yet exist at current time?
 				if (!timingPointMap.Contains(mapTime))
 				{
-					lastTimingPoint = new TimingPoint(*lastTimingPoint);
+					lastTimingPoint = m_arena.New<TimingPoint>(*lastTimingPoint);
 					lastTimingPoint->time = mapTime;
 					m_timingPoints.Add(lastTimingPoint);
 					timingPointMap.Add(mapTime, lastTimingPoint);
@@ -710,7 +710,7 @@ bool Beatmap::m_ProcessKShootMap(BinaryStream &input, bool metadataOnly)
 			else if (p.first == "filtertype")
 			{
 				// Inser filter type change event
-				EventObjectState *evt = new EventObjectState();
+				EventObjectState *evt = m_arena.New<EventObjectState>();
 				evt->time = mapTime;
 				evt->key = EventKey::LaserEffectType;
 				evt->data.effectVal = ParseFilterType(p.second);
@@ -720,7 +720,7 @@ bool Beatmap::m_ProcessKShootMap(BinaryStream &input, bool metadataOnly)
 			{
 				// Inser filter type change event
 				float gain = (float)atol(*p.second) / 100.0f;
-				EventObjectState *evt = new EventObjectState();
+				EventObjectState *evt = m_arena.New<EventObjectState>();
 				evt->time = mapTime;
 				evt->key = EventKey::LaserEffectMix;
 				evt->data.floatVal = gain;
@@ -729,7 +729,7 @@ bool Beatmap::m_ProcessKShootMap(BinaryStream &input, bool metadataOnly)
 			else if (p.first == "chokkakuvol")
 			{
 				float vol = (float)atol(*p.second) / 100.0f;
-				EventObjectState *evt = new EventObjectState();
+				EventObjectState *evt = m_arena.New<EventObjectState>();
 				evt->time = mapTime;
 				evt->key = EventKey::LaserEffectMix;
 				evt->data.floatVal = vol;
@@ -740,7 +740,7 @@ bool Beatmap::m_ProcessKShootMap(BinaryStream &input, bool metadataOnly)
 	firstControlPoints[point->index] = point
 			else if (p.first == "zoom_bottom")
 			{
-				ZoomControlPoint *point = new ZoomControlPoint();
+				ZoomControlPoint *point = m_arena.New<ZoomControlPoint>();
 				point->time = mapTime;
 				point->index = 0;
 				point->zoom = (float)atol(*p.second) / 100.0f;
@@ -749,7 +749,7 @@ bool Beatmap::m_ProcessKShootMap(BinaryStream &input, bool metadataOnly)
 			}
 			else if (p.first == "zoom_top")
 			{
-				ZoomControlPoint *point = new ZoomControlPoint();
+				ZoomControlPoint *point = m_arena.New<ZoomControlPoint>();
 				point->time = mapTime;
 				point->index = 1;
 				point->zoom = (float)(atol(*p.second) / 100.0);
@@ -758,7 +758,7 @@ bool Beatmap::m_ProcessKShootMap(BinaryStream &input, bool metadataOnly)
 			}
 			else if (p.first == "zoom_side")
 			{
-				ZoomControlPoint *point = new ZoomControlPoint();
+				ZoomControlPoint *point = m_arena.New<ZoomControlPoint>();
 				point->time = mapTime;
 				point->index = 2;
 				point->zoom = (float)atol(*p.second) / 100.0f;
@@ -768,7 +768,7 @@ bool Beatmap::m_ProcessKShootMap(BinaryStream &input, bool metadataOnly)
 			/* OLD USC MANUAL ROLL, KEPT JUST IN CASE
 			else if (p.first == "roll")
 			{
-				ZoomControlPoint* point = new ZoomControlPoint();
+				ZoomControlPoint* point = m_arena.New<ZoomControlPoint>();
 				point->time = mapTime;
 				point->index = 3;
 				point->zoom = (float)atol(*p.second) / 360.0f;
@@ -778,14 +778,14 @@ bool Beatmap::m_ProcessKShootMap(BinaryStream &input, bool metadataOnly)
 			*/
 			else if (p.first == "lane_toggle")
 			{
-				LaneHideTogglePoint *point = new LaneHideTogglePoint();
+				LaneHideTogglePoint *point = m_arena.New<LaneHideTogglePoint>();
 				point->time = mapTime;
 				point->duration = atol(*p.second);
 				m_laneTogglePoints.Add(point);
 			}
 			else if (p.first == "center_split")
 			{
-				ZoomControlPoint *point = new ZoomControlPoint();
+				ZoomControlPoint *point = m_arena.New<ZoomControlPoint>();
 				point->time = mapTime;
 				point->index = 4;
 				int value = atol(*p.second);
@@ -795,7 +795,7 @@ bool Beatmap::m_ProcessKShootMap(BinaryStream &input, bool metadataOnly)
 			}
 			else if (p.first == "tilt")
 			{
-				EventObjectState *evt = new EventObjectState();
+				EventObjectState *evt = m_arena.New<EventObjectState>();
 				evt->time = mapTime;
 				evt->interTickIndex = tickSettingIndex;
 				evt->key = EventKey::TrackRollBehaviour;
@@ -821,7 +821,7 @@ bool Beatmap::m_ProcessKShootMap(BinaryStream &input, bool metadataOnly)
 				{
 					evt->data.rollVal = TrackRollBehaviour::Manual;
 
-					ZoomControlPoint *point = new ZoomControlPoint();
+					ZoomControlPoint *point = m_arena.New<ZoomControlPoint>();
 					point->time = mapTime;
 					point->index = 3;
 					point->zoom = atof(*p.second) / -(360.0 / 10.0);
@@ -844,7 +844,7 @@ bool Beatmap::m_ProcessKShootMap(BinaryStream &input, bool metadataOnly)
 
 				if (isManualTilt)
 				{
-					ZoomControlPoint *point = new ZoomControlPoint();
+					ZoomControlPoint *point = m_arena.New<ZoomControlPoint>();
 					point->time = mapTime;
 					point->index = 3;
 					point->zoom = m_zoomControlPoints.back()->zoom;
@@ -907,7 +907,7 @@ bool Beatmap::m_ProcessKShootMap(BinaryStream &input, bool metadataOnly)
 			}
 			else if (p.first == "stop")
 			{
-				ChartStop *cs = new ChartStop();
+				ChartStop *cs = m_arena.New<ChartStop>();
 				cs->time = mapTime;
 				cs->duration = (atol(*p.second) / 192.0f) * (lastTimingPoint->beatDuration) * 4;
 				m_chartStops.Add(cs);
@@ -932,7 +932,7 @@ bool Beatmap::m_ProcessKShootMap(BinaryStream &input, bool metadataOnly)
 			auto CreateButton = [&]() {
 				if (IsHoldState())
 				{
-					HoldObjectState *obj = lastHoldObject = new HoldObjectState();
+					HoldObjectState *obj = lastHoldObject = m_arena.New<HoldObjectState>();
 					obj->time = MapTimeFromTicks(state->startTick, timingPointTicks, tickResolution);
 					obj->index = i;
 					obj->duration = MapTimeFromTicks(currentTick, timingPointTicks, tickResolution) - obj->time;
@@ -945,7 +945,7 @@ bool Beatmap::m_ProcessKShootMap(BinaryStream &input, bool metadataOnly)
 				}
 				else
 				{
-					ButtonObjectState *obj = new ButtonObjectState();
+					ButtonObjectState *obj = m_arena.New<ButtonObjectState>();
 
 					obj->time = MapTimeFromTicks(state->startTick, timingPointTicks, tickResolution);
 					obj->index = i;
@@ -1123,7 +1123,7 @@ bool Beatmap::m_ProcessKShootMap(BinaryStream &input, bool metadataOnly)
 				// Process existing segment
 				//assert(state->numTicks > 0);
 
-				LaserObjectState *obj = new LaserObjectState();
+				LaserObjectState *obj = m_arena.New<LaserObjectState>();
 
 				obj->time = MapTimeFromTicks(state->startTick, timingPointTicks, tickResolution);
 				obj->tick = state->startTick;
@@ -1202,7 +1202,7 @@ bool Beatmap::m_ProcessKShootMap(BinaryStream &input, bool metadataOnly)
 
 				if ((obj->flags & LaserObjectState::flag_Instant) != 0 && lastSlam) //add short straight segment between the slams
 				{
-					auto midobj = new LaserObjectState();
+					auto midobj = m_arena.New<LaserObjectState>();
 					midobj->flags = obj->prev->flags & ~LaserObjectState::flag_Instant;
 					midobj->points[0] = obj->points[0];
 					midobj->points[1] = obj->points[0];
@@ -1319,7 +1319,7 @@ bool Beatmap::m_ProcessKShootMap(BinaryStream &input, bool metadataOnly)
 		if (!point)
 			continue;
 
-		ZoomControlPoint *dup = new ZoomControlPoint();
+		ZoomControlPoint *dup = m_arena.New<ZoomControlPoint>();
 		dup->index = point->index;
 		dup->zoom = point->zoom;
 		dup->time = INT32_MIN;
@@ -1328,7 +1328,7 @@ bool Beatmap::m_ProcessKShootMap(BinaryStream &input, bool metadataOnly)
 	}
 
 	//Add chart end event
-	EventObjectState *evt = new EventObjectState();
+	EventObjectState *evt = m_arena.New<EventObjectState>();
 	evt->time = lastMapTime + 2000;
 	evt->key = EventKey::ChartEnd;
 	m_objectStates.Add(*evt);
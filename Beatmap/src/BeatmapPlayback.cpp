@@ -49,10 +49,13 @@ bool BeatmapPlayback::Reset(MapTime startTime)
 	//alertLaserThreshold = (*m_currentTiming)->beatDuration * 6.0;
 	m_hittableObjects.clear();
 	m_holdObjects.clear();
+	m_ClearVisibleObjects();
 
 	m_barTime = 0;
 	m_beatTime = 0;
 	m_initialEffectStateSent = false;
+
+	m_BuildViewDistanceSections();
 	return true;
 }
 
@@ -327,6 +330,8 @@ void BeatmapPlayback::MakeCalibrationPlayback()
 	calibrationTiming->numerator = 4;
 	m_timingPoints.Add(calibrationTiming);
 	m_currentTiming = &m_timingPoints.front();
+	m_BuildViewDistanceSections();
+	m_ClearVisibleObjects();
 }
 
 Vector<ObjectState*> BeatmapPlayback::GetObjectsInRange(MapTime range)
@@ -371,6 +376,70 @@ Vector<ObjectState*> BeatmapPlayback::GetObjectsInRange(MapTime range)
 	return ret;
 }
 
+void BeatmapPlayback::UpdateVisibleObjects(MapTime range)
+{
+	const Vector<ObjectState*>& objects = m_isCalibration ? m_calibrationObjects : m_objects;
+	MapTime end = m_playbackTime + range;
+
+	// Remove objects that are out of range again after the range got smaller, these are always the last in their group
+	while(m_nextVisibleObject > 0 && objects[m_nextVisibleObject - 1]->time > end)
+	{
+		ObjectState* obj = objects[--m_nextVisibleObject];
+		VisibleObjectGroup group = m_GetVisibleObjectGroup(obj);
+		if(group != NumVisibleObjectGroups && !m_visibleObjects[group].empty() && m_visibleObjects[group].back() == obj)
+			m_visibleObjects[group].pop_back();
+	}
+
+	// Add objects that came into range
+	while(m_nextVisibleObject < objects.size() && objects[m_nextVisibleObject]->time <= end)
+	{
+		ObjectState* obj = objects[m_nextVisibleObject++];
+		VisibleObjectGroup group = m_GetVisibleObjectGroup(obj);
+		if(group != NumVisibleObjectGroups)
+			m_visibleObjects[group].Add(obj);
+	}
+
+	// Remove objects that have passed, same as hittable objects
+	// the end times of holds and lasers are not sorted so the whole group is checked
+	MapTime passTime = m_playbackTime - hittableObjectLeave;
+	for(Vector<ObjectState*>& group : m_visibleObjects)
+	{
+		auto passed = std::remove_if(group.begin(), group.end(), [&](ObjectState* obj)
+		{
+			MultiObjectState* mobj = *obj;
+			MapTime endTime = mobj->time;
+			if(mobj->type == ObjectType::Hold)
+				endTime += mobj->hold.duration;
+			else if(mobj->type == ObjectType::Laser)
+				endTime += mobj->laser.duration;
+			return endTime < passTime;
+		});
+		group.erase(passed, group.end());
+	}
+}
+const Vector<ObjectState*>& BeatmapPlayback::GetVisibleObjects(VisibleObjectGroup group) const
+{
+	assert(group < NumVisibleObjectGroups);
+	return m_visibleObjects[group];
+}
+BeatmapPlayback::VisibleObjectGroup BeatmapPlayback::m_GetVisibleObjectGroup(ObjectState* obj)
+{
+	MultiObjectState* mobj = *obj;
+	if(mobj->type == ObjectType::Single)
+		return mobj->button.index < 4 ? BTChips : FXChips;
+	if(mobj->type == ObjectType::Hold)
+		return mobj->hold.index < 4 ? BTHolds : FXHolds;
+	if(mobj->type == ObjectType::Laser)
+		return Lasers;
+	return NumVisibleObjectGroups;
+}
+void BeatmapPlayback::m_ClearVisibleObjects()
+{
+	for(Vector<ObjectState*>& group : m_visibleObjects)
+		group.clear();
+	m_nextVisibleObject = 0;
+}
+
 const TimingPoint& BeatmapPlayback::GetCurrentTimingPoint() const
 {
 	if (!m_currentTiming)
@@ -394,46 +463,23 @@ uint32 BeatmapPlayback::CountBeats(MapTime start, MapTime range, int32& startInd
 }
 MapTime BeatmapPlayback::ViewDistanceToDuration(float distance)
 {
-	TimingPoint** tp = m_SelectTimingPoint(m_playbackTime, true);
-
-	double time = 0;
-
-	MapTime currentTime = m_playbackTime;
-	while (true)
-	{
-		if (!IsEndTiming(tp + 1))
-		{
-			double maxDist = (tp[1]->time - (double)currentTime) / tp[0]->beatDuration;
-			if (maxDist < distance)
-			{
-				// Split up
-				time += maxDist * tp[0]->beatDuration;
-				distance -= (float)maxDist;
-				tp++;
-				continue;
-			}
-		}
-		time += distance * tp[0]->beatDuration;
-		break;
-	}
-
-	/// TODO: Optimize?
-	uint32 processedStops = 0;
-	Vector<ChartStop*> ignoreStops;
-	do
-	{
-		processedStops = 0;
-		for (auto cs : m_SelectChartStops(currentTime, time))
-		{
-			if (std::find(ignoreStops.begin(), ignoreStops.end(), cs) != ignoreStops.end())
-				continue;
-			time += cs->duration;
-			processedStops++;
-			ignoreStops.Add(cs);
-		}
-	} while (processedStops);
-
-	return (MapTime)time;
+	if(m_viewDistanceSections.empty())
+		return 0;
+
+	// Find the first section that starts beyond the target distance, the target lies in the one before it
+	// this skips over chart stops since they don't add any distance
+	double target = m_TimeToViewDistance(m_playbackTime, true) + distance;
+	auto it = std::upper_bound(m_viewDistanceSections.begin(), m_viewDistanceSections.end(), target,
+		[](double d, const ViewDistanceSection& section) { return d < section.distance; });
+	if(it != m_viewDistanceSections.begin())
+		it--;
+
+	double time = it->time;
+	double rate = target < it->distance ? it->rateNoStops : it->rate;
+	if(rate > 0.0)
+		time += (target - it->distance) / rate;
+
+	return (MapTime)(time - m_playbackTime);
 }
 float BeatmapPlayback::DurationToViewDistance(MapTime duration)
 {
@@ -442,42 +488,7 @@ float BeatmapPlayback::DurationToViewDistance(MapTime duration)
 
 float BeatmapPlayback::DurationToViewDistanceAtTimeNoStops(MapTime time, MapTime duration)
 {
-	MapTime endTime = time + duration;
-	int8 direction = Math::Sign(duration);
-	if (duration < 0)
-	{
-		MapTime temp = time;
-		time = endTime;
-		endTime = temp;
-		duration *= -1;
-	}
-
-	// Accumulated value
-	double barTime = 0.0f;
-
-	// Split up to see if passing other timing points on the way
-	TimingPoint** tp = m_SelectTimingPoint(time, true);
-	while (true)
-	{
-		if (!IsEndTiming(tp + 1))
-		{
-			if (tp[1]->time < endTime)
-			{
-				// Split up
-				MapTime myDuration = tp[1]->time - time;
-				barTime += (double)myDuration / tp[0]->beatDuration;
-				duration -= myDuration;
-				time = tp[1]->time;
-				tp++;
-				continue;
-			}
-		}
-		// Whole
-		barTime += (double)duration / tp[0]->beatDuration;
-		break;
-	}
-
-	return (float)barTime * direction;
+	return (float)(m_TimeToViewDistance(time + duration, false) - m_TimeToViewDistance(time, false));
 }
 
 float BeatmapPlayback::DurationToViewDistanceAtTime(MapTime time, MapTime duration)
@@ -486,57 +497,7 @@ float BeatmapPlayback::DurationToViewDistanceAtTime(MapTime time, MapTime durati
 	{
 		return (float)duration / 480000.0f;
 	}
-	MapTime endTime = time + duration;
-	int8 direction = Math::Sign(duration);
-	if (duration < 0)
-	{
-		MapTime temp = time;
-		time = endTime;
-		endTime = temp;
-		duration *= -1;
-	}
-
-	MapTime startTime = time;
-
-	// Accumulated value
-	double barTime = 0.0f;
-
-	// Split up to see if passing other timing points on the way
-	TimingPoint** tp = m_SelectTimingPoint(time, true);
-	while (true)
-	{
-		if (!IsEndTiming(tp + 1))
-		{
-			if (tp[1]->time < endTime)
-			{
-				// Split up
-				MapTime myDuration = tp[1]->time - time;
-				barTime += (double)myDuration / tp[0]->beatDuration;
-				duration -= myDuration;
-				time = tp[1]->time;
-				tp++;
-				continue;
-			}
-		}
-		// Whole
-		barTime += (double)duration / tp[0]->beatDuration;
-		break;
-	}
-
-	// calculate stop ViewDistance
-	double stopTime = 0.;
-	for (auto cs : m_SelectChartStops(startTime, endTime - startTime))
-	{
-		MapTime overlap = Math::Min(abs(endTime - startTime), 
-			Math::Min(abs(endTime - cs->time), 
-				Math::Min(abs((cs->time + cs->duration) - startTime), abs((cs->time + cs->duration) - cs->time))));
-
-		stopTime += DurationToViewDistanceAtTimeNoStops(Math::Max(cs->time, startTime), overlap);
-	}
-	barTime -= stopTime;
-
-
-	return (float)barTime * direction;
+	return (float)(m_TimeToViewDistance(time + duration, true) - m_TimeToViewDistance(time, true));
 }
 
 float BeatmapPlayback::TimeToViewDistance(MapTime time)
@@ -601,18 +562,79 @@ TimingPoint** BeatmapPlayback::m_SelectTimingPoint(MapTime time, bool allowReset
 	return objStart;
 }
 
-Vector<ChartStop*> BeatmapPlayback::m_SelectChartStops(MapTime time, MapTime duration)
+void BeatmapPlayback::m_BuildViewDistanceSections()
 {
-	Vector<ChartStop*> stops;
+	m_viewDistanceSections.clear();
+	if (m_timingPoints.empty())
+		return;
+
+	// Chart stops can overlap, so keep track of how many are active
+	Vector<std::pair<MapTime, int32>> stopEdges;
 	for (auto cs : m_chartStops)
 	{
-		if (time <= cs->time + cs->duration && time + duration >= cs->time)
-			stops.Add(cs);
+		stopEdges.Add({ cs->time, 1 });
+		stopEdges.Add({ cs->time + cs->duration, -1 });
 	}
-	return stops;
-}
-
+	std::sort(stopEdges.begin(), stopEdges.end());
+
+	size_t timingIndex = 0;
+	size_t edgeIndex = 0;
+	int32 activeStops = 0;
+	double rate = 1.0 / m_timingPoints.front()->beatDuration;
+	double distance = 0.0;
+	double distanceNoStops = 0.0;
+	MapTime time = m_timingPoints.front()->time;
+	if (!stopEdges.empty())
+		time = Math::Min(time, stopEdges.front().first);
+	while (true)
+	{
+		// Apply all changes that happen at this time
+		while (timingIndex < m_timingPoints.size() && m_timingPoints[timingIndex]->time <= time)
+			rate = 1.0 / m_timingPoints[timingIndex++]->beatDuration;
+		while (edgeIndex < stopEdges.size() && stopEdges[edgeIndex].first <= time)
+			activeStops += stopEdges[edgeIndex++].second;
+
+		ViewDistanceSection section;
+		section.time = time;
+		section.distance = distance;
+		section.distanceNoStops = distanceNoStops;
+		section.rate = activeStops > 0 ? 0.0 : rate;
+		section.rateNoStops = rate;
+		m_viewDistanceSections.Add(section);
+
+		if (timingIndex == m_timingPoints.size() && edgeIndex == stopEdges.size())
+			break;
 
+		MapTime next = INT32_MAX;
+		if (timingIndex < m_timingPoints.size())
+			next = m_timingPoints[timingIndex]->time;
+		if (edgeIndex < stopEdges.size())
+			next = Math::Min(next, stopEdges[edgeIndex].first);
+		distance += (double)(next - time) * section.rate;
+		distanceNoStops += (double)(next - time) * section.rateNoStops;
+		time = next;
+	}
+}
+size_t BeatmapPlayback::m_FindViewDistanceSection(MapTime time) const
+{
+	auto it = std::upper_bound(m_viewDistanceSections.begin(), m_viewDistanceSections.end(), time,
+		[](MapTime t, const ViewDistanceSection& section) { return t < section.time; });
+	if (it == m_viewDistanceSections.begin())
+		return 0;
+	return (it - m_viewDistanceSections.begin()) - 1;
+}
+double BeatmapPlayback::m_TimeToViewDistance(MapTime time, bool withStops) const
+{
+	if (m_viewDistanceSections.empty())
+		return 0.0;
+
+	const ViewDistanceSection& section = m_viewDistanceSections[m_FindViewDistanceSection(time)];
+	double offset = (double)(time - section.time);
+	// Times before the first section continue at the speed of the first timing point
+	if (!withStops || time < section.time)
+		return section.distanceNoStops + offset * section.rateNoStops;
+	return section.distance + offset * section.rate;
+}
 
 LaneHideTogglePoint** BeatmapPlayback::m_SelectLaneTogglePoint(MapTime time, bool allowReset)
 {
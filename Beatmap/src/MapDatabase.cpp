@@ -2,12 +2,17 @@
 #include "MapDatabase.hpp"
 #include "Database.hpp"
 #include "Beatmap.hpp"
+#include "BeatmapCache.hpp"
 #include "TinySHA1.hpp"
+#include "sqlite3.h"
 #include "Shared/Profiling.hpp"
 #include "Shared/Files.hpp"
+#include "Shared/Jobs.hpp"
+#include "Shared/FileWatcher.hpp"
 #include <thread>
 #include <mutex>
 #include <chrono>
+#include <atomic>
 using std::thread;
 using std::mutex;
 using namespace std;
@@ -21,6 +26,12 @@ public:
 	thread m_thread;
 	bool m_searching = false;
 	bool m_interruptSearch = false;
+	// Set when the file watcher lost track of changes, a full scan is started on the next update
+	std::atomic<bool> m_rescanRequested = { false };
+	// Full text index on the Maps table, not available if sqlite was built without FTS5
+	bool m_searchIndexAvailable = false;
+	// Shorter search terms are matched with LIKE, see m_CanUseSearchIndex
+	static const size_t m_minIndexedTermLength = 4;
 	Set<String> m_searchPaths;
 	Database m_database;
 
@@ -62,10 +73,45 @@ public:
 		// Scanned map data, for added/updated maps
 		BeatmapSettings* mapData = nullptr;
 		String hash;
+		// Events from the file watcher only know the path, they are matched to the database in Update
+		bool fromWatcher = false;
+		// A removed folder, everything in it is removed
+		bool folder = false;
 	};
 	List<Event> m_pendingChanges;
 	mutex m_pendingChangesLock;
 
+	// Used to load charts in parallel while scanning, the search thread does all the work if this is not set
+	JobSheduler* m_jobSheduler = nullptr;
+	// Charts are added to this cache when they are played, the search only trims it
+	BeatmapCache* m_chartCache = nullptr;
+	// Size the chart cache is trimmed to after each search
+	static const uint64 m_maxChartCacheSize = 256 * 1024 * 1024;
+
+	// A new or changed chart found while scanning
+	struct ScanItem
+	{
+		Event evt;
+		// Already in the database
+		bool existing = false;
+		// Set after loading
+		bool valid = false;
+	};
+	// A range of scan items that is loaded as a single job
+	// whoever claims the batch first loads it, the job thread or the search thread
+	struct ScanBatch
+	{
+		size_t begin;
+		size_t end;
+		std::atomic<bool> claimed = { false };
+		std::atomic<bool> done = { false };
+		// Held by the search thread and the queued job, the last one to release it deletes it
+		std::atomic<uint32> refs = { 1 };
+	};
+	static const size_t m_scanBatchSize = 32;
+	// Batches queued on the job sheduler at the same time, leaves job threads free for jackets and other assets
+	static const size_t m_maxQueuedScanBatches = 4;
+
 	static const int32 m_version = 12;
 
 public:
@@ -140,11 +186,14 @@ public:
 			// Load initial folder tree
 			m_LoadInitialData();
 		}
+
+		m_InitSearchIndex();
 	}
 	~MapDatabase_Impl()
 	{
 		StopSearching();
 		m_CleanupMapIndex();
+		delete m_chartCache;
 
 		//discard pending changes, probably should apply them(?)
 		auto changes = FlushChanges();
@@ -161,7 +210,11 @@ public:
 			return;
 
 		if(m_thread.joinable())
+		{
+			// Stop watching for changes
+			m_interruptSearch = true;
 			m_thread.join();
+		}
 		// Apply previous diff to prevent duplicated entry 
 		Update();
 		// Create initial data set to compare to when evaluating if a file is added/removed/updated
@@ -249,25 +302,17 @@ public:
 	
 	Map<int32, MapIndex*> FindMaps(const String& searchString)
 	{
-		WString test = Utility::ConvertToWString(searchString);
-		String stmt = "SELECT rowid FROM Maps WHERE";
-
-		//search.spl
-		Vector<String> terms = searchString.Explode(" ");
-		int32 i = 0;
-		for(auto term : terms)
+		Vector<String> terms;
+		for(const String& term : searchString.Explode(" "))
 		{
-			if(i > 0)
-				stmt += " AND";
-			stmt += " (artist LIKE \"%" + term + "%\"" + 
-				" OR title LIKE \"%" + term + "%\"" +
-				" OR path LIKE \"%" + term + "%\"" +
-				" OR tags LIKE \"%" + term + "%\")";
-			i++;
+			if(!term.empty())
+				terms.Add(term);
 		}
+		if(terms.empty())
+			return m_maps;
 
+		DBStatement search = m_QueryMaps(terms);
 		Map<int32, MapIndex*> res;
-		DBStatement search = m_database.Query(stmt);
 		while(search.StepRow())
 		{
 			int32 id = search.IntColumn(0);
@@ -282,6 +327,77 @@ public:
 		return res;
 	}
 
+	// The search index only matches the start of words, and unicode61 does not split CJK text into words
+	// so it is only used for longer ASCII terms, others are matched with LIKE to keep finding any substring ("mix" in "remix")
+	static bool m_CanUseSearchIndex(const String& term)
+	{
+		if(term.size() < m_minIndexedTermLength)
+			return false;
+		for(char c : term)
+		{
+			if((uint8)c >= 0x80)
+				return false;
+		}
+		return true;
+	}
+	// Every term has to be contained in the artist, title, path or tags
+	DBStatement m_QueryMaps(const Vector<String>& terms)
+	{
+		// Each indexed term is quoted so it can't be interpreted as FTS query syntax, then made into a prefix query
+		String matchQuery;
+		Vector<String> likeTerms;
+		for(const String& term : terms)
+		{
+			if(!m_searchIndexAvailable || !m_CanUseSearchIndex(term))
+			{
+				likeTerms.Add(term);
+				continue;
+			}
+			if(!matchQuery.empty())
+				matchQuery += " ";
+			matchQuery += "\"";
+			for(char c : term)
+			{
+				if(c == '"')
+					matchQuery += "\"\"";
+				else
+					matchQuery += c;
+			}
+			matchQuery += "\"*";
+		}
+
+		// The index narrows down the maps first, LIKE only needs to check the remaining ones
+		String stmt = "SELECT rowid FROM Maps WHERE";
+		int32 param = 1;
+		if(!matchQuery.empty())
+			stmt += Utility::Sprintf(" rowid IN (SELECT rowid FROM MapSearch WHERE MapSearch MATCH ?%d)", param++);
+		for(size_t i = 0; i < likeTerms.size(); i++, param++)
+		{
+			if(param > 1)
+				stmt += " AND";
+			// Numbered parameters so the same pattern is used for all columns
+			stmt += Utility::Sprintf(" (artist LIKE ?%d ESCAPE '\\' OR title LIKE ?%d ESCAPE '\\' OR path LIKE ?%d ESCAPE '\\' OR tags LIKE ?%d ESCAPE '\\')", param, param, param, param);
+		}
+
+		DBStatement search = m_database.Query(stmt);
+		param = 1;
+		if(!matchQuery.empty())
+			search.BindString(param++, matchQuery);
+		for(const String& term : likeTerms)
+		{
+			String pattern = "%";
+			for(char c : term)
+			{
+				if(c == '%' || c == '_' || c == '\\')
+					pattern += '\\';
+				pattern += c;
+			}
+			pattern += "%";
+			search.BindString(param++, pattern);
+		}
+		return search;
+	}
+
 	Vector<String> GetCollections()
 	{
 		Vector<String> res;
@@ -349,7 +465,14 @@ public:
 	// Processes pending database changes
 	void Update()
 	{
+		if(m_rescanRequested && !m_searching)
+		{
+			m_rescanRequested = false;
+			StartSearching();
+		}
+
 		List<Event> changes = FlushChanges();
+		m_ResolveWatcherEvents(changes);
 		if(changes.empty())
 			return;
 
@@ -358,6 +481,9 @@ public:
 		DBStatement update = m_database.Query("UPDATE Difficulties SET lwt=?,metadata=?,hash=? WHERE rowid=?");
 		DBStatement removeDiff = m_database.Query("DELETE FROM Difficulties WHERE rowid=?");
 		DBStatement removeMap = m_database.Query("DELETE FROM Maps WHERE rowid=?");
+		// Maps to add to or remove from the search index
+		Vector<int32> searchAdded;
+		Vector<int32> searchRemoved;
 
 		Set<MapIndex*> addedEvents;
 		Set<MapIndex*> removeEvents;
@@ -396,6 +522,7 @@ public:
 					addMap.BindInt(5, map->id);
 					addMap.Step();
 					addMap.Rewind();
+					searchAdded.Add(map->id);
 
 					existingUpdated = false; // New map
 				}
@@ -494,6 +621,7 @@ public:
 					removeMap.BindInt(1, itMap->first);
 					removeMap.Step();
 					removeMap.Rewind();
+					searchRemoved.Add(itMap->first);
 
 					m_mapsByPath.erase(itMap->second->path);
 					m_maps.erase(itMap);
@@ -506,6 +634,8 @@ public:
 			if(e.mapData)
 				delete e.mapData;
 		}
+		if(m_searchIndexAvailable)
+			m_UpdateSearchIndex(searchAdded, searchRemoved);
 		m_database.Exec("END");
 
 		// Fire events
@@ -628,6 +758,7 @@ private:
 		m_database.Exec("DROP TABLE IF EXISTS Maps");
 		m_database.Exec("DROP TABLE IF EXISTS Difficulties");
 		m_database.Exec("DROP TABLE IF EXISTS Scores");
+		m_database.Exec("DROP TABLE IF EXISTS MapSearch");
 
 		m_database.Exec("CREATE TABLE Maps"
 			"(artist TEXT, title TEXT, tags TEXT, path TEXT)");
@@ -645,6 +776,67 @@ private:
 			"UNIQUE(collection,mapid), "
 			"FOREIGN KEY(mapid) REFERENCES Maps(rowid))");
 	}
+	// Creates the full text index used by FindMaps, and fills it if it is out of date
+	void m_InitSearchIndex()
+	{
+		m_searchIndexAvailable = false;
+		if(!sqlite3_compileoption_used("ENABLE_FTS5"))
+		{
+			Log("SQLite was built without FTS5, map search will not be indexed", Logger::Warning);
+			return;
+		}
+
+		// Prefix indices make the prefix queries used by FindMaps as fast as regular term queries
+		if(!m_database.Exec("CREATE VIRTUAL TABLE IF NOT EXISTS MapSearch USING fts5"
+			"(artist, title, path, tags, prefix='4 5', tokenize='unicode61 remove_diacritics 1')"))
+			return;
+
+		// The index can get out of sync if the database was modified by a build without FTS5,
+		// compare the row count, highest rowid and a checksum over the rowids and indexed text of both tables
+		const char* checksum = "SELECT COUNT(*), IFNULL(MAX(rowid), 0), IFNULL(SUM(rowid), 0), "
+			"TOTAL(LENGTH(artist) + LENGTH(title) + LENGTH(path) + LENGTH(tags))";
+		DBStatement countMaps = m_database.Query(Utility::Sprintf("%s FROM Maps", checksum));
+		DBStatement countSearch = m_database.Query(Utility::Sprintf("%s FROM MapSearch", checksum));
+		bool inSync = countMaps.StepRow() && countSearch.StepRow();
+		for(int32 i = 0; inSync && i < 3; i++)
+			inSync = countMaps.Int64Column(i) == countSearch.Int64Column(i);
+		inSync = inSync && countMaps.DoubleColumn(3) == countSearch.DoubleColumn(3);
+		countMaps.Finish();
+		countSearch.Finish();
+		if(!inSync)
+		{
+			Log("Rebuilding map search index", Logger::Info);
+			m_database.Exec("BEGIN");
+			m_database.Exec("DELETE FROM MapSearch");
+			m_database.Exec("INSERT INTO MapSearch(rowid,artist,title,path,tags) SELECT rowid,artist,title,path,tags FROM Maps");
+			m_database.Exec("END");
+		}
+
+		m_searchIndexAvailable = true;
+	}
+	void m_UpdateSearchIndex(const Vector<int32>& added, const Vector<int32>& removed)
+	{
+		if(!removed.empty())
+		{
+			DBStatement removeSearch = m_database.Query("DELETE FROM MapSearch WHERE rowid=?");
+			for(int32 id : removed)
+			{
+				removeSearch.BindInt(1, id);
+				removeSearch.Step();
+				removeSearch.Rewind();
+			}
+		}
+		if(!added.empty())
+		{
+			DBStatement addSearch = m_database.Query("INSERT INTO MapSearch(rowid,artist,title,path,tags) SELECT rowid,artist,title,path,tags FROM Maps WHERE rowid=?");
+			for(int32 id : added)
+			{
+				addSearch.BindInt(1, id);
+				addSearch.Step();
+				addSearch.Rewind();
+			}
+		}
+	}
 	void m_LoadInitialData()
 	{
 		assert(!m_searching);
@@ -746,6 +938,109 @@ private:
 
 		m_outer.OnMapsCleared.Call(m_maps);
 	}
+	// Matches events from the file watcher to the difficulties in the database by their path
+	void m_ResolveWatcherEvents(List<Event>& changes)
+	{
+		bool hasWatcherEvents = false;
+		for(Event& e : changes)
+			hasWatcherEvents |= e.fromWatcher;
+		if(!hasWatcherEvents)
+			return;
+
+		// Difficulties in the database that are not removed by an earlier event
+		Map<String, int32> diffIds;
+		for(auto& d : m_difficulties)
+			diffIds.Add(d.second->path, d.first);
+		// Difficulties added by an earlier event, these have no id yet
+		Map<String, List<Event>::iterator> added;
+
+		List<Event> resolved;
+		for(Event& e : changes)
+		{
+			if(!e.fromWatcher)
+			{
+				resolved.AddBack(e);
+				if(e.action == Event::Added)
+					added.Add(e.path, std::prev(resolved.end()));
+				else if(e.action == Event::Removed)
+					diffIds.erase(e.path);
+				continue;
+			}
+
+			if(e.folder)
+			{
+				const String prefix = e.path + Path::sep;
+				for(auto it = diffIds.begin(); it != diffIds.end();)
+				{
+					if(it->first.compare(0, prefix.size(), prefix) == 0)
+					{
+						Event removed;
+						removed.action = Event::Removed;
+						removed.path = it->first;
+						removed.id = it->second;
+						resolved.AddBack(removed);
+						it = diffIds.erase(it);
+					}
+					else
+						it++;
+				}
+				for(auto it = added.begin(); it != added.end();)
+				{
+					if(it->first.compare(0, prefix.size(), prefix) == 0)
+					{
+						delete it->second->mapData;
+						resolved.erase(it->second);
+						it = added.erase(it);
+					}
+					else
+						it++;
+				}
+				continue;
+			}
+
+			auto addedIt = added.find(e.path);
+			if(addedIt != added.end())
+			{
+				// Not in the database yet, replace the pending add
+				delete addedIt->second->mapData;
+				if(e.action == Event::Removed)
+				{
+					resolved.erase(addedIt->second);
+					added.erase(addedIt);
+				}
+				else
+				{
+					addedIt->second->mapData = e.mapData;
+					addedIt->second->hash = e.hash;
+					addedIt->second->lwt = e.lwt;
+				}
+				continue;
+			}
+
+			int32* id = diffIds.Find(e.path);
+			if(id)
+			{
+				e.id = *id;
+				if(e.action == Event::Added)
+					e.action = Event::Updated;
+				else if(e.action == Event::Removed)
+					diffIds.erase(e.path);
+				resolved.AddBack(e);
+			}
+			else if(e.action == Event::Added)
+			{
+				resolved.AddBack(e);
+				added.Add(e.path, std::prev(resolved.end()));
+			}
+			else if(e.mapData)
+			{
+				// Not in the database, nothing to update or remove
+				delete e.mapData;
+			}
+		}
+		changes = std::move(resolved);
+	}
+
 	void m_SortDifficulties(MapIndex* mapIndex)
 	{
 		mapIndex->difficulties.Sort([](DifficultyIndex* a, DifficultyIndex* b)
@@ -763,8 +1058,104 @@ private:
 	}
 
 	// Main search thread
+	// Loads the metadata of a chart and hashes its audio, returns false if the chart can not be used
+	bool m_ScanChart(const String& path, Event& evt)
+	{
+		File fileStream;
+		Beatmap map;
+		if(!fileStream.OpenRead(path))
+			return false;
+		FileReader reader(fileStream);
+		if(!map.Load(reader, true))
+			return false;
+
+		evt.mapData = new BeatmapSettings(map.GetMapSettings());
+
+		ProfilerScope $("Chart Database - Hash Chart Audio");
+
+		// TODO should we cache maps here for when the same file is used 3 times?
+		const String audioFile = Path::Normalize(Path::RemoveLast(path) + Path::sep + evt.mapData->audioNoFX);
+
+		File audioFileStream;
+		if(!audioFileStream.OpenRead(audioFile))
+		{
+			// If we can't open the file, the map isn't going to work, so remove it
+			return false;
+		}
+
+		char data_buffer[0x8000];
+		uint32_t digest[5];
+		sha1::SHA1 s;
+
+		size_t amount_read = 0;
+		size_t read_size;
+		do
+		{
+			read_size = audioFileStream.Read(data_buffer + amount_read, sizeof(data_buffer) - amount_read);
+			amount_read += read_size;
+		}
+		while (amount_read < sizeof(data_buffer) && read_size != 0);
+
+		s.processBytes(data_buffer, amount_read);
+		s.getDigest(digest);
+
+		evt.hash = Utility::Sprintf("%08x%08x%08x%08x%08x", digest[0], digest[1], digest[2], digest[3], digest[4]);
+		return true;
+	}
+	// Runs on a job thread or the search thread, only touches the items in the batch
+	void m_ScanBatch(Vector<ScanItem>& items, ScanBatch& batch)
+	{
+		for(size_t i = batch.begin; i < batch.end; i++)
+		{
+			if(m_interruptSearch)
+				break;
+			items[i].valid = m_ScanChart(items[i].evt.path, items[i].evt);
+		}
+		batch.done = true;
+	}
+	static void m_ReleaseBatch(ScanBatch* batch)
+	{
+		if(--batch->refs == 0)
+			delete batch;
+	}
+	void m_QueueBatch(Vector<ScanItem>& items, ScanBatch* batch)
+	{
+		batch->refs++;
+		Job job = JobBase::CreateLambda([this, &items, batch]()
+		{
+			// The items are only touched after claiming, the search thread waits for claimed batches before it releases them
+			if(!batch->claimed.exchange(true))
+				m_ScanBatch(items, *batch);
+			m_ReleaseBatch(batch);
+			return true;
+		});
+		job->jobFlags = JobFlags::IO;
+		m_jobSheduler->Queue(job);
+	}
+	// Loads the batch on this thread if no job thread has started it, otherwise waits for the job thread to finish it
+	void m_ClaimOrWaitForBatch(Vector<ScanItem>& items, ScanBatch& batch)
+	{
+		if(!batch.claimed.exchange(true))
+			m_ScanBatch(items, batch);
+		else
+			m_WaitForBatch(batch);
+	}
+	static void m_WaitForBatch(ScanBatch& batch)
+	{
+		while(!batch.done)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
 	void m_SearchThread()
 	{
+		// Start watching before scanning so changes made during the scan are not missed
+		// the polling fallback takes its initial state from the scan below instead of scanning the folders itself
+		FileWatcher watcher;
+		watcher.SetExtensionFilter("ksh");
+		bool watching = false;
+		for(const String& path : m_searchPaths)
+			watching |= watcher.Watch(path, false);
+
 		Map<String, FileInfo> fileList;
 
 		{
@@ -775,6 +1166,7 @@ private:
 				Vector<FileInfo> files = Files::ScanFilesRecursive(rootSearchPath, "ksh", &m_interruptSearch);
 				if(m_interruptSearch)
 					return;
+				watcher.AddToSnapshot(files);
 				for(FileInfo& fi : files)
 				{
 					fileList.Add(fi.fullPath, fi);
@@ -804,111 +1196,217 @@ private:
 		{
 			ProfilerScope $("Chart Database - Process New Files");
 			m_outer.OnSearchStatusUpdated.Call("[START] Chart Database - Process New Files");
-			// Process scanned files
+
+			// Collect all new and changed charts, in the order they should be added
+			Vector<ScanItem> items;
 			for(auto f : fileList)
 			{
-				if(!m_searching)
-					break;
-
 				uint64 mylwt = f.second.lastWriteTime;
-				Event evt;
-				evt.lwt = mylwt;
+				ScanItem item;
+				item.evt.lwt = mylwt;
+				item.evt.path = f.first;
 
 				SearchState::ExistingDifficulty* existing = m_searchState.difficulties.Find(f.first);
 				if(existing)
 				{
-					evt.id = existing->id;
-					if(existing->lwt != mylwt)
-					{
-						// Map Updated
-						evt.action = Event::Updated;
-					}
-					else
-					{
-						// Skip, not changed
+					// Skip, not changed
+					if(existing->lwt == mylwt)
 						continue;
-					}
+
+					// Map Updated
+					item.evt.id = existing->id;
+					item.evt.action = Event::Updated;
+					item.existing = true;
 				}
 				else
 				{
 					// Map added
-					evt.action = Event::Added;
+					item.evt.action = Event::Added;
 				}
+				items.Add(item);
+			}
 
-				Logf("Discovered Chart [%s]", Logger::Info, f.first);
-				m_outer.OnSearchStatusUpdated.Call(Utility::Sprintf("Discovered Chart [%s]", f.first));
-				// Try to read map metadata
-				bool mapValid = false;
-				File fileStream;
-				Beatmap map;
-				if(fileStream.OpenRead(f.first))
+			// Split the charts into batches that get loaded on the job threads,
+			// a single chart is too small of a job since the job threads idle between jobs
+			Vector<ScanBatch*> batches;
+			for(size_t i = 0; i < items.size(); i += m_scanBatchSize)
+			{
+				ScanBatch* batch = batches.Add(new ScanBatch());
+				batch->begin = i;
+				batch->end = Math::Min(i + m_scanBatchSize, items.size());
+			}
+
+			// Merge results back in order, this thread also loads batches no job thread has picked up yet
+			Timer scanTimer;
+			Timer statusTimer;
+			size_t numProcessed = 0;
+			size_t numMerged = 0;
+			size_t numQueued = 0;
+			for(ScanBatch* batch : batches)
+			{
+				if(!m_searching)
+					break;
+
+				// Keep a limited number of the following batches queued
+				if(m_jobSheduler)
 				{
-					FileReader reader(fileStream);
+					numQueued = Math::Max(numQueued, numMerged + 1);
+					for(; numQueued < batches.size() && numQueued <= numMerged + m_maxQueuedScanBatches; numQueued++)
+						m_QueueBatch(items, batches[numQueued]);
+				}
 
-					if(map.Load(reader, true))
+				m_ClaimOrWaitForBatch(items, *batch);
+				numMerged++;
+
+				for(size_t i = batch->begin; i < batch->end; i++)
+				{
+					ScanItem& item = items[i];
+					if(!item.valid)
 					{
-						mapValid = true;
+						if(!item.existing) // Never added
+						{
+							Logf("Skipping corrupted chart [%s]", Logger::Warning, item.evt.path);
+							m_outer.OnSearchStatusUpdated.Call(Utility::Sprintf("Skipping corrupted chart [%s]", item.evt.path));
+							if(item.evt.mapData)
+								delete item.evt.mapData;
+							continue;
+						}
+						// Invalid maps get removed from the database
+						item.evt.action = Event::Removed;
 					}
+
+					Logf("Discovered Chart [%s]", Logger::Info, item.evt.path);
+					AddChange(item.evt);
 				}
 
-				if(mapValid)
+				numProcessed = batch->end;
+				if(statusTimer.Milliseconds() > 100 || numProcessed == items.size())
 				{
-					evt.mapData = new BeatmapSettings(map.GetMapSettings());
+					statusTimer.Restart();
+					float rate = (float)numProcessed / Math::Max(scanTimer.SecondsAsFloat(), 0.001f);
+					m_outer.OnSearchStatusUpdated.Call(Utility::Sprintf("Processing Charts [%d/%d] (%.0f charts/s)", (int32)numProcessed, (int32)items.size(), rate));
+				}
+			}
 
-					ProfilerScope $("Chart Database - Hash Chart Audio");
+			// Batches that were not merged because the search was interrupted,
+			// claiming them keeps queued jobs from starting, jobs that already started stop early
+			for(size_t i = numMerged; i < batches.size(); i++)
+			{
+				ScanBatch* batch = batches[i];
+				if(batch->claimed.exchange(true))
+					m_WaitForBatch(*batch);
+				for(size_t j = batch->begin; j < batch->end; j++)
+				{
+					if(items[j].evt.mapData)
+						delete items[j].evt.mapData;
+				}
+			}
+			for(ScanBatch* batch : batches)
+				m_ReleaseBatch(batch);
 
-					// TODO should we cache maps here for when the same file is used 3 times?
-					const String audioFile = Path::Normalize(Path::RemoveLast(f.first) + Path::sep + evt.mapData->audioNoFX);
+			if(m_chartCache)
+				m_chartCache->Evict(m_maxChartCacheSize);
 
-					File audioFileStream;
-					if (audioFileStream.OpenRead(audioFile))
-					{
-						char data_buffer[0x8000];
-						uint32_t digest[5];
-						sha1::SHA1 s;
+			if(numProcessed > 0)
+				Logf("Processed %d charts in %.2fs", Logger::Info, (int32)numProcessed, scanTimer.SecondsAsFloat());
+			m_outer.OnSearchStatusUpdated.Call("[END] Chart Database - Process New Files");
+		}
+		m_outer.OnSearchStatusUpdated.Call("");
+		m_searching = false;
 
-						size_t amount_read = 0;
-						size_t read_size;
-						do
-						{
-							read_size = audioFileStream.Read(data_buffer + amount_read, sizeof(data_buffer) - amount_read);
-							amount_read += read_size;
-						}
-						while (amount_read < sizeof(data_buffer) && read_size != 0);
-						
-						s.processBytes(data_buffer, amount_read);
-						s.getDigest(digest);
+		// Keep the database up to date without walking the folders again
+		if(watching)
+			m_WatchSearchPaths(watcher);
+	}
 
-						evt.hash = Utility::Sprintf("%08x%08x%08x%08x%08x", digest[0], digest[1], digest[2], digest[3], digest[4]);
-					}
-					else
+	void m_WatchSearchPaths(FileWatcher& watcher)
+	{
+		// Charts that failed to load, these are retried when other files in their folder change
+		// since the audio files might be copied after the chart
+		Set<String> failedCharts;
+		while(!m_interruptSearch)
+		{
+			Vector<FileChange> changes = watcher.Poll(250);
+			if(changes.empty())
+				continue;
+
+			// Only the last change to each chart matters
+			Map<String, FileChange::Action> charts;
+			Set<String> changedFolders;
+			for(FileChange& c : changes)
+			{
+				if(c.action == FileChange::Overflow)
+				{
+					Log("Lost track of chart folder changes, rescanning", Logger::Warning);
+					m_rescanRequested = true;
+					return;
+				}
+				// Other files in a chart folder changed, only reported by the polling fallback
+				if(c.type == FileType::Folder && c.action == FileChange::Modified)
+				{
+					changedFolders.Add(c.fullPath);
+					continue;
+				}
+				if(c.type == FileType::Folder)
+				{
+					Event evt;
+					evt.action = Event::Removed;
+					evt.path = c.fullPath;
+					evt.fromWatcher = true;
+					evt.folder = true;
+					AddChange(evt);
+
+					// Earlier changes inside the folder no longer matter
+					const String prefix = c.fullPath + Path::sep;
+					for(auto it = charts.begin(); it != charts.end();)
 					{
-						// If we can't open the file, the map isn't going to work, so remove it
-						mapValid = false;
+						if(it->first.compare(0, prefix.size(), prefix) == 0)
+							it = charts.erase(it);
+						else
+							it++;
 					}
+					continue;
 				}
+				if(Path::GetExtension(c.fullPath) == "ksh")
+					charts[c.fullPath] = c.action;
+				else if(c.action == FileChange::Modified)
+					changedFolders.Add(Path::RemoveLast(c.fullPath));
+			}
+			for(const String& chart : failedCharts)
+			{
+				if(changedFolders.Contains(Path::RemoveLast(chart)) && !charts.Contains(chart))
+					charts.Add(chart, FileChange::Modified);
+			}
 
-				if (!mapValid)
+			for(auto& c : charts)
+			{
+				Event evt;
+				evt.path = c.first;
+				evt.fromWatcher = true;
+				evt.action = Event::Removed;
+				failedCharts.erase(c.first);
+				if(c.second == FileChange::Modified)
 				{
-					if(!existing) // Never added
+					evt.lwt = File::GetLastWriteTime(c.first);
+					if(m_ScanChart(c.first, evt))
+					{
+						Logf("Discovered Chart [%s]", Logger::Info, c.first);
+						evt.action = Event::Added;
+					}
+					else
 					{
-						Logf("Skipping corrupted chart [%s]", Logger::Warning, f.first);
-						m_outer.OnSearchStatusUpdated.Call(Utility::Sprintf("Skipping corrupted chart [%s]", f.first));
+						// Invalid charts get removed from the database if they were in it
 						if(evt.mapData)
+						{
 							delete evt.mapData;
-						continue;
+							evt.mapData = nullptr;
+						}
+						failedCharts.Add(c.first);
 					}
-					// Invalid maps get removed from the database
-					evt.action = Event::Removed;
 				}
-				evt.path = f.first;
 				AddChange(evt);
-				continue;
 			}
-			m_outer.OnSearchStatusUpdated.Call("[END] Chart Database - Process New Files");
 		}
-		m_outer.OnSearchStatusUpdated.Call("");
-		m_searching = false;
 	}
 };
 MapDatabase::MapDatabase()
@@ -927,6 +1425,15 @@ bool MapDatabase::IsSearching() const
 {
 	return m_impl->m_searching;
 }
+void MapDatabase::SetJobSheduler(JobSheduler* sheduler)
+{
+	m_impl->m_jobSheduler = sheduler;
+}
+void MapDatabase::SetChartCacheFolder(const String& folder)
+{
+	delete m_impl->m_chartCache;
+	m_impl->m_chartCache = new BeatmapCache(folder);
+}
 void MapDatabase::StartSearching()
 {
 	m_impl->StartSearching();
@@ -1,5 +1,6 @@
 #pragma once
 #include <Graphics/ResourceTypes.hpp>
+#include <Graphics/Mesh.hpp>
 
 #ifdef None
 #undef None
@@ -7,18 +8,36 @@
 
 namespace Graphics
 {
+	// Text creation statistics, used to check how much work changing text causes
+	struct TextStats
+	{
+		// Texts that were not in the cache and had their vertices built
+		uint32 textsBuilt = 0;
+		uint32 cacheHits = 0;
+		// Number of new vertex buffers created for text
+		uint32 bufferAllocations = 0;
+		uint32 glyphsUploaded = 0;
+		// Time spent building text vertices, in milliseconds
+		float buildTime = 0.0f;
+	};
+
 	/*
 		A prerendered text object, contains all the vertices and texture sheets to draw itself
+		the vertices are stored in a vertex buffer shared by all text of the same font size
 	*/
 	class TextRes
 	{
 		friend class Font_Impl;
 		struct FontSize* fontSize;
-		Ref<class MeshRes> mesh;
+		Ref<class TextVertexBuffer> buffer;
+		MeshRange range;
+		// Number of vertices reserved for this text, 0 if it owns its mesh
+		uint32 blockSize = 0;
 	public:
 		~TextRes();
 		Ref<class TextureRes> GetTexture();
-		Ref<class MeshRes> GetMesh() { return mesh; }
+		// Part of the shared vertex buffer that contains this text, empty text has no valid range
+		const MeshRange& GetMeshRange() const { return range; }
 		void Draw();
 		Vector2 size;
 	};
@@ -33,6 +52,10 @@ namespace Graphics
 		static Ref<FontRes> Create(class OpenGL* gl, const String& assetPath);
 		static bool InitLibrary();
 		static void FreeLibrary();
+
+		// Statistics of all texts created since the last call to ResetFrameStats
+		static const TextStats& GetFrameStats();
+		static void ResetFrameStats();
 	public:
 		// Text rendering options
 		enum TextOptions
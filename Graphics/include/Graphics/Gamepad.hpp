@@ -14,6 +14,10 @@ public:
 	virtual uint32 NumButtons() const = 0;
 	virtual uint32 NumAxes() const = 0;
 
+	// Reads the device state directly instead of waiting for the window event loop
+	// only call from the main thread, buttons and axes need to hold NumButtons()/NumAxes() entries
+	virtual void PollState(uint8* buttons, float* axes) = 0;
+
 	// Gamepad button event
 	Delegate<uint8> OnButtonPressed;
 	// Gamepad button event
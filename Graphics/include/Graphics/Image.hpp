@@ -14,6 +14,9 @@ namespace Graphics
 		static Ref<ImageRes> Create(const String& assetPath);
 		static Ref<ImageRes> Create(Vector2i size = Vector2i());
 		static Ref<ImageRes> Create(Buffer& b);
+		// Loads an image that is resized to targetSize if it is larger in either dimension
+		static Ref<ImageRes> Create(const String& assetPath, Vector2i targetSize);
+		static Ref<ImageRes> Create(Buffer& b, Vector2i targetSize);
 		static Ref<ImageRes> Screenshot(class OpenGL* gl, Vector2i size = Vector2i(), Vector2i pos = Vector2i());
 	public:
 		virtual void SetSize(Vector2i size) = 0;
@@ -14,5 +14,10 @@ namespace Graphics
 	public:
 		static bool Load(ImageRes* outPtr, const String& fullPath);
 		static bool Load(ImageRes* outPtr, Buffer& b);
+
+		// Loads an image and resizes it to targetSize if it is larger in either dimension
+		// JPEGs are decoded at a reduced scale and PNGs are downscaled while reading rows, so the full size image is never stored
+		static bool Load(ImageRes* outPtr, const String& fullPath, Vector2i targetSize);
+		static bool Load(ImageRes* outPtr, Buffer& b, Vector2i targetSize);
 	};
 }
\ No newline at end of file
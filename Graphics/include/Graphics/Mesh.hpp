@@ -33,6 +33,30 @@ namespace Graphics
 			SetData(verts.data(), verts.size(), T::GetDescriptors());
 		}
 
+		// Allocates space for vertexCount vertices without setting their contents
+		// the vertices can be filled in later with UpdateData
+		template<typename T>
+		void Allocate(size_t vertexCount)
+		{
+			SetData(nullptr, vertexCount, T::GetDescriptors());
+		}
+		// Overwrites part of the vertex data, starting at firstVertex
+		// the vertex type must match the one used to set or allocate the data
+		template<typename T>
+		void UpdateData(const Vector<T>& verts, size_t firstVertex)
+		{
+			UpdateData(verts.data(), firstVertex, verts.size());
+		}
+
+		// Sets the per-instance data used by DrawInstanced
+		// the instance attributes are placed after the vertex attributes and advance once per instance
+		template<typename T>
+		void SetInstanceData(const Vector<T>& instances)
+		{
+			SetInstanceData(instances.data(), instances.size(), T::GetDescriptors());
+		}
+		virtual void SetInstanceData(const void* pData, size_t instanceCount, const VertexFormatList& desc) = 0;
+
 		// Sets how the point data is interpreted and drawn
 		// must be set before drawing
 		virtual void SetPrimitiveType(PrimitiveType pt) = 0;
@@ -41,12 +65,35 @@ namespace Graphics
 		virtual void Draw() = 0;
 		// Draws the mesh after if has already been drawn once, reuse of bound objects
 		virtual void Redraw() = 0;
+		// Draws only vertexCount vertices, starting at firstVertex
+		virtual void DrawRange(size_t firstVertex, size_t vertexCount) = 0;
+		// Draws a range of the mesh after it has already been drawn once
+		virtual void RedrawRange(size_t firstVertex, size_t vertexCount) = 0;
+		// Draws the mesh once for every instance set with SetInstanceData
+		// not available on embedded platforms
+		virtual void DrawInstanced(uint32 instanceCount) = 0;
 
 	private:
 		virtual void SetData(const void* pData, size_t vertexCount, const VertexFormatList& desc) = 0;
+		virtual void UpdateData(const void* pData, size_t firstVertex, size_t vertexCount) = 0;
 	};
 
 	typedef Ref<MeshRes> Mesh;
 
+	/*
+		A range of vertices inside a mesh, used to draw part of a large shared vertex buffer
+		a vertex count of 0 draws the whole mesh
+	*/
+	struct MeshRange
+	{
+		MeshRange() = default;
+		MeshRange(Mesh mesh, uint32 firstVertex = 0, uint32 vertexCount = 0) : mesh(mesh), firstVertex(firstVertex), vertexCount(vertexCount) {}
+		bool IsValid() const { return mesh.IsValid(); }
+
+		Mesh mesh;
+		uint32 firstVertex = 0;
+		uint32 vertexCount = 0;
+	};
+
 	DEFINE_RESOURCE_TYPE(Mesh, MeshRes);
 }
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include <Graphics/Texture.hpp>
 #include <Graphics/Mesh.hpp>
 #include <Graphics/ParticleParameter.hpp>
+#include <Shared/Jobs.hpp>
+#include <atomic>
 
 namespace Graphics
 {
@@ -36,6 +38,7 @@ namespace Graphics
 #define PARTICLE_PARAMETER(__name, __type)\
 	void Set##__name(const IParticleParameter<__type>& param)\
 	{\
+		m_WaitForSimulation();\
 		if(m_param_##__name)\
 			delete m_param_##__name;\
 		m_param_##__name = param.Duplicate();\
@@ -55,21 +58,36 @@ namespace Graphics
 		// Constructed by particle system
 		ParticleEmitter(class ParticleSystem_Impl* sys);
 		void Render(const class RenderState& rs, float deltaTime);
-		void m_ReallocatePool(uint32 newCapacity);
+
+		// Emitter properties copied at the time a simulation step is started
+		// so the main thread can keep changing them while a job is running
+		struct SimulationInput
+		{
+			Vector3 position;
+			float scale;
+			float duration;
+			uint32 loops;
+			float deltaTime;
+		};
+		// Advances all particles and writes the resulting vertices to the back buffer
+		void m_Simulate(const SimulationInput& input);
+		void m_InitParticle(uint32 index, const SimulationInput& input);
+		// Waits for the simulation job started last frame, or runs it here if no worker picked it up yet
+		void m_WaitForSimulation();
 
 		float m_spawnCounter = 0;
 		float m_emitterTime = 0;
 		float m_emitterRate;
-		bool m_deactivated = false;
-		bool m_finished = false;
+		std::atomic<bool> m_deactivated;
+		std::atomic<bool> m_finished;
 		uint32 m_emitterLoopIndex = 0;
 		Mesh m_mesh;
 		friend class ParticleSystem_Impl;
-		friend class Particle;
 		ParticleSystem_Impl* m_system;
 
-		class Particle* m_particles = nullptr;
-		uint32 m_poolSize = 0;
+		// Particle pool and vertex buffers, shared with the simulation job
+		struct ParticlePool* m_pool = nullptr;
+		Job m_simulationJob;
 
 		// Particle parameters private
 #define PARTICLE_PARAMETER(__name, __type)\
@@ -19,6 +19,9 @@ namespace Graphics
 		virtual void Render(const class RenderState& rs, float deltaTime) = 0;
 		// Removes all active particle systems
 		virtual void Reset() = 0;
+		// Simulates emitters on the job sheduler one frame ahead of rendering
+		// particles are simulated on the calling thread when this is not set
+		virtual void SetJobSheduler(class JobSheduler* sheduler) = 0;
 	};
 
 	typedef Ref<ParticleSystemRes> ParticleSystem;
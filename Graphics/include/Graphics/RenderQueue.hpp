@@ -8,47 +8,29 @@ namespace Graphics
 {
 
 	using Shared::Rect;
-	/*
-		Represents a draw command that can be executed in a render queue
-	*/
-	class RenderQueueItem
-	{
-	public:
-		virtual ~RenderQueueItem() = default;
-	};
 
-	// Most basic draw command that only contains a material, it's parameters and a world transform
-	class SimpleDrawCall : public RenderQueueItem
+	// Number of draw calls and GL state changes done by processing render queues
+	struct RenderQueueStats
 	{
-	public:
-		SimpleDrawCall();
-		// The mesh to draw
-		Mesh mesh;
-		// Material to use
-		Material mat;
-		MaterialParameterSet params;
-		// The world transform
-		Transform worldTransform; 
-		// Scissor rectangle
-		Rect scissorRect;
-	};
+		uint32 drawCalls = 0;
+		// Number of times a different shader program/pipeline was bound
+		uint32 programChanges = 0;
+		uint32 blendChanges = 0;
+		uint32 scissorChanges = 0;
+		uint32 meshChanges = 0;
 
-	// Command for points/lines with size/width parameter
-	class PointDrawCall : public RenderQueueItem
-	{
-	public:
-		// List of points/lines
-		Mesh mesh;
-		Material mat;
-		MaterialParameterSet params;
-		float size;
+		uint32 GetStateChanges() const { return programChanges + blendChanges + scissorChanges + meshChanges; }
+		RenderQueueStats& operator+=(const RenderQueueStats& other);
 	};
 
 	/*
 		This class is a queue that collects draw commands
 		each of these is stored together with their wanted render state.
 
-		When Process is called, the commands are sorted and grouped, then sent to the graphics pipeline.
+		When Process is called, the commands are sent to the graphics pipeline in the order they were added,
+		or grouped by blend mode, material, scissor and mesh when sorting is enabled.
+
+		Command storage is recycled between queues, so creating a queue every frame does not allocate once the buffers have grown
 	*/
 	class RenderQueue : public Unique
 	{
@@ -64,15 +46,53 @@ namespace Graphics
 		void Clear();
 		void Draw(Transform worldTransform, Mesh m, Material mat, const MaterialParameterSet& params = MaterialParameterSet());
 		void Draw(Transform worldTransform, Ref<class TextRes> text, Material mat, const MaterialParameterSet& params = MaterialParameterSet());
+		// Draws only a range of the mesh's vertices
+		void Draw(Transform worldTransform, const MeshRange& range, Material mat, const MaterialParameterSet& params = MaterialParameterSet());
 		void DrawScissored(Rect scissor, Transform worldTransform, Mesh m, Material mat, const MaterialParameterSet& params = MaterialParameterSet());
 		void DrawScissored(Rect scissor, Transform worldTransform, Ref<class TextRes> text, Material mat, const MaterialParameterSet& params = MaterialParameterSet());
 
+		// Draws the mesh once for every element in instances with a single draw call
+		// the instance type must inherit from VertexFormat, its members are passed as vertex attributes placed after the mesh's own attributes
+		// the data is copied so the vector can be reused right away
+		template<typename T>
+		void DrawInstanced(Transform worldTransform, Mesh m, Material mat, const Vector<T>& instances, const MaterialParameterSet& params = MaterialParameterSet())
+		{
+			m_DrawInstanced(worldTransform, m, mat, params, instances.data(), sizeof(T), instances.size(), T::GetDescriptors());
+		}
+
 		// Draw for lines/points with point size parameter
 		void DrawPoints(Mesh m, Material mat, const MaterialParameterSet& params, float pointSize);
 
+		// Sorts commands to minimize shader and blend state changes before processing them, off by default
+		// only enable this when the draw order of the queued commands does not matter, e.g. opaque geometry or non-overlapping HUD elements
+		void SetSorting(bool enabled);
+
+		// Statistics of the last call to Process
+		const RenderQueueStats& GetStats() const;
+		// Statistics of all render queues processed since the last call to ResetFrameStats
+		static const RenderQueueStats& GetFrameStats();
+		static void ResetFrameStats();
+
 	private:
+		struct DrawCommand;
+		struct CommandStorage;
+		DrawCommand& m_AddCommand(const Mesh& m, const Material& mat, const MaterialParameterSet& params);
+		// Parameters of a command, adds an empty set if it has none
+		MaterialParameterSet& m_GetParams(DrawCommand& cmd);
+		void m_SetScissor(DrawCommand& cmd, const Rect& scissor);
+		void m_DrawInstanced(const Transform& worldTransform, const Mesh& m, const Material& mat, const MaterialParameterSet& params,
+			const void* instanceData, size_t instanceSize, size_t instanceCount, const VertexFormatList& format);
+		void m_ReleaseStorage();
+		// Storage of destroyed queues, reused by the next queue that draws something
+		static Vector<CommandStorage*>& m_GetFreeStorage();
+
 		RenderState m_renderState;
-		Vector<RenderQueueItem*> m_orderedCommands;
+		CommandStorage* m_storage = nullptr;
+		RenderQueueStats m_stats;
+		bool m_sorting = false;
+		// Key of the last scissor rectangle that was used
+		Rect m_lastScissor;
+		uint32 m_scissorKey = 0;
 		class OpenGL* m_ogl = nullptr;
 	};
 }
\ No newline at end of file
@@ -79,6 +79,13 @@ namespace Graphics
 
 		ModifierKeys GetModifierKeys() const;
 
+		// Time at which the input event that is currently being dispatched was generated (in SDL_GetTicks milliseconds)
+		// only valid from within input delegates such as OnKeyPressed or gamepad button events
+		uint32 GetEventTimestamp() const;
+		// Moves pending input from the OS into the event queue, which stamps the events with the current time
+		// the events are still dispatched by the next Update
+		void PumpEvents();
+
 		// Start allowing text input
 		void StartTextInput();
 		// Stop allowing text input
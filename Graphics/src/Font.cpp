@@ -6,6 +6,7 @@
 #include "Mesh.hpp"
 #include "OpenGL.hpp"
 #include <Shared/Timer.hpp>
+#include <list>
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
@@ -15,45 +16,172 @@ namespace Graphics
 	using Shared::Margin;
 	using Shared::Recti;
 
-	struct CachedText
-	{
-		Text text;
-		float lastUsage;
-	};
-	// Prevents continuous recreation of text that doesn't change
-	class TextCache : public Map<WString, CachedText>
+	// Statistics for the current frame
+	static TextStats g_textStats;
+
+	/*
+		Prevents continuous recreation of text that doesn't change
+		entries are kept in order of last use, so removing unused text only has to look at the oldest entries
+	*/
+	class TextCache
 	{
-		Timer timer;
+		struct CachedText
+		{
+			const WString* key;
+			Text text;
+			float lastUsage;
+		};
+		typedef std::list<CachedText> EntryList;
+
+		// Most recently used first
+		EntryList m_entries;
+		Map<WString, EntryList::iterator> m_lookup;
+		Timer m_timer;
+
 	public:
+		// Removes text that has not been used for over a second
 		void Update()
 		{
-			float currentTime = timer.SecondsAsFloat();
-			for(auto it = begin(); it != end();)
+			float currentTime = m_timer.SecondsAsFloat();
+			while(!m_entries.empty())
 			{
-				float durationSinceUsed = currentTime - it->second.lastUsage;
-				if(durationSinceUsed > 1.0f)
-				{
-					it = erase(it);
-					continue;
-				}
-				it++;
+				CachedText& oldest = m_entries.back();
+				if(currentTime - oldest.lastUsage <= 1.0f)
+					break;
+				m_lookup.erase(*oldest.key);
+				m_entries.pop_back();
 			}
 		}
 		Text GetText(const WString& key)
 		{
-			auto it = find(key);
-			if(it != end())
+			auto it = m_lookup.find(key);
+			if(it != m_lookup.end())
 			{
-				it->second.lastUsage = timer.SecondsAsFloat();
-				return it->second.text;
+				it->second->lastUsage = m_timer.SecondsAsFloat();
+				m_entries.splice(m_entries.begin(), m_entries, it->second);
+				return it->second->text;
 			}
 			return Text();
 		}
 		void AddText(const WString& key, Text obj)
 		{
 			Update();
-			Add(key, { obj, timer.SecondsAsFloat() });
+			auto it = m_lookup.find(key);
+			if(it != m_lookup.end())
+			{
+				m_entries.erase(it->second);
+				m_lookup.erase(it);
+			}
+			it = m_lookup.emplace(key, m_entries.end()).first;
+			m_entries.push_front({ &it->first, obj, m_timer.SecondsAsFloat() });
+			it->second = m_entries.begin();
+		}
+	};
+
+	struct TextVertex : public VertexFormat<Vector2, Vector2>
+	{
+		TextVertex(Vector2 point, Vector2 uv) : pos(point), tex(uv) {}
+		Vector2 pos;
+		Vector2 tex;
+	};
+
+	/*
+		Vertex storage shared by all text of a single font size
+		text gets a block with a power of two number of vertices out of a few large meshes,
+		released blocks are reused for the next text of the same size, so text that changes every frame does not create new meshes
+	*/
+	class TextVertexBuffer
+	{
+	public:
+		// Vertices in a single shared mesh
+		static const uint32 pageSize = 16384;
+		// Smallest block, fits 10 glyphs
+		static const uint32 minBlockSize = 64;
+		static const uint32 numBlockSizes = 9;
+
+		TextVertexBuffer(OpenGL* gl) : m_gl(gl)
+		{
+		}
+
+		// Returns a range of vertexCount vertices to write the text to
+		// blockSize is set to the number of vertices reserved, which needs to be passed to Free
+		MeshRange Allocate(uint32 vertexCount, uint32& blockSize)
+		{
+			uint32 sizeIndex = 0;
+			blockSize = minBlockSize;
+			while(blockSize < vertexCount)
+			{
+				blockSize <<= 1;
+				sizeIndex++;
+			}
+
+			if(sizeIndex >= numBlockSizes)
+			{
+				// Too large to share a mesh
+				blockSize = 0;
+				return MeshRange(m_CreateMesh(vertexCount), 0, vertexCount);
+			}
+
+			Vector<MeshRange>& freeBlocks = m_freeBlocks[sizeIndex];
+			if(!freeBlocks.empty())
+			{
+				MeshRange range = freeBlocks.back();
+				freeBlocks.pop_back();
+				range.vertexCount = vertexCount;
+				return range;
+			}
+
+			if(!m_currentPage || m_pageUsed + blockSize > pageSize)
+			{
+				if(m_currentPage)
+					m_ReleaseRemainder();
+				m_currentPage = m_CreateMesh(pageSize);
+				m_pageUsed = 0;
+			}
+
+			MeshRange range(m_currentPage, m_pageUsed, vertexCount);
+			m_pageUsed += blockSize;
+			return range;
+		}
+		void Free(const MeshRange& range, uint32 blockSize)
+		{
+			if(blockSize == 0)
+				return; // Owns its mesh
+
+			uint32 sizeIndex = 0;
+			while((minBlockSize << sizeIndex) < blockSize)
+				sizeIndex++;
+			assert(sizeIndex < numBlockSizes);
+			m_freeBlocks[sizeIndex].Add(MeshRange(range.mesh, range.firstVertex, blockSize));
+		}
+
+	private:
+		// Splits the unused end of the current page into free blocks
+		void m_ReleaseRemainder()
+		{
+			for(int32 i = numBlockSizes - 1; i >= 0; i--)
+			{
+				uint32 blockSize = minBlockSize << i;
+				while(m_pageUsed + blockSize <= pageSize)
+				{
+					m_freeBlocks[i].Add(MeshRange(m_currentPage, m_pageUsed, blockSize));
+					m_pageUsed += blockSize;
+				}
+			}
 		}
+		Mesh m_CreateMesh(uint32 vertexCount)
+		{
+			Mesh mesh = MeshRes::Create(m_gl);
+			mesh->Allocate<TextVertex>(vertexCount);
+			mesh->SetPrimitiveType(PrimitiveType::TriangleList);
+			g_textStats.bufferAllocations++;
+			return mesh;
+		}
+
+		OpenGL* m_gl;
+		Mesh m_currentPage;
+		uint32 m_pageUsed = 0;
+		Vector<MeshRange> m_freeBlocks[numBlockSizes];
 	};
 
 	FT_Library library;
@@ -81,15 +209,18 @@ namespace Graphics
 		FT_Face face;
 		Vector<CharInfo> infos;
 		Map<wchar_t, uint32> infoByChar;
-		bool bUpdated = false;
 		float lineHeight;
 		TextCache cache;
+		Ref<TextVertexBuffer> vertexBuffer;
+		// Reused for building the vertices of new text
+		Vector<TextVertex> vertices;
 
 		FontSize(OpenGL* gl, FT_Face& face)
 			: face(face), m_gl(gl)
 		{
 			spriteMap = SpriteMapRes::Create();
-			textureMap = TextureRes::Create(m_gl);
+			textureMap = m_CreateTexture();
+			vertexBuffer = Utility::MakeRef(new TextVertexBuffer(m_gl));
 			lineHeight = (float)face->size->metrics.height / 64.0f;
 		}
 		~FontSize()
@@ -103,19 +234,46 @@ namespace Graphics
 				return AddCharInfo(t);
 			return infos[it->second];
 		}
+		// New glyphs are uploaded into the current atlas texture
+		// when the sprite map grows a new texture is created, text that is already queued this frame keeps the old one with the size it was queued with
 		Texture GetTextureMap()
 		{
-			if(bUpdated)
+			Image atlas = spriteMap->GetImage();
+			const Vector2i& textureSize = textureMap->GetSize();
+			if(textureSize.x != atlas->GetSize().x || textureSize.y != atlas->GetSize().y)
 			{
-				textureMap = spriteMap->GenerateTexture(m_gl);
-				bUpdated = false;
+				textureMap = m_CreateTexture();
+				textureMap->SetData(atlas->GetSize(), atlas->GetBits());
+				m_pendingGlyphs.clear();
+			}
+			else
+			{
+				for(const PendingGlyph& glyph : m_pendingGlyphs)
+				{
+					textureMap->SetSubData(glyph.pos, glyph.image->GetSize(), glyph.image->GetBits());
+				}
+				m_pendingGlyphs.clear();
 			}
 			return textureMap;
 		}
 	private:
+		struct PendingGlyph
+		{
+			Image image;
+			Vector2i pos;
+		};
+		// Glyphs added to the sprite map that are not in the texture yet
+		Vector<PendingGlyph> m_pendingGlyphs;
+
+		Texture m_CreateTexture()
+		{
+			Texture texture = TextureRes::Create(m_gl);
+			texture->SetWrap(TextureWrap::Clamp, TextureWrap::Clamp);
+			return texture;
+		}
+
 		const CharInfo& AddCharInfo(wchar_t t)
 		{
-			bUpdated = true;
 			infoByChar.Add(t, (uint32)infos.size());
 			infos.emplace_back();
 			CharInfo& ci = infos.back();
@@ -152,6 +310,11 @@ namespace Graphics
 			}
 			uint32 nIndex = spriteMap->AddSegment(img);
 			ci.coords = spriteMap->GetCoords(nIndex);
+			if(ci.coords.size.x > 0 && ci.coords.size.y > 0)
+			{
+				m_pendingGlyphs.Add({ img, ci.coords.pos });
+				g_textStats.glyphsUploaded++;
+			}
 
 			return ci;
 		}
@@ -162,6 +325,8 @@ namespace Graphics
 
 	TextRes::~TextRes()
 	{
+		if(range.IsValid())
+			buffer->Free(range, blockSize);
 	}
 
 	Ref<class TextureRes> TextRes::GetTexture()
@@ -170,8 +335,10 @@ namespace Graphics
 	}
 	void TextRes::Draw()
 	{
+		if(!range.IsValid())
+			return;
 		GetTexture()->Bind();
-		mesh->Draw();
+		range.mesh->DrawRange(range.firstVertex, range.vertexCount);
 	}
 
 	class Font_Impl : public FontRes
@@ -248,21 +415,18 @@ namespace Graphics
 
 			Text cachedText = size->cache.GetText(str);
 			if(cachedText)
-				return cachedText;
-
-			struct TextVertex : public VertexFormat<Vector2, Vector2>
 			{
-				TextVertex(Vector2 point, Vector2 uv) : pos(point), tex(uv) {}
-				Vector2 pos;
-				Vector2 tex;
-			};
+				g_textStats.cacheHits++;
+				return cachedText;
+			}
 
+			Timer buildTimer;
 			TextRes* ret = new TextRes();
-			ret->mesh = MeshRes::Create(m_gl);
 
 			float monospaceWidth = size->GetCharInfo(L'_').advance;
 
-			Vector<TextVertex> vertices;
+			Vector<TextVertex>& vertices = size->vertices;
+			vertices.clear();
 			Vector2 pen;
 			for(wchar_t c : str)
 			{
@@ -327,8 +491,15 @@ namespace Graphics
 			ret->size.y += size->lineHeight;
 
 			ret->fontSize = size;
-			ret->mesh->SetData(vertices);
-			ret->mesh->SetPrimitiveType(PrimitiveType::TriangleList);
+			ret->buffer = size->vertexBuffer;
+			if(!vertices.empty())
+			{
+				ret->range = size->vertexBuffer->Allocate((uint32)vertices.size(), ret->blockSize);
+				ret->range.mesh->UpdateData(vertices, ret->range.firstVertex);
+			}
+
+			g_textStats.textsBuilt++;
+			g_textStats.buildTime += (float)buildTimer.Microseconds() / 1000.0f;
 
 			Text textObj = Ref<TextRes>(ret);
 			// Insert into cache
@@ -351,6 +522,15 @@ namespace Graphics
 		}
 	}
 
+	const TextStats& FontRes::GetFrameStats()
+	{
+		return g_textStats;
+	}
+	void FontRes::ResetFrameStats()
+	{
+		g_textStats = TextStats();
+	}
+
 	bool FontRes::InitLibrary()
 	{
 		if(!FT_Init_FreeType(&library) == FT_Err_Ok)
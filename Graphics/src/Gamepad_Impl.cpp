@@ -71,4 +71,12 @@ namespace Graphics
 	{
 		return (uint32)m_axisState.size();
 	}
+	void Gamepad_Impl::PollState(uint8* buttons, float* axes)
+	{
+		SDL_JoystickUpdate();
+		for(uint32 i = 0; i < (uint32)m_buttonStates.size(); i++)
+			buttons[i] = SDL_JoystickGetButton(m_joystick, i);
+		for(uint32 i = 0; i < (uint32)m_axisState.size(); i++)
+			axes[i] = (float)SDL_JoystickGetAxis(m_joystick, i) / (float)0x7fff;
+	}
 }
\ No newline at end of file
@@ -28,5 +28,6 @@ namespace Graphics
 		virtual float GetAxis(uint8 idx) const override;
 		virtual uint32 NumButtons() const override;
 		virtual uint32 NumAxes() const override;
+		virtual void PollState(uint8* buttons, float* axes) override;
 	};
 }
\ No newline at end of file
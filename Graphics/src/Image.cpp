@@ -54,11 +54,37 @@ namespace Graphics
 			}
 			Colori* new_pData = new Colori[new_DataLength];
 
-			for (int32 ix = 0; ix < size.x; ++ix){
-				for (int32 iy = 0; iy < size.y; ++iy){
-					int32 sampledX = ix * ((double)m_size.x / (double)size.x);
-					int32 sampledY = iy * ((double)m_size.y / (double)size.y);
-					new_pData[size.x * iy + ix] = m_pData[m_size.x * sampledY + sampledX];
+			// Every destination pixel is the average of the source pixels it covers (box filter)
+			// when enlarging this covers a single pixel, which is the same as nearest neighbour sampling
+			Vector<int32> columnStart(size.x + 1);
+			for (int32 ix = 0; ix <= size.x; ++ix){
+				columnStart[ix] = (int32)((int64)ix * m_size.x / size.x);
+			}
+
+			for (int32 iy = 0; iy < size.y; ++iy){
+				int32 y0 = (int32)((int64)iy * m_size.y / size.y);
+				int32 y1 = Math::Max(y0 + 1, (int32)((int64)(iy + 1) * m_size.y / size.y));
+				for (int32 ix = 0; ix < size.x; ++ix){
+					int32 x0 = columnStart[ix];
+					int32 x1 = Math::Max(x0 + 1, columnStart[ix + 1]);
+
+					uint32 sum[4] = { 0 };
+					for (int32 sy = y0; sy < y1; ++sy){
+						const Colori* pSrc = m_pData + m_size.x * sy;
+						for (int32 sx = x0; sx < x1; ++sx){
+							sum[0] += pSrc[sx].x;
+							sum[1] += pSrc[sx].y;
+							sum[2] += pSrc[sx].z;
+							sum[3] += pSrc[sx].w;
+						}
+					}
+
+					uint32 count = (uint32)((x1 - x0) * (y1 - y0));
+					Colori& dst = new_pData[size.x * iy + ix];
+					dst.x = (uint8)((sum[0] + count / 2) / count);
+					dst.y = (uint8)((sum[1] + count / 2) / count);
+					dst.z = (uint8)((sum[2] + count / 2) / count);
+					dst.w = (uint8)((sum[3] + count / 2) / count);
 				}
 			}
 
@@ -206,6 +232,26 @@ namespace Graphics
 		}
 		return Image();
 	}
+	Image ImageRes::Create(const String& assetPath, Vector2i targetSize)
+	{
+		Image_Impl* pImpl = new Image_Impl();
+		if(ImageLoader::Load(pImpl, assetPath, targetSize))
+		{
+			return GetResourceManager<ResourceType::Image>().Register(pImpl);
+		}
+		delete pImpl;
+		return Image();
+	}
+	Image ImageRes::Create(Buffer& b, Vector2i targetSize)
+	{
+		Image_Impl* pImpl = new Image_Impl();
+		if(ImageLoader::Load(pImpl, b, targetSize))
+		{
+			return GetResourceManager<ResourceType::Image>().Register(pImpl);
+		}
+		delete pImpl;
+		return Image();
+	}
 	Image ImageRes::Screenshot(OpenGL* gl, Vector2i size, Vector2i pos)
 	{
 		Image_Impl* pImpl = new Image_Impl();
@@ -46,7 +46,15 @@ namespace Graphics
 		{
 		}
 
-		bool LoadJPEG(ImageRes* pImage, Buffer& in)
+		// True if an image of this size has to be shrunk to targetSize, a target of 0 keeps the full size
+		static bool NeedsResize(Vector2i size, Vector2i targetSize)
+		{
+			if(targetSize.x <= 0 || targetSize.y <= 0)
+				return false;
+			return size.x > targetSize.x || size.y > targetSize.y;
+		}
+
+		bool LoadJPEG(ImageRes* pImage, Buffer& in, Vector2i targetSize)
 		{
 
 			/* This struct contains the JPEG decompression parameters and pointers to
@@ -68,6 +76,18 @@ namespace Graphics
 				jpeg_mem_src(&cinfo, in.data(), (uint32)in.size());
 				int res = jpeg_read_header(&cinfo, TRUE);
 
+				// Let the IDCT skip detail that would be lost by resizing anyway,
+				// the largest power of two reduction that still leaves at least the target size is used
+				bool resize = NeedsResize(Vector2i(cinfo.image_width, cinfo.image_height), targetSize);
+				if(resize)
+				{
+					uint32 denom = 1;
+					while(denom < 8 && (int32)(cinfo.image_width / (denom * 2)) >= targetSize.x && (int32)(cinfo.image_height / (denom * 2)) >= targetSize.y)
+						denom *= 2;
+					cinfo.scale_num = 1;
+					cinfo.scale_denom = denom;
+				}
+
 				jpeg_start_decompress(&cinfo);
 				int row_stride = cinfo.output_width * cinfo.output_components;
 				JSAMPARRAY sample = (*cinfo.mem->alloc_sarray)
@@ -94,13 +114,144 @@ namespace Graphics
 
 				jpeg_finish_decompress(&cinfo);
 				jpeg_destroy_decompress(&cinfo);
+
+				if(resize)
+					pImage->ReSize(targetSize);
 				return true;
 			}
 			
 			// If we get here, the loading of the jpeg failed
 			return false;
 		}
-		bool LoadPNG(ImageRes* pImage, Buffer& in)
+		struct PNGReadState
+		{
+			const uint8* data;
+			size_t size;
+			size_t offset;
+		};
+		static void pngWarning(png_structp png, png_const_charp message)
+		{
+		}
+		static void pngReadFromMemory(png_structp png, png_bytep out, png_size_t count)
+		{
+			PNGReadState* state = (PNGReadState*)png_get_io_ptr(png);
+			if(state->offset + count > state->size)
+				png_error(png, "Read past the end of the image data");
+			memcpy(out, state->data + state->offset, count);
+			state->offset += count;
+		}
+
+		// Decodes one row at a time and averages the rows and columns that fall into each target pixel (box filter)
+		// only a single source row is kept in memory
+		bool LoadPNGScaled(ImageRes* pImage, Buffer& in, Vector2i targetSize)
+		{
+			png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, &pngWarning);
+			if(!png)
+				return false;
+			png_infop info = png_create_info_struct(png);
+			if(!info)
+			{
+				png_destroy_read_struct(&png, nullptr, nullptr);
+				return false;
+			}
+
+			// Declared before setjmp, libpng errors jump back past anything created later
+			Vector<uint8> row;
+			Vector<uint32> sums;
+			Vector<int32> columnStart;
+			PNGReadState state = { in.data(), in.size(), 0 };
+
+			if(setjmp(png_jmpbuf(png)))
+			{
+				png_destroy_read_struct(&png, &info, nullptr);
+				return false;
+			}
+
+			png_set_read_fn(png, &state, &pngReadFromMemory);
+			png_read_info(png, info);
+
+			// Interlaced images need the whole image to be decoded
+			if(png_get_interlace_type(png, info) != PNG_INTERLACE_NONE)
+			{
+				png_destroy_read_struct(&png, &info, nullptr);
+				return false;
+			}
+
+			// Convert everything to RGBA8
+			png_set_expand(png);
+			png_set_strip_16(png);
+			png_set_gray_to_rgb(png);
+			png_set_add_alpha(png, 0xFF, PNG_FILLER_AFTER);
+			png_read_update_info(png, info);
+
+			Vector2i size = Vector2i(png_get_image_width(png, info), png_get_image_height(png, info));
+			if(png_get_rowbytes(png, info) != size.x * sizeof(Colori))
+			{
+				png_destroy_read_struct(&png, &info, nullptr);
+				return false;
+			}
+
+			row.resize(size.x * sizeof(Colori));
+			sums.resize(targetSize.x * 4);
+			columnStart.resize(targetSize.x + 1);
+			for(int32 ix = 0; ix <= targetSize.x; ix++)
+				columnStart[ix] = (int32)((int64)ix * size.x / targetSize.x);
+
+			pImage->SetSize(targetSize);
+			Colori* pBits = pImage->GetBits();
+
+			int32 iy = 0;
+			for(int32 sy = 0; sy < size.y; sy++)
+			{
+				png_read_row(png, row.data(), nullptr);
+
+				// A source row contributes to multiple target rows when the height is enlarged
+				while(iy < targetSize.y)
+				{
+					int32 y0 = (int32)((int64)iy * size.y / targetSize.y);
+					int32 y1 = Math::Max(y0 + 1, (int32)((int64)(iy + 1) * size.y / targetSize.y));
+					if(y0 > sy)
+						break;
+
+					for(int32 ix = 0; ix < targetSize.x; ix++)
+					{
+						int32 x0 = columnStart[ix];
+						int32 x1 = Math::Max(x0 + 1, columnStart[ix + 1]);
+						uint32* sum = &sums[ix * 4];
+						for(int32 sx = x0; sx < x1; sx++)
+						{
+							const uint8* src = &row[sx * 4];
+							sum[0] += src[0];
+							sum[1] += src[1];
+							sum[2] += src[2];
+							sum[3] += src[3];
+						}
+					}
+
+					if(y1 > sy + 1)
+						break; // Needs more source rows
+
+					Colori* pDst = pBits + iy * targetSize.x;
+					for(int32 ix = 0; ix < targetSize.x; ix++)
+					{
+						int32 x0 = columnStart[ix];
+						int32 x1 = Math::Max(x0 + 1, columnStart[ix + 1]);
+						uint32 count = (uint32)((x1 - x0) * (y1 - y0));
+						uint32* sum = &sums[ix * 4];
+						pDst[ix].x = (uint8)((sum[0] + count / 2) / count);
+						pDst[ix].y = (uint8)((sum[1] + count / 2) / count);
+						pDst[ix].z = (uint8)((sum[2] + count / 2) / count);
+						pDst[ix].w = (uint8)((sum[3] + count / 2) / count);
+					}
+					std::fill(sums.begin(), sums.end(), 0);
+					iy++;
+				}
+			}
+
+			png_destroy_read_struct(&png, &info, nullptr);
+			return iy == targetSize.y;
+		}
+		bool LoadPNG(ImageRes* pImage, Buffer& in, Vector2i targetSize)
 		{
 			png_image image;
 			memset(&image, 0, (sizeof image));
@@ -109,6 +260,19 @@ namespace Graphics
 			if(png_image_begin_read_from_memory(&image, in.data(), in.size()) == 0)
 				return false;
 
+			if(NeedsResize(Vector2i(image.width, image.height), targetSize))
+			{
+				png_image_free(&image);
+				if(LoadPNGScaled(pImage, in, targetSize))
+					return true;
+
+				// Fall back to decoding the full image
+				memset(&image, 0, (sizeof image));
+				image.version = PNG_IMAGE_VERSION;
+				if(png_image_begin_read_from_memory(&image, in.data(), in.size()) == 0)
+					return false;
+			}
+
 			image.format = PNG_FORMAT_RGBA;
 
 			pImage->SetSize(Vector2i(image.width, image.height));
@@ -123,9 +287,12 @@ namespace Graphics
 				return false;
 
 			png_image_free(&image);
+
+			if(NeedsResize(pImage->GetSize(), targetSize))
+				pImage->ReSize(targetSize);
 			return true;
 		}
-		bool Load(ImageRes* pImage, const String& fullPath)
+		bool Load(ImageRes* pImage, const String& fullPath, Vector2i targetSize)
 		{
 			File f;
 			if(!f.OpenRead(fullPath))
@@ -136,16 +303,16 @@ namespace Graphics
 			if(b.size() < 4)
 				return false;
 
-			return Load(pImage, b);
+			return Load(pImage, b, targetSize);
 		}
 
-		bool Load(ImageRes* pImage, Buffer& b)
+		bool Load(ImageRes* pImage, Buffer& b, Vector2i targetSize)
 		{
 			// Check for PNG based on first 4 bytes
 			if (*(uint32*)b.data() == (uint32&)"\x89PNG")
-				return LoadPNG(pImage, b);
+				return LoadPNG(pImage, b, targetSize);
 			else // jay-PEG ?
-				return LoadJPEG(pImage, b);
+				return LoadJPEG(pImage, b, targetSize);
 		}
 
 		static ImageLoader_Impl& Main()
@@ -158,11 +325,21 @@ namespace Graphics
 
 	bool ImageLoader::Load(ImageRes* pImage, const String& fullPath)
 	{
-		return ImageLoader_Impl::Main().Load(pImage, fullPath);
+		return ImageLoader_Impl::Main().Load(pImage, fullPath, Vector2i());
 	}
 
 	bool ImageLoader::Load(ImageRes* pImage, Buffer& b)
 	{
-		return ImageLoader_Impl::Main().Load(pImage, b);
+		return ImageLoader_Impl::Main().Load(pImage, b, Vector2i());
+	}
+
+	bool ImageLoader::Load(ImageRes* pImage, const String& fullPath, Vector2i targetSize)
+	{
+		return ImageLoader_Impl::Main().Load(pImage, fullPath, targetSize);
+	}
+
+	bool ImageLoader::Load(ImageRes* pImage, Buffer& b, Vector2i targetSize)
+	{
+		return ImageLoader_Impl::Main().Load(pImage, b, targetSize);
 	}
 }
\ No newline at end of file
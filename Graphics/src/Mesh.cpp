@@ -16,10 +16,15 @@ namespace Graphics
 	class Mesh_Impl : public MeshRes
 	{
 		uint32 m_buffer = 0;
+		uint32 m_instanceBuffer = 0;
 		uint32 m_vao = 0;
+		// Number of attributes used by the vertex data, instance attributes start after these
+		uint32 m_numVertexAttributes = 0;
+		uint32 m_numInstanceAttributes = 0;
 		PrimitiveType m_type;
 		uint32 m_glType;
 		size_t m_vertexCount;
+		size_t m_vertexSize = 0;
 		bool m_bDynamic = true;
 	public:
 		Mesh_Impl()
@@ -29,6 +34,8 @@ namespace Graphics
 		{
 			if(m_buffer)
 				glDeleteBuffers(1, &m_buffer);
+			if(m_instanceBuffer)
+				glDeleteBuffers(1, &m_instanceBuffer);
 			if(m_vao)
 				glDeleteVertexArrays(1, &m_vao);
 		}
@@ -39,16 +46,14 @@ namespace Graphics
 			return m_buffer != 0 && m_vao != 0;
 		}
 
-		virtual void SetData(const void* pData, size_t vertexCount, const VertexFormatList& desc)
+		// Sets up the attribute pointers for the buffer that is currently bound, starting at firstIndex
+		// returns the size of a single element
+		static size_t SetupAttributes(const VertexFormatList& desc, uint32 firstIndex, uint32 divisor)
 		{
-			glBindVertexArray(m_vao);
-			glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
-
-			m_vertexCount = vertexCount;
 			size_t totalVertexSize = 0;
 			for(auto e : desc)
 				totalVertexSize += e.componentSize * e.components;
-			size_t index = 0;
+			size_t index = firstIndex;
 			size_t offset = 0;
 			for(auto e : desc)
 			{
@@ -76,15 +81,69 @@ namespace Graphics
 				assert(type != -1);
 				glVertexAttribPointer((int)index, (int)e.components, type, GL_TRUE, (int)totalVertexSize, (void*)offset);
 				glEnableVertexAttribArray((int)index);
+				#ifndef EMBEDDED
+				glVertexAttribDivisor((int)index, divisor);
+				#else
+				assert(divisor == 0);
+				#endif
 				offset += e.componentSize * e.components;
 				index++;
 			}
+			return totalVertexSize;
+		}
+
+		virtual void SetData(const void* pData, size_t vertexCount, const VertexFormatList& desc)
+		{
+			glBindVertexArray(m_vao);
+			glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+
+			// Instance attributes need to be set again after the vertex format changed
+			for(uint32 i = 0; i < m_numInstanceAttributes; i++)
+				glDisableVertexAttribArray((int)(m_numVertexAttributes + i));
+			m_numInstanceAttributes = 0;
+
+			m_vertexCount = vertexCount;
+			m_numVertexAttributes = (uint32)desc.size();
+			size_t totalVertexSize = SetupAttributes(desc, 0, 0);
+			m_vertexSize = totalVertexSize;
 			glBufferData(GL_ARRAY_BUFFER, totalVertexSize * vertexCount, pData, m_bDynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
 
 			glBindVertexArray(0);
 			glBindBuffer(GL_ARRAY_BUFFER, 0);
 		}
-		
+
+		virtual void UpdateData(const void* pData, size_t firstVertex, size_t vertexCount) override
+		{
+			assert(firstVertex + vertexCount <= m_vertexCount);
+			glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+			glBufferSubData(GL_ARRAY_BUFFER, m_vertexSize * firstVertex, m_vertexSize * vertexCount, pData);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+		}
+
+		virtual void SetInstanceData(const void* pData, size_t instanceCount, const VertexFormatList& desc) override
+		{
+			#ifdef EMBEDDED
+			assert(false);
+			#else
+			if(!m_instanceBuffer)
+				glGenBuffers(1, &m_instanceBuffer);
+			glBindVertexArray(m_vao);
+			glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+
+			// Disable attributes left over from a previous format that had more of them
+			for(uint32 i = (uint32)desc.size(); i < m_numInstanceAttributes; i++)
+				glDisableVertexAttribArray((int)(m_numVertexAttributes + i));
+			m_numInstanceAttributes = (uint32)desc.size();
+
+			size_t instanceSize = SetupAttributes(desc, m_numVertexAttributes, 1);
+			// Instance data changes every time it is drawn, so the old storage is orphaned instead of waiting for it
+			glBufferData(GL_ARRAY_BUFFER, instanceSize * instanceCount, pData, GL_STREAM_DRAW);
+
+			glBindVertexArray(0);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			#endif
+		}
+
 		#ifdef EMBEDDED
 		virtual void Draw()
 		{
@@ -98,6 +157,16 @@ namespace Graphics
 			glDrawArrays(m_glType, 0, (int)m_vertexCount);
 			glBindVertexArray(0);
 		}
+		virtual void DrawRange(size_t firstVertex, size_t vertexCount) override
+		{
+			glBindVertexArray(m_vao);
+			glDrawArrays(m_glType, (int)firstVertex, (int)vertexCount);
+			glBindVertexArray(0);
+		}
+		virtual void RedrawRange(size_t firstVertex, size_t vertexCount) override
+		{
+			DrawRange(firstVertex, vertexCount);
+		}
 		#else
 		virtual void Draw()
 		{
@@ -108,7 +177,25 @@ namespace Graphics
 		{
 			glDrawArrays(m_glType, 0, (int)m_vertexCount);
 		}
+		virtual void DrawRange(size_t firstVertex, size_t vertexCount) override
+		{
+			glBindVertexArray(m_vao);
+			glDrawArrays(m_glType, (int)firstVertex, (int)vertexCount);
+		}
+		virtual void RedrawRange(size_t firstVertex, size_t vertexCount) override
+		{
+			glDrawArrays(m_glType, (int)firstVertex, (int)vertexCount);
+		}
 		#endif
+		virtual void DrawInstanced(uint32 instanceCount) override
+		{
+			#ifdef EMBEDDED
+			assert(false);
+			#else
+			glBindVertexArray(m_vao);
+			glDrawArraysInstanced(m_glType, 0, (int)m_vertexCount, (int)instanceCount);
+			#endif
+		}
 
 		virtual void SetPrimitiveType(PrimitiveType pt)
 		{
@@ -25,6 +25,7 @@ namespace Graphics
 
 	public:
 		OpenGL* gl;
+		JobSheduler* sheduler = nullptr;
 
 	public:
 		virtual void Render(const class RenderState& rs, float deltaTime) override
@@ -69,6 +70,11 @@ namespace Graphics
 			}
 			m_emitters.clear();
 		}
+		virtual void SetJobSheduler(JobSheduler* newSheduler) override
+		{
+			// Emitters started with the old sheduler wait for their job on the next render
+			sheduler = newSheduler;
+		}
 	};
 
 	Ref<ParticleSystemRes> ParticleSystemRes::Create(class OpenGL* gl)
@@ -79,67 +85,77 @@ namespace Graphics
 	}
 
 
-	// Particle instance class
-	class Particle
+	/*
+		Particle data stored as a structure of arrays
+		every stream holds one float per particle so the integration loop can be vectorized
+	*/
+	struct ParticlePool
 	{
-	public:
-		float life = 0.0f;
-		float maxLife = 0.0f;
-		float rotation = 0.0f;
-		float startSize = 0.0f;
-		Color startColor;
-		Vector3 pos;
-		Vector3 velocity;
-		float scale;
-		float fade;
-		float drag;
-		
-
-		bool IsAlive() const
+		enum Stream
 		{
-			return life > 0.0f;
-		}
-		inline void Init(ParticleEmitter* emitter)
+			Life = 0,
+			InvMaxLife,
+			// Normalized particle age at the start of the last simulation step
+			Progress,
+			// Time step applied to each particle in the last simulation step
+			Step,
+			PositionX,
+			PositionY,
+			PositionZ,
+			VelocityX,
+			VelocityY,
+			VelocityZ,
+			Drag,
+			Rotation,
+			StartSize,
+			ColorR,
+			ColorG,
+			ColorB,
+			ColorA,
+			NumStreams
+		};
+
+		Vector<float> storage;
+		float* streams[NumStreams] = { nullptr };
+		uint32 capacity = 0;
+
+		// Particles that are drawn this frame
+		Vector<uint32> visible;
+
+		// Vertices written by the simulation and vertices uploaded on the main thread
+		Vector<ParticleVertex> simulatedVertices;
+		Vector<ParticleVertex> renderVertices;
+
+		float* operator[](Stream stream)
 		{
-			const float& et = emitter->m_emitterRate;
-			life = maxLife = emitter->m_param_Lifetime->Init(et);
-			pos = emitter->m_param_StartPosition->Init(et) * emitter->scale;
-
-			// Velocity of startvelocity and spawn offset scale
-			velocity = emitter->m_param_StartVelocity->Init(et) * emitter->scale;
-			float spawnVelScale = emitter->m_param_SpawnVelocityScale->Init(et);
-			if(spawnVelScale > 0)
-				velocity += pos.Normalized() * spawnVelScale  * emitter->scale;
-
-			// Add emitter offset to location
-			pos += emitter->position;
-
-			startColor = emitter->m_param_StartColor->Init(et);
-			rotation = emitter->m_param_StartRotation->Init(et);
-			startSize = emitter->m_param_StartSize->Init(et) * emitter->scale;
-			drag = emitter->m_param_StartDrag->Init(et);
+			return streams[stream];
 		}
-		inline void Simulate(ParticleEmitter* emitter, float deltaTime)
+		void Reallocate(uint32 newCapacity)
 		{
-			float c = 1 - life / maxLife;
-
-			// Add gravity
-			velocity += emitter->m_param_Gravity->Sample(emitter->m_emitterTime) * deltaTime * emitter->scale;
-			pos += velocity * deltaTime;
+			Vector<float> newStorage;
+			newStorage.resize(newCapacity * NumStreams, 0.0f);
 
-			// Add drag
-			velocity += -velocity * deltaTime * drag;
+			uint32 keep = Math::Min(capacity, newCapacity);
+			for(uint32 i = 0; i < NumStreams; i++)
+			{
+				if(keep > 0)
+					memcpy(newStorage.data() + i * newCapacity, streams[i], keep * sizeof(float));
+			}
 
-			fade = emitter->m_param_FadeOverTime->Sample(c);
-			scale = emitter->m_param_ScaleOverTime->Sample(c);
-			life -= deltaTime;
+			storage = std::move(newStorage);
+			capacity = newCapacity;
+			for(uint32 i = 0; i < NumStreams; i++)
+			{
+				streams[i] = capacity > 0 ? storage.data() + i * capacity : nullptr;
+			}
 		}
 	};
 
-	ParticleEmitter::ParticleEmitter(ParticleSystem_Impl* sys) : m_system(sys)
+	ParticleEmitter::ParticleEmitter(ParticleSystem_Impl* sys) : m_deactivated(false), m_finished(false), m_system(sys)
 	{
 		m_mesh = MeshRes::Create(m_system->gl);
 		m_mesh->SetPrimitiveType(PrimitiveType::PointList);
+		m_pool = new ParticlePool();
 
 		// Set parameter defaults
 #define PARTICLE_DEFAULT(__name, __value)\
@@ -148,47 +164,58 @@ namespace Graphics
 	}
 	ParticleEmitter::~ParticleEmitter()
 	{
+		// The running job still uses the parameters and the pool
+		m_WaitForSimulation();
+
 		// Cleanup particle parameters
 #define PARTICLE_PARAMETER(__name, __type)\
 	if(m_param_##__name){\
 		delete m_param_##__name; m_param_##__name = nullptr; }
 #include "ParticleParameters.hpp"
 
-		if(m_particles)
-		{
-			delete[] m_particles;
-		}
+		delete m_pool;
 	}
 
-	void ParticleEmitter::m_ReallocatePool(uint32 newCapacity)
+	void ParticleEmitter::m_InitParticle(uint32 index, const SimulationInput& input)
 	{
-		Particle* oldParticles = m_particles;
-		uint32 oldSize = m_poolSize;
-
-		// Create new pool
-		m_poolSize = newCapacity;
-		if(newCapacity > 0)
-		{
-			m_particles = new Particle[m_poolSize];
-			memset(m_particles, 0, m_poolSize * sizeof(Particle));
-		}
-		else
-		{
-			m_particles = nullptr;
-		}
-
-		if(oldParticles && m_particles)
-		{
-			memcpy(m_particles, oldParticles, Math::Min(oldSize, m_poolSize) * sizeof(Particle));
-		}
-
-		if(oldParticles)
-			delete[] oldParticles;
+		ParticlePool& pool = *m_pool;
+		const float& et = m_emitterRate;
+
+		float lifetime = m_param_Lifetime->Init(et);
+		pool[ParticlePool::Life][index] = lifetime;
+		pool[ParticlePool::InvMaxLife][index] = lifetime > 0.0f ? 1.0f / lifetime : 0.0f;
+
+		Vector3 pos = m_param_StartPosition->Init(et) * input.scale;
+
+		// Velocity of startvelocity and spawn offset scale
+		Vector3 velocity = m_param_StartVelocity->Init(et) * input.scale;
+		float spawnVelScale = m_param_SpawnVelocityScale->Init(et);
+		if(spawnVelScale > 0)
+			velocity += pos.Normalized() * spawnVelScale * input.scale;
+
+		// Add emitter offset to location
+		pos += input.position;
+
+		pool[ParticlePool::PositionX][index] = pos.x;
+		pool[ParticlePool::PositionY][index] = pos.y;
+		pool[ParticlePool::PositionZ][index] = pos.z;
+		pool[ParticlePool::VelocityX][index] = velocity.x;
+		pool[ParticlePool::VelocityY][index] = velocity.y;
+		pool[ParticlePool::VelocityZ][index] = velocity.z;
+
+		Color startColor = m_param_StartColor->Init(et);
+		pool[ParticlePool::ColorR][index] = startColor.x;
+		pool[ParticlePool::ColorG][index] = startColor.y;
+		pool[ParticlePool::ColorB][index] = startColor.z;
+		pool[ParticlePool::ColorA][index] = startColor.w;
+		pool[ParticlePool::Rotation][index] = m_param_StartRotation->Init(et);
+		pool[ParticlePool::StartSize][index] = m_param_StartSize->Init(et) * input.scale;
+		pool[ParticlePool::Drag][index] = m_param_StartDrag->Init(et);
 	}
-	void ParticleEmitter::Render(const class RenderState& rs, float deltaTime)
+	void ParticleEmitter::m_Simulate(const SimulationInput& input)
 	{
-		if(m_finished)
-			return;
+		ParticlePool& pool = *m_pool;
+		const float deltaTime = input.deltaTime;
 
 		uint32 maxDuration = (uint32)ceilf(m_param_Lifetime->GetMax());
 		uint32 maxSpawns = (uint32)ceilf(m_param_SpawnRate->GetMax());
@@ -196,20 +223,17 @@ namespace Graphics
 		// Round up to 64
 		maxParticles = (uint32)ceil((float)maxParticles / 64.0f) * 64;
 
-		if(maxParticles > m_poolSize)
-			m_ReallocatePool(maxParticles);
-
-		// Resulting vertex bufffer
-		Vector<ParticleVertex> verts;
+		if(maxParticles > pool.capacity)
+			pool.Reallocate(maxParticles);
 
 		// Increment emitter time
 		m_emitterTime += deltaTime;
-		while(m_emitterTime > duration)
+		while(m_emitterTime > input.duration)
 		{
-			m_emitterTime -= duration;
+			m_emitterTime -= input.duration;
 			m_emitterLoopIndex++;
 		}
-		m_emitterRate = m_emitterTime / duration;
+		m_emitterRate = m_emitterTime / input.duration;
 
 		// Increment spawn counter
 		m_spawnCounter += deltaTime * m_param_SpawnRate->Sample(m_emitterRate);
@@ -217,7 +241,7 @@ namespace Graphics
 		uint32 numSpawns = 0;
 		float spawnTimeOffset = 0.0f;
 		float spawnTimeOffsetStep = 0;
-		if(loops > 0 && m_emitterLoopIndex >= loops) // Should spawn particles ?
+		if(input.loops > 0 && m_emitterLoopIndex >= input.loops) // Should spawn particles ?
 			m_deactivated = true;
 
 		if(!m_deactivated)
@@ -229,34 +253,31 @@ namespace Graphics
 			spawnTimeOffsetStep = deltaTime / spawnsf;
 		}
 
+		// Spawn new particles in free slots and pick the time step for every slot
+		// dead particles get a zero step so the integration below leaves them untouched
+		float* life = pool[ParticlePool::Life];
+		float* step = pool[ParticlePool::Step];
+		pool.visible.clear();
 		bool updatedSomething = false;
-		for(uint32 i = 0; i < m_poolSize; i++)
+		for(uint32 i = 0; i < pool.capacity; i++)
 		{
-			Particle& p = m_particles[i];
-
-			bool render = false;
-			if(!m_particles[i].IsAlive())
+			if(life[i] > 0.0f)
 			{
-				// Try to spawn a new particle in this slot
-				if(numSpawns > 0)
-				{
-					p.Init(this);
-					p.Simulate(this, spawnTimeOffset);
-					spawnTimeOffset += spawnTimeOffsetStep;
-					numSpawns--;
-					render = true;
-				}
+				step[i] = deltaTime;
+				pool.visible.Add(i);
+				updatedSomething = true;
 			}
-			else
+			else if(numSpawns > 0)
 			{
-				p.Simulate(this, deltaTime);
-				render = true;
-				updatedSomething = true;
+				m_InitParticle(i, input);
+				step[i] = spawnTimeOffset;
+				spawnTimeOffset += spawnTimeOffsetStep;
+				numSpawns--;
+				pool.visible.Add(i);
 			}
-
-			if(render)
+			else
 			{
-				verts.Add({ p.pos, p.startColor.WithAlpha(p.fade), Vector4(p.startSize * p.scale, p.rotation, 0, 0) });
+				step[i] = 0.0f;
 			}
 		}
 
@@ -265,6 +286,100 @@ namespace Graphics
 			m_finished = !updatedSomething;
 		}
 
+		// Gravity only depends on the emitter time, so it is the same for every particle
+		Vector3 gravity = m_param_Gravity->Sample(m_emitterTime) * input.scale;
+
+		// Integrate all slots at once
+		float* invMaxLife = pool[ParticlePool::InvMaxLife];
+		float* progress = pool[ParticlePool::Progress];
+		float* px = pool[ParticlePool::PositionX];
+		float* py = pool[ParticlePool::PositionY];
+		float* pz = pool[ParticlePool::PositionZ];
+		float* vx = pool[ParticlePool::VelocityX];
+		float* vy = pool[ParticlePool::VelocityY];
+		float* vz = pool[ParticlePool::VelocityZ];
+		float* drag = pool[ParticlePool::Drag];
+		for(uint32 i = 0; i < pool.capacity; i++)
+		{
+			const float dt = step[i];
+			progress[i] = 1.0f - life[i] * invMaxLife[i];
+
+			// Add gravity
+			vx[i] += gravity.x * dt;
+			vy[i] += gravity.y * dt;
+			vz[i] += gravity.z * dt;
+
+			px[i] += vx[i] * dt;
+			py[i] += vy[i] * dt;
+			pz[i] += vz[i] * dt;
+
+			// Add drag
+			const float dragFactor = 1.0f - dt * drag[i];
+			vx[i] *= dragFactor;
+			vy[i] *= dragFactor;
+			vz[i] *= dragFactor;
+
+			life[i] -= dt;
+		}
+
+		// Build vertices for the particles that were alive at the start of this step
+		const float* rotation = pool[ParticlePool::Rotation];
+		const float* startSize = pool[ParticlePool::StartSize];
+		const float* cr = pool[ParticlePool::ColorR];
+		const float* cg = pool[ParticlePool::ColorG];
+		const float* cb = pool[ParticlePool::ColorB];
+		pool.simulatedVertices.clear();
+		pool.simulatedVertices.reserve(pool.visible.size());
+		for(uint32 i : pool.visible)
+		{
+			float fade = m_param_FadeOverTime->Sample(progress[i]);
+			float scale = m_param_ScaleOverTime->Sample(progress[i]);
+			pool.simulatedVertices.Add({ Vector3(px[i], py[i], pz[i]), Color(cr[i], cg[i], cb[i], fade),
+				Vector4(startSize[i] * scale, rotation[i], 0, 0) });
+		}
+	}
+	void ParticleEmitter::m_WaitForSimulation()
+	{
+		if(!m_simulationJob)
+			return;
+
+		// Removes the job from the queue if no thread started it yet, otherwise waits for it to complete
+		m_simulationJob->Terminate();
+		if(!m_simulationJob->IsFinished())
+			m_simulationJob->Run();
+		m_simulationJob.Release();
+	}
+	void ParticleEmitter::Render(const class RenderState& rs, float deltaTime)
+	{
+		m_WaitForSimulation();
+		if(m_finished)
+			return;
+
+		SimulationInput input;
+		input.position = position;
+		input.scale = scale;
+		input.duration = duration;
+		input.loops = loops;
+		input.deltaTime = deltaTime;
+
+		JobSheduler* sheduler = m_system->sheduler;
+		if(sheduler)
+		{
+			// Draw the result of last frame's step while the next one is simulated on a worker thread
+			std::swap(m_pool->simulatedVertices, m_pool->renderVertices);
+			m_simulationJob = JobBase::CreateLambda([=]()
+			{
+				m_Simulate(input);
+				return true;
+			});
+			sheduler->Queue(m_simulationJob);
+		}
+		else
+		{
+			m_Simulate(input);
+			std::swap(m_pool->simulatedVertices, m_pool->renderVertices);
+		}
+
 		MaterialParameterSet params;
 		if(texture)
 		{
@@ -286,20 +401,21 @@ namespace Graphics
 			break;
 		}
 
-		m_mesh->SetData(verts);	
+		m_mesh->SetData(m_pool->renderVertices);
 		m_mesh->Draw();
 	}
 
 	void ParticleEmitter::Reset()
 	{
+		m_WaitForSimulation();
 		m_deactivated = false;
 		m_finished = false;
-		delete[] m_particles;
-		m_particles = nullptr;
+		m_pool->Reallocate(0);
+		m_pool->simulatedVertices.clear();
+		m_pool->renderVertices.clear();
 		m_emitterLoopIndex = 0;
 		m_emitterTime = 0;
 		m_spawnCounter = 0;
-		m_poolSize = 0;
 	}
 
 	void ParticleEmitter::Deactivate()
@@ -1,10 +1,81 @@
 #include "stdafx.h"
 #include "RenderQueue.hpp"
 #include "OpenGL.hpp"
-using Utility::Cast;
 
 namespace Graphics
 {
+	struct RenderQueue::DrawCommand
+	{
+		enum class Type : uint8
+		{
+			Simple,
+			Points,
+			Instanced,
+		};
+		Type type;
+		// Blend state, material, scissor and mesh packed in a single value that can be sorted on
+		uint64 sortKey;
+		Mesh mesh;
+		Material mat;
+		// Index into the parameter pool, or -1 when the command has no parameters
+		int32 paramsIndex;
+		Transform worldTransform;
+		// Scissor rectangle, negative size when not used
+		Rect scissorRect;
+		float pointSize;
+		// Range of vertices to draw, the whole mesh when vertexCount is 0
+		uint32 firstVertex;
+		uint32 vertexCount;
+		// Location of the instance data, only used by instanced commands
+		size_t instanceOffset;
+		uint32 instanceCount;
+		uint32 instanceFormatIndex;
+	};
+
+	struct RenderQueue::CommandStorage
+	{
+		Vector<DrawCommand> commands;
+		// Parameter sets are never shrunk, the ones in use are emptied when the queue is cleared so they don't keep textures alive
+		Vector<MaterialParameterSet> params;
+		uint32 numParams = 0;
+		// Instance data of all instanced commands, packed one after another
+		Vector<uint8> instanceData;
+		Vector<VertexFormatList> instanceFormats;
+		uint32 numInstanceFormats = 0;
+
+		// Scratch buffers used by Process
+		Vector<uint32> order;
+		Vector<MaterialRes*> boundMaterials;
+	};
+
+	static RenderQueueStats g_frameStats;
+
+	static bool IsSameRect(const Rect& a, const Rect& b)
+	{
+		return a.pos.x == b.pos.x && a.pos.y == b.pos.y && a.size.x == b.size.x && a.size.y == b.size.y;
+	}
+
+	// Blend state goes in the top bits, sorting opaque objects first and grouping by blend mode
+	// the material and mesh parts are based on their addresses, collisions only make grouping less effective
+	static uint64 MakeSortKey(const Material& mat, const Mesh& mesh, uint32 scissorKey)
+	{
+		uint64 blend = mat->opaque ? 0 : 1 + (uint64)mat->blendMode;
+		uint64 material = ((uintptr_t)mat.GetData() >> 4) & 0xFFFFFF;
+		uint64 scissor = scissorKey & 0xFF;
+		uint64 meshKey = mesh ? ((uintptr_t)mesh.GetData() >> 4) & 0x3FFFFFFF : 0;
+		return (blend << 62) | (material << 38) | (scissor << 30) | meshKey;
+	}
+
+	RenderQueueStats& RenderQueueStats::operator+=(const RenderQueueStats& other)
+	{
+		drawCalls += other.drawCalls;
+		programChanges += other.programChanges;
+		blendChanges += other.blendChanges;
+		scissorChanges += other.scissorChanges;
+		meshChanges += other.meshChanges;
+		return *this;
+	}
+
 	RenderQueue::RenderQueue(OpenGL* ogl, const RenderState& rs)
 	{
 		m_ogl = ogl;
@@ -12,115 +83,153 @@ namespace Graphics
 	}
 	RenderQueue::RenderQueue(RenderQueue&& other)
 	{
-		m_ogl = other.m_ogl;
-		other.m_ogl = nullptr;
-		m_orderedCommands = move(other.m_orderedCommands);
-		m_renderState = other.m_renderState;
+		*this = std::move(other);
 	}
 	RenderQueue& RenderQueue::operator=(RenderQueue&& other)
 	{
-		Clear();
+		m_ReleaseStorage();
 		m_ogl = other.m_ogl;
 		other.m_ogl = nullptr;
-		m_orderedCommands = move(other.m_orderedCommands);
+		m_storage = other.m_storage;
+		other.m_storage = nullptr;
 		m_renderState = other.m_renderState;
+		m_stats = other.m_stats;
+		m_sorting = other.m_sorting;
+		m_lastScissor = other.m_lastScissor;
+		m_scissorKey = other.m_scissorKey;
 		return *this;
 	}
 	RenderQueue::~RenderQueue()
 	{
-		Clear();
+		m_ReleaseStorage();
 	}
 	void RenderQueue::Process(bool clearQueue)
 	{
 		assert(m_ogl);
+		m_stats = RenderQueueStats();
+		if(!m_storage)
+			return;
 
 		bool scissorEnabled = false;
+		Rect activeScissor;
 		bool blendEnabled = false;
 		MaterialBlendMode activeBlendMode = (MaterialBlendMode)-1;
 
-		Set<Material> initializedShaders;
+		Vector<DrawCommand>& commands = m_storage->commands;
+		Vector<MaterialRes*>& boundMaterials = m_storage->boundMaterials;
+		boundMaterials.clear();
 		Mesh currentMesh;
 		Material currentMaterial;
 
-		// Create a new list of items
-		for(RenderQueueItem* item : m_orderedCommands)
+		Vector<uint32>& order = m_storage->order;
+		if(m_sorting)
 		{
-			auto SetupMaterial = [&](Material& mat, MaterialParameterSet& params)
+			order.resize(commands.size());
+			for(uint32 i = 0; i < order.size(); i++)
+				order[i] = i;
+			// Stable so commands with the same state keep their order
+			std::stable_sort(order.begin(), order.end(), [&](uint32 a, uint32 b)
 			{
-				// Only bind params if material is already bound to context
-				if(currentMaterial == mat)
+				return commands[a].sortKey < commands[b].sortKey;
+			});
+		}
+
+		auto SetupMaterial = [&](Material& mat, const MaterialParameterSet& params)
+		{
+			// Only bind params if material is already bound to context
+			if(currentMaterial == mat)
+				mat->BindParameters(params, m_renderState.worldTransform);
+			else
+			{
+				if(std::find(boundMaterials.begin(), boundMaterials.end(), mat.GetData()) != boundMaterials.end())
+				{
+					// Only bind params and rebind
 					mat->BindParameters(params, m_renderState.worldTransform);
+					mat->BindToContext();
+				}
 				else
 				{
-					if(initializedShaders.Contains(mat))
-					{
-						// Only bind params and rebind
-						mat->BindParameters(params, m_renderState.worldTransform);
-						mat->BindToContext();
-						currentMaterial = mat;
-					}
-					else
-					{
-						mat->Bind(m_renderState, params);
-						initializedShaders.Add(mat);
-						currentMaterial = mat;
-					}
+					mat->Bind(m_renderState, params);
+					boundMaterials.Add(mat.GetData());
 				}
+				currentMaterial = mat;
+				m_stats.programChanges++;
+			}
 
-				// Setup Render state for transparent object
-				if(mat->opaque)
+			// Setup Render state for transparent object
+			if(mat->opaque)
+			{
+				if(blendEnabled)
 				{
-					if(blendEnabled)
-					{
-						glDisable(GL_BLEND);
-						blendEnabled = false;
-					}
+					glDisable(GL_BLEND);
+					blendEnabled = false;
+					m_stats.blendChanges++;
 				}
-				else
+			}
+			else
+			{
+				if(!blendEnabled)
 				{
-					if(!blendEnabled)
-					{
-						glEnable(GL_BLEND);
-						blendEnabled = true;
-					}
-					if(activeBlendMode != mat->blendMode)
+					glEnable(GL_BLEND);
+					blendEnabled = true;
+					m_stats.blendChanges++;
+				}
+				if(activeBlendMode != mat->blendMode)
+				{
+					switch(mat->blendMode)
 					{
-						switch(mat->blendMode)
-						{
-						case MaterialBlendMode::Normal:
-							glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE);
-							break;
-						case MaterialBlendMode::Additive:
-							glBlendFunc(GL_ONE, GL_ONE);
-							break;
-						case MaterialBlendMode::Multiply:
-							glBlendFunc(GL_SRC_ALPHA, GL_SRC_COLOR);
-							break;
-						}
+					case MaterialBlendMode::Normal:
+						glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE);
+						break;
+					case MaterialBlendMode::Additive:
+						glBlendFunc(GL_ONE, GL_ONE);
+						break;
+					case MaterialBlendMode::Multiply:
+						glBlendFunc(GL_SRC_ALPHA, GL_SRC_COLOR);
+						break;
 					}
+					activeBlendMode = mat->blendMode;
+					m_stats.blendChanges++;
 				}
-			};
+			}
+		};
 
-			// Draw mesh helper
-			auto DrawOrRedrawMesh = [&](Mesh& mesh)
+		// Draw mesh helper
+		auto DrawOrRedrawMesh = [&](DrawCommand& cmd)
+		{
+			Mesh& mesh = cmd.mesh;
+			if(currentMesh == mesh)
 			{
-				if(currentMesh == mesh)
+				if(cmd.vertexCount > 0)
+					mesh->RedrawRange(cmd.firstVertex, cmd.vertexCount);
+				else
 					mesh->Redraw();
+			}
+			else
+			{
+				if(cmd.vertexCount > 0)
+					mesh->DrawRange(cmd.firstVertex, cmd.vertexCount);
 				else
-				{
 					mesh->Draw();
-					currentMesh = mesh;
-				}
-			};
+				currentMesh = mesh;
+				m_stats.meshChanges++;
+			}
+			m_stats.drawCalls++;
+		};
+
+		static const MaterialParameterSet emptyParams;
+		for(size_t i = 0; i < commands.size(); i++)
+		{
+			DrawCommand& cmd = commands[m_sorting ? order[i] : i];
+			const MaterialParameterSet& params = cmd.paramsIndex >= 0 ? m_storage->params[cmd.paramsIndex] : emptyParams;
 
-			if(Cast<SimpleDrawCall>(item))
+			if(cmd.type == DrawCommand::Type::Simple || cmd.type == DrawCommand::Type::Instanced)
 			{
-				SimpleDrawCall* sdc = (SimpleDrawCall*)item;
-				m_renderState.worldTransform = sdc->worldTransform;
-				SetupMaterial(sdc->mat, sdc->params);
+				m_renderState.worldTransform = cmd.worldTransform;
+				SetupMaterial(cmd.mat, params);
 
 				// Check if scissor is enabled
-				bool useScissor = (sdc->scissorRect.size.x >= 0);
+				bool useScissor = (cmd.scissorRect.size.x >= 0);
 				if(useScissor)
 				{
 					// Apply scissor
@@ -128,10 +237,17 @@ namespace Graphics
 					{
 						glEnable(GL_SCISSOR_TEST);
 						scissorEnabled = true;
+						// Make sure the rectangle is set
+						activeScissor.size.x = -1;
+					}
+					if(!IsSameRect(activeScissor, cmd.scissorRect))
+					{
+						float scissorY = m_renderState.viewportSize.y - cmd.scissorRect.Bottom();
+						glScissor((int32)cmd.scissorRect.Left(), (int32)scissorY,
+							(int32)cmd.scissorRect.size.x, (int32)cmd.scissorRect.size.y);
+						activeScissor = cmd.scissorRect;
+						m_stats.scissorChanges++;
 					}
-					float scissorY = m_renderState.viewportSize.y - sdc->scissorRect.Bottom();
-					glScissor((int32)sdc->scissorRect.Left(), (int32)scissorY,
-						(int32)sdc->scissorRect.size.x, (int32)sdc->scissorRect.size.y);
 				}
 				else
 				{
@@ -139,39 +255,53 @@ namespace Graphics
 					{
 						glDisable(GL_SCISSOR_TEST);
 						scissorEnabled = false;
+						m_stats.scissorChanges++;
 					}
 				}
 
-				DrawOrRedrawMesh(sdc->mesh);
+				if(cmd.type == DrawCommand::Type::Instanced)
+				{
+					// Uploading the instances unbinds the mesh
+					cmd.mesh->SetInstanceData(m_storage->instanceData.data() + cmd.instanceOffset, cmd.instanceCount,
+						m_storage->instanceFormats[cmd.instanceFormatIndex]);
+					cmd.mesh->DrawInstanced(cmd.instanceCount);
+					currentMesh = Mesh();
+					m_stats.meshChanges++;
+					m_stats.drawCalls++;
+				}
+				else
+				{
+					DrawOrRedrawMesh(cmd);
+				}
 				#ifdef EMBEDDED
 				glUseProgram(0);
 				#endif
 			}
-			else if(Cast<PointDrawCall>(item))
+			else if(cmd.type == DrawCommand::Type::Points)
 			{
 				if(scissorEnabled)
 				{
 					// Disable scissor
 					glDisable(GL_SCISSOR_TEST);
 					scissorEnabled = false;
+					m_stats.scissorChanges++;
 				}
 
-				PointDrawCall* pdc = (PointDrawCall*)item;
 				m_renderState.worldTransform = Transform();
-				SetupMaterial(pdc->mat, pdc->params);
-				PrimitiveType pt = pdc->mesh->GetPrimitiveType();
+				SetupMaterial(cmd.mat, params);
+				PrimitiveType pt = cmd.mesh->GetPrimitiveType();
 				if(pt >= PrimitiveType::LineList && pt <= PrimitiveType::LineStrip)
 				{
-					glLineWidth(pdc->size);
+					glLineWidth(cmd.pointSize);
 				}
 				else
 				{
 					#ifndef EMBEDDED
-					glPointSize(pdc->size);
+					glPointSize(cmd.pointSize);
 					#endif
 				}
-				
-				DrawOrRedrawMesh(pdc->mesh);
+
+				DrawOrRedrawMesh(cmd);
 				#ifdef EMBEDDED
 				glUseProgram(0);
 				#endif
@@ -182,6 +312,8 @@ namespace Graphics
 		glDisable(GL_BLEND);
 		glDisable(GL_SCISSOR_TEST);
 
+		g_frameStats += m_stats;
+
 		if(clearQueue)
 		{
 			Clear();
@@ -190,73 +322,178 @@ namespace Graphics
 
 	void RenderQueue::Clear()
 	{
-		// Cleanup the list of items
-		for(RenderQueueItem* item : m_orderedCommands)
+		if(!m_storage)
+			return;
+		// Keeps the allocated memory for the next frame
+		m_storage->commands.clear();
+		for(uint32 i = 0; i < m_storage->numParams; i++)
+			m_storage->params[i].clear();
+		m_storage->numParams = 0;
+		m_storage->instanceData.clear();
+		m_storage->numInstanceFormats = 0;
+		m_scissorKey = 0;
+	}
+
+	RenderQueue::DrawCommand& RenderQueue::m_AddCommand(const Mesh& m, const Material& mat, const MaterialParameterSet& params)
+	{
+		if(!m_storage)
+		{
+			Vector<CommandStorage*>& freeStorage = m_GetFreeStorage();
+			if(freeStorage.empty())
+			{
+				m_storage = new CommandStorage();
+			}
+			else
+			{
+				m_storage = freeStorage.back();
+				freeStorage.pop_back();
+			}
+		}
+
+		m_storage->commands.emplace_back();
+		DrawCommand& cmd = m_storage->commands.back();
+		cmd.type = DrawCommand::Type::Simple;
+		cmd.mesh = m;
+		cmd.mat = mat;
+		cmd.paramsIndex = -1;
+		cmd.scissorRect = Rect(Vector2(), Vector2(-1));
+		cmd.pointSize = 1.0f;
+		cmd.firstVertex = 0;
+		cmd.vertexCount = 0;
+		cmd.instanceOffset = 0;
+		cmd.instanceCount = 0;
+		cmd.instanceFormatIndex = 0;
+		if(!params.empty())
+			m_GetParams(cmd) = params;
+		cmd.sortKey = MakeSortKey(mat, m, 0);
+		return cmd;
+	}
+	MaterialParameterSet& RenderQueue::m_GetParams(DrawCommand& cmd)
+	{
+		if(cmd.paramsIndex < 0)
 		{
-			delete item;
+			if(m_storage->numParams == m_storage->params.size())
+				m_storage->params.emplace_back();
+			cmd.paramsIndex = m_storage->numParams++;
 		}
-		m_orderedCommands.clear();
+		return m_storage->params[cmd.paramsIndex];
+	}
+	void RenderQueue::m_ReleaseStorage()
+	{
+		if(!m_storage)
+			return;
+		Clear();
+		m_GetFreeStorage().Add(m_storage);
+		m_storage = nullptr;
+	}
+	Vector<RenderQueue::CommandStorage*>& RenderQueue::m_GetFreeStorage()
+	{
+		// Render queues are only used from the render thread so this is not synchronized
+		static Vector<CommandStorage*> freeStorage;
+		return freeStorage;
 	}
 
 	void RenderQueue::Draw(Transform worldTransform, Mesh m, Material mat, const MaterialParameterSet& params)
 	{
-		SimpleDrawCall* sdc = new SimpleDrawCall();
-		sdc->mat = mat;
-		sdc->mesh = m;
-		sdc->params = params;
-		sdc->worldTransform = worldTransform;
-		m_orderedCommands.push_back(sdc);
+		DrawCommand& cmd = m_AddCommand(m, mat, params);
+		cmd.worldTransform = worldTransform;
 	}
 	void RenderQueue::Draw(Transform worldTransform, Ref<class TextRes> text, Material mat, const MaterialParameterSet& params)
 	{
-		SimpleDrawCall* sdc = new SimpleDrawCall();
-		sdc->mat = mat;
-		sdc->mesh = text->GetMesh();
-		sdc->params = params;
+		const MeshRange& range = text->GetMeshRange();
+		if(!range.IsValid())
+			return; // Empty text
+		DrawCommand& cmd = m_AddCommand(range.mesh, mat, params);
+		cmd.worldTransform = worldTransform;
+		cmd.firstVertex = range.firstVertex;
+		cmd.vertexCount = range.vertexCount;
 		// Set Font texture map
-		sdc->params.SetParameter("mainTex", text->GetTexture());
-		sdc->worldTransform = worldTransform;
-		m_orderedCommands.push_back(sdc);
+		m_GetParams(cmd).SetParameter("mainTex", text->GetTexture());
+	}
+
+	void RenderQueue::Draw(Transform worldTransform, const MeshRange& range, Material mat, const MaterialParameterSet& params)
+	{
+		DrawCommand& cmd = m_AddCommand(range.mesh, mat, params);
+		cmd.worldTransform = worldTransform;
+		cmd.firstVertex = range.firstVertex;
+		cmd.vertexCount = range.vertexCount;
 	}
 
 	void RenderQueue::DrawScissored(Rect scissor, Transform worldTransform, Mesh m, Material mat, const MaterialParameterSet& params /*= MaterialParameterSet()*/)
 	{
-		SimpleDrawCall* sdc = new SimpleDrawCall();
-		sdc->mat = mat;
-		sdc->mesh = m;
-		sdc->params = params;
-		sdc->worldTransform = worldTransform;
-		sdc->scissorRect = scissor;
-		m_orderedCommands.push_back(sdc);
+		DrawCommand& cmd = m_AddCommand(m, mat, params);
+		cmd.worldTransform = worldTransform;
+		m_SetScissor(cmd, scissor);
 	}
 	void RenderQueue::DrawScissored(Rect scissor, Transform worldTransform, Ref<class TextRes> text, Material mat, const MaterialParameterSet& params /*= MaterialParameterSet()*/)
 	{
-		SimpleDrawCall* sdc = new SimpleDrawCall();
-		sdc->mat = mat;
-		sdc->mesh = text->GetMesh();
-		sdc->params = params;
+		const MeshRange& range = text->GetMeshRange();
+		if(!range.IsValid())
+			return; // Empty text
+		DrawCommand& cmd = m_AddCommand(range.mesh, mat, params);
+		cmd.worldTransform = worldTransform;
+		cmd.firstVertex = range.firstVertex;
+		cmd.vertexCount = range.vertexCount;
+		m_SetScissor(cmd, scissor);
 		// Set Font texture map
-		sdc->params.SetParameter("mainTex", text->GetTexture());
-		sdc->params.SetParameter("mapSize", text->GetTexture()->GetSize());
-		sdc->worldTransform = worldTransform;
-		sdc->scissorRect = scissor;
-		m_orderedCommands.push_back(sdc);
+		MaterialParameterSet& textParams = m_GetParams(cmd);
+		textParams.SetParameter("mainTex", text->GetTexture());
+		textParams.SetParameter("mapSize", text->GetTexture()->GetSize());
+	}
+	void RenderQueue::m_SetScissor(DrawCommand& cmd, const Rect& scissor)
+	{
+		cmd.scissorRect = scissor;
+		// Consecutive commands with the same rectangle share a key
+		if(m_scissorKey == 0 || !IsSameRect(m_lastScissor, scissor))
+		{
+			m_lastScissor = scissor;
+			m_scissorKey++;
+		}
+		cmd.sortKey = MakeSortKey(cmd.mat, cmd.mesh, m_scissorKey);
 	}
 
-	void RenderQueue::DrawPoints(Mesh m, Material mat, const MaterialParameterSet& params, float pointSize)
+	void RenderQueue::m_DrawInstanced(const Transform& worldTransform, const Mesh& m, const Material& mat, const MaterialParameterSet& params,
+		const void* instanceData, size_t instanceSize, size_t instanceCount, const VertexFormatList& format)
 	{
-		PointDrawCall* pdc = new PointDrawCall();
-		pdc->mat = mat;
-		pdc->mesh = m;
-		pdc->params = params;
-		pdc->size = pointSize;
-		m_orderedCommands.push_back(pdc);
+		if(instanceCount == 0)
+			return;
+		DrawCommand& cmd = m_AddCommand(m, mat, params);
+		cmd.type = DrawCommand::Type::Instanced;
+		cmd.worldTransform = worldTransform;
+
+		Vector<uint8>& data = m_storage->instanceData;
+		cmd.instanceOffset = data.size();
+		cmd.instanceCount = (uint32)instanceCount;
+		data.resize(data.size() + instanceSize * instanceCount);
+		memcpy(data.data() + cmd.instanceOffset, instanceData, instanceSize * instanceCount);
+
+		if(m_storage->numInstanceFormats == m_storage->instanceFormats.size())
+			m_storage->instanceFormats.emplace_back();
+		cmd.instanceFormatIndex = m_storage->numInstanceFormats++;
+		m_storage->instanceFormats[cmd.instanceFormatIndex] = format;
 	}
 
-	// Initializes the simple draw call structure
-	SimpleDrawCall::SimpleDrawCall()
-		: scissorRect(Vector2(), Vector2(-1))
+	void RenderQueue::DrawPoints(Mesh m, Material mat, const MaterialParameterSet& params, float pointSize)
 	{
+		DrawCommand& cmd = m_AddCommand(m, mat, params);
+		cmd.type = DrawCommand::Type::Points;
+		cmd.pointSize = pointSize;
 	}
 
+	void RenderQueue::SetSorting(bool enabled)
+	{
+		m_sorting = enabled;
+	}
+	const RenderQueueStats& RenderQueue::GetStats() const
+	{
+		return m_stats;
+	}
+	const RenderQueueStats& RenderQueue::GetFrameStats()
+	{
+		return g_frameStats;
+	}
+	void RenderQueue::ResetFrameStats()
+	{
+		g_frameStats = RenderQueueStats();
+	}
 }
@@ -234,6 +234,7 @@ namespace Graphics
 			SDL_Event evt;
 			while(SDL_PollEvent(&evt))
 			{
+				m_eventTimestamp = evt.common.timestamp;
 				if(evt.type == SDL_EventType::SDL_KEYDOWN)
 				{
 					if(m_textComposition.composition.empty())
@@ -422,6 +423,8 @@ namespace Graphics
 		Map<SDL_Keycode, uint8> m_keyStates;
 		KeyMap m_keyMapping;
 		ModifierKeys m_modKeys = ModifierKeys::None;
+		// Timestamp of the event that is currently being handled
+		uint32 m_eventTimestamp = 0;
 
 		// Gamepad input
 		Map<int32, Ref<Gamepad_Impl>> m_gamepads;
@@ -531,6 +534,15 @@ namespace Graphics
 		return m_impl->m_keyStates[key] > 0;
 	}
 
+	uint32 Window::GetEventTimestamp() const
+	{
+		return m_impl->m_eventTimestamp;
+	}
+	void Window::PumpEvents()
+	{
+		SDL_PumpEvents();
+	}
+
 	Graphics::ModifierKeys Window::GetModifierKeys() const
 	{
 		return m_impl->m_modKeys;
@@ -29,6 +29,8 @@ public:
 		int texture;
 		bool loaded = false;
 		Job loadingJob;
+		// Decoded image waiting to be uploaded
+		Image image;
 	};
 	void ApplySettings();
 	// Runs the application
@@ -68,6 +70,8 @@ public:
 	Sample LoadSample(const String& name, const bool& external = false);
 	Graphics::Font LoadFont(const String& name, const bool& external = false);
 	int LoadImageJob(const String& path, Vector2i size, int placeholder, const bool& web = false);
+	// Uploads the decoded image of a jacket over the next frames, called when its loading job has finished
+	void QueueJacketUpload(CachedJacketImage* image);
 	void SetScriptPath(lua_State* L);
 	lua_State* LoadScript(const String& name, bool noError = false);
 	void ReloadScript(const String& name, lua_State* L);
@@ -112,6 +116,9 @@ private:
 	void m_MainLoop();
 	void m_Tick();
 	void m_Cleanup();
+	// Creates textures for loaded jackets, limited to a number of bytes per frame
+	void m_UploadJackets();
+	void m_ClearJacketImages();
 	void m_OnKeyPressed(int32 key);
 	void m_OnKeyReleased(int32 key);
 	void m_OnWindowResized(const Vector2i& newSize);
@@ -128,6 +135,7 @@ private:
 	Material m_guiTex;
 	class HealthGauge* m_gauge;
 	Map<String, CachedJacketImage*> m_jacketImages;
+	List<CachedJacketImage*> m_pendingJacketUploads;
 	String m_lastMapPath;
 	Thread m_updateThread;
 	class Beatmap* m_currentMap = nullptr;
@@ -21,8 +21,13 @@ public:
 	// Add a loadable to be loaded, additionaly with a name so it can be identified in logs if it fails loading
 	void AddLoadable(IAsyncLoadable& loadable, const String& id = "unknown");
 
+	// Loads all added assets, independent operations are spread over the job threads
 	bool Load();
+	// Finalizes all loaded assets at once
 	bool Finalize();
+	// Finalizes loaded assets until maxDuration seconds have passed, at least one asset is finalized per call
+	//	finished is set to true once all assets are finalized, after which timings are logged and the loader is cleared
+	bool FinalizeStep(float maxDuration, bool& finished);
 
 private:
 	class AsyncAssetLoader_Impl* m_impl;
@@ -18,6 +18,15 @@ public:
 	//	for example, any OpenGL stuff
 	//	returns success
 	virtual bool AsyncFinalize() = 0;
+	// Finalizes part of this object, spending roughly maxDuration seconds
+	//	finished is set to true once everything is finalized
+	//	the default implementation finalizes everything at once
+	//	returns success
+	virtual bool AsyncFinalizeStep(float maxDuration, bool& finished)
+	{
+		finished = true;
+		return AsyncFinalize();
+	}
 };
 
 // Both an application tickable and async loadable
@@ -44,6 +44,8 @@ public:
 	void Play();
 	void Advance(MapTime ms);
 	MapTime GetPosition() const;
+	// Music position (in ms) at which an input event with the given timestamp (SDL_GetTicks) happened
+	double GetPositionAtTimestamp(uint32 timestamp) const;
 	void SetPosition(MapTime time);
 
 	// Pause the playback
@@ -86,7 +88,14 @@ public:
 private:
 	// Returns the track that should have effects applied to them
 	Ref<AudioStream> m_GetDSPTrack();
+	// Creates the DSP for an effect on the effect track
+	class DSP* m_CreateDSP(GameAudioEffect& effect);
 	void m_CleanupDSP(class DSP*& ptr);
+	// If any laser or button effect of the map shifts the pitch
+	bool m_UsesPitchShift() const;
+	// Delays a track by the latency of the pitch shifter
+	void m_AddDelay(Ref<AudioStream> track);
+	void m_CleanupLatencyCompensation();
 	void m_SetLaserEffectParameter(float input);
 
 	// Map player
@@ -117,4 +126,14 @@ private:
 	class DSP* m_buttonDSPs[2] = { nullptr };
 	HoldObjectState* m_currentHoldEffects[2] = { nullptr };
 	float m_effectMix[2] = { 0.0f };
+
+	// Kept on the effect track for the whole song if the map uses pitch shifting, muted while not in use
+	class PitchShiftDSP* m_pitchShiftDSP = nullptr;
+	// Delays on the other tracks that keep them in sync with the pitch shifter
+	struct DelayedTrack
+	{
+		Ref<AudioStream> track;
+		class DSP* dsp;
+	};
+	Vector<DelayedTrack> m_delayDSPs;
 };
\ No newline at end of file
@@ -78,6 +78,8 @@ DefineEnum(GameConfigKeys,
 	Key_Back,
 	Key_Sensitivity,
 	Key_LaserReleaseTime,
+	Key_Polling, // Read keyboard events at a fixed rate between frames, so they are timestamped more precisely
+	Key_PollingRate, // Polling rate in Hz used by keyboard polling
 
 	// Controller bindings
 	Controller_DeviceID,
@@ -94,6 +96,8 @@ DefineEnum(GameConfigKeys,
 	Controller_Deadzone,
 	Controller_DirectMode,
 	Controller_Sensitivity,
+	Controller_Polling, // Poll the controller at a fixed rate between frames instead of once per frame
+	Controller_PollingRate, // Polling rate in Hz used by controller polling
 	InputBounceGuard,
 	SongSelSensMult,
 
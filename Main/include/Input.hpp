@@ -37,6 +37,10 @@ public:
 	void Update(float deltaTime);
 
 	bool GetButton(Button button) const;
+	// Time of the last press or release of a button, as reported by the event (in SDL_GetTicks milliseconds)
+	// this is already set when OnButtonPressed/OnButtonReleased are called
+	// events are stamped when they are read, so without keyboard/controller polling this is rounded to the frame that read them
+	uint32 GetButtonEventTime(Button button) const;
 	float GetAbsoluteLaser(int laser) const;
 	bool Are3BTsHeld() const;
 
@@ -47,6 +51,11 @@ public:
 	// Returns a handle to a mouse lock, release it to unlock the mouse
 	MouseLockHandle LockMouse();
 
+	// Reads the keyboard and controller when polling is enabled, called by the main loop while it waits for the next frame
+	void Poll();
+	// Time between polls in microseconds, 0 if polling is disabled
+	uint32 GetPollInterval() const;
+
 	// Event handlers
 	virtual void OnKeyPressed(int32 key);
 	virtual void OnKeyReleased(int32 key);
@@ -62,7 +71,7 @@ public:
 private:
 	void m_InitKeyboardMapping();
 	void m_InitControllerMapping();
-	void m_OnButtonInput(Button b, bool pressed);
+	void m_OnButtonInput(Button b, bool pressed, uint32 timestamp);
 
 	void m_OnGamepadButtonPressed(uint8 button);
 	void m_OnGamepadButtonReleased(uint8 button);
@@ -74,6 +83,7 @@ private:
 	InputDevice m_buttonDevice;
 
 	bool m_buttonStates[(size_t)Button::Length];
+	uint32 m_buttonEventTimes[(size_t)Button::Length] = { 0 };
 	bool m_backComboHold = false;
 	bool m_backComboInstant = false;
 	bool m_backSent = false;
@@ -103,5 +113,33 @@ private:
 
 	Ref<Gamepad> m_gamepad;
 
+	// Controller polling
+	// the main thread reads the gamepad at a fixed rate between frames,
+	// changes are timestamped when they are read and handled on the next Update
+	struct PolledButtonEvent
+	{
+		uint8 button;
+		bool pressed;
+		uint32 timestamp;
+	};
+	void m_PollController();
+	void m_ProcessPolledEvents();
+
+	bool m_pollController = false;
+	uint32 m_pollInterval = 1000;
+	Timer m_pollTimer;
+	Vector<uint8> m_polledButtons;
+	Vector<uint8> m_prevPolledButtons;
+	Vector<float> m_polledAxes;
+	float m_polledLaserDeltas[2] = { 0.0f };
+	Vector<PolledButtonEvent> m_polledEvents;
+
+	// Keyboard polling
+	// the main thread pumps the window events between frames, so key events get the time they were read
+	// instead of the time of the next frame, they are still dispatched by Window::Update
+	bool m_pollKeyboard = false;
+	uint32 m_keyboardPollInterval = 1000;
+	Timer m_keyboardPollTimer;
+
 	Graphics::Window* m_window = nullptr;
 };
@@ -0,0 +1,19 @@
+#pragma once
+
+/*
+	Disk cache for downscaled jacket images
+	thumbnails are stored as raw RGBA pixels so loading them skips decoding and resizing the original image,
+	a thumbnail is only used if the source file has not been modified since it was stored
+*/
+namespace JacketCache
+{
+	// Folder that contains the cached thumbnails
+	String GetCacheFolder();
+
+	// Returns the cached thumbnail of an image file for the requested size, or an invalid image if there is no up to date entry
+	Image Load(const String& sourcePath, Vector2i requestedSize);
+	// Stores a thumbnail of an image file, replaces the existing entry for the same size
+	bool Store(const String& sourcePath, Vector2i requestedSize, Image thumbnail);
+	// Deletes the least recently stored thumbnails until the cache takes up at most maxSize bytes
+	void Evict(uint64 maxSize);
+}
@@ -1,6 +1,11 @@
 #pragma once
 #include <Beatmap/BeatmapObjects.hpp>
 
+/*
+	Generates the geometry for laser segments
+	segments are appended to a shared vertex buffer, a new buffer is started when it is full
+	so vertices are never written to a part of a buffer that was already drawn from
+*/
 class LaserTrackBuilder
 {
 public:
@@ -9,12 +14,12 @@ public:
 	void Update(MapTime newTime);
 
 	// Generates a normal segment
-	Mesh GenerateTrackMesh(class BeatmapPlayback& playback, LaserObjectState* laser);
+	MeshRange GenerateTrackMesh(class BeatmapPlayback& playback, LaserObjectState* laser);
 
 	// Generate the starting segment of a laser
-	Mesh GenerateTrackEntry(class BeatmapPlayback& playback, LaserObjectState* laser);
+	MeshRange GenerateTrackEntry(class BeatmapPlayback& playback, LaserObjectState* laser);
 	// Generate the ending segment of a laser
-	Mesh GenerateTrackExit(class BeatmapPlayback& playback, LaserObjectState* laser);
+	MeshRange GenerateTrackExit(class BeatmapPlayback& playback, LaserObjectState* laser);
 
 	// Laser length scale at a given position
 	float GetLaserLengthScaleAt(MapTime time);
@@ -53,14 +58,23 @@ private:
 
 private:
 	void m_RecalculateConstants();
-	void m_Cleanup(MapTime newTime, Map<LaserObjectState*, Mesh>& arr);
+	void m_Cleanup(MapTime newTime, Map<LaserObjectState*, MeshRange>& arr);
+	// Writes the vertices of a new segment and adds it to the cache
+	MeshRange m_AddSegment(Map<LaserObjectState*, MeshRange>& cache, LaserObjectState* laser, const Vector<MeshGenerators::SimpleVertex>& verts);
+	Mesh m_CreateVertexBuffer();
+	void m_ReleaseAll();
 	class OpenGL* m_gl;
 	class Track* m_track;
 
 	float m_trackWidth;
 	float m_laserWidth;
 	uint32 m_laserIndex;
-	Map<LaserObjectState*, Mesh> m_objectCache;
-	Map<LaserObjectState*, Mesh> m_cachedEntries;
-	Map<LaserObjectState*, Mesh> m_cachedExits;
+	Map<LaserObjectState*, MeshRange> m_objectCache;
+	Map<LaserObjectState*, MeshRange> m_cachedEntries;
+	Map<LaserObjectState*, MeshRange> m_cachedExits;
+
+	Mesh m_vertexBuffer;
+	uint32 m_bufferSize;
+	// Next vertex to write to
+	uint32 m_head = 0;
 };
\ No newline at end of file
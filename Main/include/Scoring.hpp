@@ -3,6 +3,7 @@
 #include "HitStat.hpp"
 #include "Input.hpp"
 #include "Game.hpp"
+#include <Shared/Action.hpp>
 
 enum class TickFlags : uint8
 {
@@ -79,6 +80,10 @@ public:
 	void SetFlags(GameFlags flags);
 	void SetEndTime(MapTime time);
 
+	// Converts the timestamp of an input event (SDL_GetTicks) to map time
+	// when bound, button hits are judged at the time they happened instead of at the last playback update
+	Action<MapTime, uint32> inputEventToMapTime;
+
 	// Resets/Initializes the scoring system
 	// Called after SetPlayback
 	void Reset();
@@ -231,7 +236,9 @@ private:
 	// Updates all pending ticks
 	void m_UpdateTicks();
 	// Tries to trigger a hit event on an approaching tick
-	ObjectState* m_ConsumeTick(uint32 buttonCode);
+	ObjectState* m_ConsumeTick(uint32 buttonCode, MapTime currentTime);
+	// Map time at which the last event for this button happened
+	MapTime m_GetInputTime(Input::Button button);
 	// Called whenether missed or not
 	void m_OnTickProcessed(ScoreTick* tick, uint32 index);
 	void m_TickHit(ScoreTick* tick, uint32 index, MapTime delta = 0);
@@ -1,7 +1,6 @@
 #pragma once
 #include "Scoring.hpp"
 #include "AsyncLoadable.hpp"
-#include <unordered_set>
 
 /*
 	The object responsible for drawing the track.
@@ -39,6 +38,7 @@ public:
 	~Track();
 	virtual bool AsyncLoad() override;
 	virtual bool AsyncFinalize() override;
+	virtual bool AsyncFinalizeStep(float maxDuration, bool& finished) override;
 	void Tick(class BeatmapPlayback& playback, float deltaTime);
 
 	// Draw black laser underlays for wide lasers or all lasers if lane is hidden
@@ -46,7 +46,10 @@ public:
 	// Just the board with tick lines
 	void DrawBase(RenderQueue& rq);
 	// Draws an object
-	void DrawObjectState(RenderQueue& rq, class BeatmapPlayback& playback, ObjectState* obj, bool active, const std::unordered_set<MapTime> chipFXTimes[2]);
+	// when the skin has instanced shaders, buttons are collected and drawn together with the following buttons of the same kind
+	void DrawObjectState(RenderQueue& rq, class BeatmapPlayback& playback, ObjectState* obj, bool active);
+	// Draws the buttons still collected by DrawObjectState, call this after drawing the last object
+	void FlushObjects(RenderQueue& rq);
 	// Things like the laser pointers, hit bar and effect
 	void DrawOverlays(RenderQueue& rq);
 	// Draws a plane over the track
@@ -114,6 +117,9 @@ public:
 	Texture fxbuttonHoldTexture;
 	Material holdButtonMaterial;
 	Material buttonMaterial;
+	// Optional materials that draw all buttons of one kind at once, only valid if the skin has them
+	Material holdButtonInstancedMaterial;
+	Material buttonInstancedMaterial;
 	Material trackCoverMaterial;
 	Texture laserTextures[2];
 	Texture laserTailTextures[4]; // Entry and exit textures, both sides
@@ -154,6 +160,21 @@ private:
 	// Bar tick locations
 	Vector<float> m_barTicks;
 
+	// Per object data of instanced buttons and ticks
+	struct ButtonInstance : public VertexFormat<Vector4, Vector4>
+	{
+		// Position on the track and scale
+		Vector4 offsetScale;
+		// Track position, track scale and hasSample or objectGlow, hitState
+		Vector4 params;
+	};
+	bool m_useInstancing = false;
+	// Buttons collected by DrawObjectState that have not been drawn yet, these all use the same mesh, material and texture
+	Vector<ButtonInstance> m_buttonInstances;
+	Mesh m_buttonInstanceMesh;
+	Material m_buttonInstanceMaterial;
+	Texture m_buttonInstanceTexture;
+
 	// Active effects
 	Vector<struct TimedEffect*> m_hitEffects;
 
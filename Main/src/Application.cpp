@@ -24,6 +24,7 @@
 #include "SkinHttp.hpp"
 #include "SDL2/SDL_keycode.h"
 #include "ShadedMesh.hpp"
+#include "JacketCache.hpp"
 #ifdef EMBEDDED
 #define NANOVG_GLES2_IMPLEMENTATION
 #else
@@ -798,6 +799,8 @@ bool Application::m_Init()
 	///TODO: check if directory exists already?
 	Path::CreateDir(Path::Absolute("screenshots"));
 	Path::CreateDir(Path::Absolute("songs"));
+	Path::CreateDir(JacketCache::GetCacheFolder());
+	JacketCache::Evict(128 * 1024 * 1024);
 
 	return true;
 }
@@ -900,6 +903,7 @@ void Application::m_MainLoop()
 			if(!g_gameWindow->Update())
 				return;
 
+			m_UploadJackets();
 			m_Tick();
 			timeSinceRender = 0.0f;
 
@@ -911,10 +915,16 @@ void Application::m_MainLoop()
 		// processed callbacks for finished tasks
 		g_jobSheduler->Update();
 
+		// Read the keyboard and controller while waiting for the next frame
+		g_input.Poll();
+
 		if(timeSinceRender < targetRenderTime)
 		{
 			float timeLeft = (targetRenderTime - timeSinceRender);
 			uint32 sleepMicroSecs = (uint32)(timeLeft*1000000.0f * 0.75f);
+			uint32 pollInterval = g_input.GetPollInterval();
+			if(pollInterval > 0)
+				sleepMicroSecs = Math::Min(sleepMicroSecs, pollInterval);
 			std::this_thread::sleep_for(std::chrono::microseconds(sleepMicroSecs));
 		}
 	}
@@ -942,6 +952,11 @@ void Application::m_Tick()
 		glClearColor(0, 0, 0, 0);
 		glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 		nvgBeginFrame(g_guiState.vg, g_resolution.x, g_resolution.y, 1);
+		// Statistics are only complete after the queues are processed, so the previous frame is shown
+		RenderQueueStats lastFrameStats = RenderQueue::GetFrameStats();
+		RenderQueue::ResetFrameStats();
+		TextStats lastTextStats = FontRes::GetFrameStats();
+		FontRes::ResetFrameStats();
 		m_renderQueueBase = RenderQueue(g_gl, m_renderStateBase);
 		g_guiState.rq = &m_renderQueueBase;
 		g_guiState.t = Transform();
@@ -973,6 +988,11 @@ void Application::m_Tick()
 			nvgFillColor(g_guiState.vg, nvgRGB(0, 200, 255));
 			String fpsText = Utility::Sprintf("%.1fFPS", GetRenderFPS());
 			nvgText(g_guiState.vg, g_resolution.x - 5, g_resolution.y - 5, fpsText.c_str(), 0);
+			String statsText = Utility::Sprintf("%d draws, %d state changes", lastFrameStats.drawCalls, lastFrameStats.GetStateChanges());
+			nvgFontSize(g_guiState.vg, 14);
+			nvgText(g_guiState.vg, g_resolution.x - 5, g_resolution.y - 25, statsText.c_str(), 0);
+			String textStatsText = Utility::Sprintf("%d texts built (%.2fms), %d text buffers", lastTextStats.textsBuilt, lastTextStats.buildTime, lastTextStats.bufferAllocations);
+			nvgText(g_guiState.vg, g_resolution.x - 5, g_resolution.y - 45, textStatsText.c_str(), 0);
 		}
 		nvgEndFrame(g_guiState.vg);
 		m_renderQueueBase.Process();
@@ -1048,10 +1068,7 @@ void Application::m_Cleanup()
 	//	m_skinHtpp = nullptr;
 	//}
 
-	for (auto img : m_jacketImages)
-	{
-		delete img.second;
-	}
+	m_ClearJacketImages();
 
 	Graphics::FontRes::FreeLibrary();
 
@@ -1245,6 +1262,48 @@ int Application::LoadImageJob(const String & path, Vector2i size, int placeholde
 	return ret;
 }
 
+void Application::QueueJacketUpload(CachedJacketImage* image)
+{
+	m_pendingJacketUploads.AddBack(image);
+}
+
+void Application::m_UploadJackets()
+{
+	// Decoding happens on the job threads, but texture creation has to happen here
+	// spread it over multiple frames so scrolling through many songs doesn't cause hitches
+	static const size_t uploadBudget = 2 * 1024 * 1024;
+#ifdef EMBEDDED
+	// No mipmaps for non power of two textures
+	const int imageFlags = 0;
+#else
+	// Jackets are often drawn smaller than their loaded size
+	const int imageFlags = NVG_IMAGE_GENERATE_MIPMAPS;
+#endif
+	size_t uploaded = 0;
+	while (!m_pendingJacketUploads.empty() && uploaded < uploadBudget)
+	{
+		CachedJacketImage* target = m_pendingJacketUploads.PopFront();
+		Image& image = target->image;
+		target->texture = nvgCreateImageRGBA(g_guiState.vg, image->GetSize().x, image->GetSize().y, imageFlags, (unsigned char*)image->GetBits());
+		target->loaded = true;
+		uploaded += image->GetSize().x * image->GetSize().y * sizeof(Colori);
+		image.Release();
+	}
+}
+
+void Application::m_ClearJacketImages()
+{
+	for (auto img : m_jacketImages)
+	{
+		// Jobs keep a pointer to their target
+		if (img.second->loadingJob)
+			img.second->loadingJob->Terminate();
+		delete img.second;
+	}
+	m_jacketImages.clear();
+	m_pendingJacketUploads.clear();
+}
+
 void Application::SetScriptPath(lua_State * s)
 {
 	//Set path for 'require' (https://stackoverflow.com/questions/4125971/setting-the-global-lua-path-variable-from-c-c?lq=1)
@@ -1316,7 +1375,8 @@ void Application::ReloadSkin()
 	g_guiState.nextTextId.clear();
 	g_guiState.nextPaintId.clear();
 	g_guiState.paintCache.clear();
-	m_jacketImages.clear();
+	// The GUI context is recreated below, which also removes all jacket textures
+	m_ClearJacketImages();
 
 	for (auto& sample : m_samples)
 	{
@@ -2269,31 +2329,34 @@ bool JacketLoadingJob::Run()
 		Buffer b;
 		b.resize(response.text.length());
 		memcpy(b.data(), response.text.c_str(), b.size());
-		loadedImage = ImageRes::Create(b);
-		if (loadedImage.IsValid()) {
-			if (loadedImage->GetSize().x > w || loadedImage->GetSize().y > h) {
-				loadedImage->ReSize({ w,h });
-			}
-		}
+		loadedImage = ImageRes::Create(b, { w,h });
 		return loadedImage.IsValid();
 	}
 	else
 	{
-		loadedImage = ImageRes::Create(imagePath);
-		if (loadedImage.IsValid()) {
-			if (loadedImage->GetSize().x > w || loadedImage->GetSize().y > h) {
-				loadedImage->ReSize({ w,h });
-			}
+		// Jackets loaded at a fixed size are cached on disk after resizing
+		bool useCache = w > 0 && h > 0;
+		if (useCache)
+		{
+			loadedImage = JacketCache::Load(imagePath, { w,h });
+			if (loadedImage.IsValid())
+				return true;
 		}
+
+		// Decoded at a reduced size when the image is larger than requested
+		loadedImage = ImageRes::Create(imagePath, { w,h });
+		if (loadedImage.IsValid() && useCache)
+			JacketCache::Store(imagePath, { w,h }, loadedImage);
 		return loadedImage.IsValid();
 	}
 }
 void JacketLoadingJob::Finalize()
 {
+	target->loadingJob.Release();
 	if (IsSuccessfull())
 	{
-		///TODO: Maybe do the nvgCreateImage in Run() instead
-		target->texture = nvgCreateImageRGBA(g_guiState.vg, loadedImage->GetSize().x, loadedImage->GetSize().y, 0, (unsigned char*)loadedImage->GetBits());
-		target->loaded = true;
+		target->image = loadedImage;
+		loadedImage.Release();
+		g_application->QueueJacketUpload(target);
 	}
 }
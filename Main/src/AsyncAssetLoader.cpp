@@ -1,11 +1,41 @@
 #include "stdafx.h"
 #include "AsyncAssetLoader.hpp"
 #include "Application.hpp"
+#include "Shared/Jobs.hpp"
+#include <cfloat>
+#include <atomic>
+#include <thread>
 
 struct AsyncLoadOperation : public IAsyncLoadable
 {
 	String name;
+	bool loaded = false;
+	// Time spent in AsyncLoad and AsyncFinalize in seconds, logged after finalizing
+	float loadTime = 0.0f;
+	float finalizeTime = 0.0f;
 };
+// Decides which thread runs the load of an operation, the queued job or the thread that called Load
+// the job can still be running after Load has returned and the operation was deleted, so it is reference counted separately
+struct AsyncLoadClaim
+{
+	std::atomic<bool> claimed = { false };
+	std::atomic<bool> done = { false };
+	// Held by Load and the queued job, the last one to release it deletes it
+	std::atomic<uint32> refs = { 1 };
+};
+static void ReleaseClaim(AsyncLoadClaim* claim)
+{
+	if(--claim->refs == 0)
+		delete claim;
+}
+static void RunLoadOperation(AsyncLoadOperation* operation, AsyncLoadClaim* claim)
+{
+	Timer timer;
+	operation->loaded = operation->AsyncLoad();
+	operation->loadTime = timer.SecondsAsFloat();
+	claim->done = true;
+}
+
 struct AsyncTextureLoadOperation : public AsyncLoadOperation
 {
 	Texture& target;
@@ -73,12 +103,19 @@ struct AsyncWrapperOperation : public AsyncLoadOperation
 	{
 		return target.AsyncFinalize();
 	}
+	bool AsyncFinalizeStep(float maxDuration, bool& finished)
+	{
+		return target.AsyncFinalizeStep(maxDuration, finished);
+	}
 };
 
 class AsyncAssetLoader_Impl
 {
 public:
 	Vector<AsyncLoadOperation*> loadables;
+	// Index of the next operation to finalize
+	size_t finalizeIndex = 0;
+	bool finalizeSuccess = true;
 	~AsyncAssetLoader_Impl()
 	{
 		for(auto& loadable : loadables)
@@ -116,10 +153,45 @@ void AsyncAssetLoader::AddLoadable(IAsyncLoadable& loadable, const String& id /*
 
 bool AsyncAssetLoader::Load()
 {
-	bool success = true;
+	// None of the operations depend on each other so they are all queued at once,
+	// this function is usually called from a job itself so instead of blocking on the results
+	// it runs any operation that has not been picked up by another thread yet
+	Vector<AsyncLoadClaim*> claims;
 	for(auto& ld : m_impl->loadables)
 	{
-		if(!ld->AsyncLoad())
+		AsyncLoadOperation* operation = ld;
+		AsyncLoadClaim* claim = new AsyncLoadClaim();
+		claims.Add(claim);
+		if(!g_jobSheduler)
+			continue;
+
+		claim->refs++;
+		Job job = JobBase::CreateLambda([operation, claim]()
+		{
+			// The operation is only touched after claiming, Load waits for claimed operations before it returns
+			if(!claim->claimed.exchange(true))
+				RunLoadOperation(operation, claim);
+			ReleaseClaim(claim);
+			return true;
+		});
+		g_jobSheduler->Queue(job);
+	}
+
+	bool success = true;
+	for(size_t i = 0; i < claims.size(); i++)
+	{
+		AsyncLoadOperation* ld = m_impl->loadables[i];
+		AsyncLoadClaim* claim = claims[i];
+		if(!claim->claimed.exchange(true))
+			RunLoadOperation(ld, claim);
+		else
+		{
+			while(!claim->done)
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		ReleaseClaim(claim);
+
+		if(!ld->loaded)
 		{
 			Logf("[AsyncLoad] Load failed on %s", Logger::Error, ld->name);
 			success = false;
@@ -129,17 +201,48 @@ bool AsyncAssetLoader::Load()
 }
 bool AsyncAssetLoader::Finalize()
 {
+	bool finished = false;
 	bool success = true;
-	for(auto& ld : m_impl->loadables)
+	while(!finished)
+	{
+		success = FinalizeStep(FLT_MAX, finished);
+	}
+	return success;
+}
+bool AsyncAssetLoader::FinalizeStep(float maxDuration, bool& finished)
+{
+	Timer stepTimer;
+	Vector<AsyncLoadOperation*>& loadables = m_impl->loadables;
+	while(m_impl->finalizeIndex < loadables.size())
 	{
-		if(!ld->AsyncFinalize())
+		AsyncLoadOperation* ld = loadables[m_impl->finalizeIndex];
+		Timer timer;
+		bool operationFinished = true;
+		if(!ld->AsyncFinalizeStep(maxDuration - stepTimer.SecondsAsFloat(), operationFinished))
 		{
 			Logf("[AsyncLoad] Finalize failed on %s", Logger::Error, ld->name);
-			success = false;
+			m_impl->finalizeSuccess = false;
+			operationFinished = true;
 		}
+		ld->finalizeTime += timer.SecondsAsFloat();
+
+		if(operationFinished)
+			m_impl->finalizeIndex++;
+		if(stepTimer.SecondsAsFloat() >= maxDuration)
+			break;
+	}
+
+	finished = m_impl->finalizeIndex >= loadables.size();
+	if(!finished)
+		return true;
+
+	for(auto& ld : loadables)
+	{
+		Logf("[AsyncLoad] %s: load %.2fms, finalize %.2fms", Logger::Info, ld->name, ld->loadTime * 1000.0f, ld->finalizeTime * 1000.0f);
 	}
 
 	// Clear state
+	bool success = m_impl->finalizeSuccess;
 	delete m_impl;
 	m_impl = new AsyncAssetLoader_Impl();
 
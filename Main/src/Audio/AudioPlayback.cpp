@@ -13,6 +13,7 @@ AudioPlayback::~AudioPlayback()
 	m_CleanupDSP(m_buttonDSPs[0]);
 	m_CleanupDSP(m_buttonDSPs[1]);
 	m_CleanupDSP(m_laserDSP);
+	m_CleanupLatencyCompensation();
 }
 bool AudioPlayback::Init(class BeatmapPlayback& playback, const String& mapRootPath)
 {
@@ -22,6 +23,7 @@ bool AudioPlayback::Init(class BeatmapPlayback& playback, const String& mapRootP
 	m_CleanupDSP(m_buttonDSPs[0]);
 	m_CleanupDSP(m_buttonDSPs[1]);
 	m_CleanupDSP(m_laserDSP);
+	m_CleanupLatencyCompensation();
 
 	m_playback = &playback;
 	m_beatmap = &playback.GetBeatmap();
@@ -70,6 +72,17 @@ bool AudioPlayback::Init(class BeatmapPlayback& playback, const String& mapRootP
 			}
 		}
 	}
+
+	// Pitch shifting delays the audio, this delay is kept for the whole song so the music position never jumps
+	//	the pitch shifter stays on the effect track and the other tracks are delayed by the same amount
+	if(m_UsesPitchShift())
+	{
+		m_pitchShiftDSP = new PitchShiftDSP();
+		m_pitchShiftDSP->mix = 0.0f;
+		m_GetDSPTrack()->AddDSP(m_pitchShiftDSP);
+		if(m_fxtrack)
+			m_AddDelay(m_music);
+	}
 	
 	if (m_fxtrack.IsValid()) {
 		// Prevent loading switchables if fx track is in use.
@@ -98,6 +111,8 @@ bool AudioPlayback::Init(class BeatmapPlayback& playback, const String& mapRootP
 				{
 					// Mute all switchable audio by default
 					switchable.m_audio->SetVolume(0.0f);
+					if(m_pitchShiftDSP)
+						m_AddDelay(switchable.m_audio);
 				}
 			}
 		}
@@ -127,6 +142,20 @@ MapTime AudioPlayback::GetPosition() const
 {
 	return m_music->GetPosition();
 }
+double AudioPlayback::GetPositionAtTimestamp(uint32 timestamp) const
+{
+	// Events older than this are assumed to have a bogus timestamp
+	static const int32 maxEventAge = 250;
+
+	double position = m_music->GetPositionSeconds() * 1000.0;
+	if(m_paused)
+		return position;
+
+	// Step back from the current position by the time that passed since the event was generated
+	int32 age = (int32)(SDL_GetTicks() - timestamp);
+	age = Math::Clamp(age, 0, maxEventAge);
+	return position - (double)age * GetPlaybackSpeed();
+}
 void AudioPlayback::SetPosition(MapTime time)
 {
 	m_music->SetPosition(time);
@@ -185,7 +214,7 @@ void AudioPlayback::SetEffect(uint32 index, HoldObjectState* object, class Beatm
 	if (m_buttonEffects[index].type == EffectType::SwitchAudio)
 		return;
 
-	dsp = m_buttonEffects[index].CreateDSP(m_GetDSPTrack().GetData(), *this);
+	dsp = m_CreateDSP(m_buttonEffects[index]);
 
 	if(dsp)
 	{
@@ -254,7 +283,7 @@ void AudioPlayback::SetLaserFilterInput(float input, bool active)
 			if(m_fxtrack.IsValid() && m_laserEffectType == EffectType::Bitcrush)
 				return;
 
-			m_laserDSP = m_laserEffect.CreateDSP(m_GetDSPTrack().GetData(), *this);
+			m_laserDSP = m_CreateDSP(m_laserEffect);
 			if(!m_laserDSP)
 			{
 				Logf("Failed to create laser DSP with type %d", Logger::Warning, m_laserEffect.type);
@@ -390,14 +419,63 @@ void AudioPlayback::SetVolume(float volume)
 		if (it->m_audio)
 			it->m_audio->SetVolume(volume);
 }
+DSP* AudioPlayback::m_CreateDSP(GameAudioEffect& effect)
+{
+	// Lasers and buttons share the pitch shifter that stays on the track
+	if(effect.type == EffectType::PitchShift && m_pitchShiftDSP)
+		return m_pitchShiftDSP;
+	return effect.CreateDSP(m_GetDSPTrack().GetData(), *this);
+}
 void AudioPlayback::m_CleanupDSP(DSP*& ptr)
 {
-	if(ptr)
+	if(!ptr)
+		return;
+	if(ptr == m_pitchShiftDSP)
 	{
-		m_GetDSPTrack()->RemoveDSP(ptr);
-		delete ptr;
+		// Only mute the pitch shifter, it is removed together with the song
 		ptr = nullptr;
+		if(m_laserDSP != m_pitchShiftDSP && m_buttonDSPs[0] != m_pitchShiftDSP && m_buttonDSPs[1] != m_pitchShiftDSP)
+			m_pitchShiftDSP->mix = 0.0f;
+		return;
+	}
+	m_GetDSPTrack()->RemoveDSP(ptr);
+	delete ptr;
+	ptr = nullptr;
+}
+bool AudioPlayback::m_UsesPitchShift() const
+{
+	for(ObjectState* obj : m_beatmap->GetLinearObjects())
+	{
+		MultiObjectState* mobj = *obj;
+		if(mobj->type == ObjectType::Hold && m_beatmap->GetEffect(mobj->hold.effectType).type == EffectType::PitchShift)
+			return true;
+		if(mobj->type == ObjectType::Event && mobj->event.key == EventKey::LaserEffectType &&
+			m_beatmap->GetFilter(mobj->event.data.effectVal).type == EffectType::PitchShift)
+			return true;
+	}
+	return false;
+}
+void AudioPlayback::m_AddDelay(Ref<AudioStream> track)
+{
+	DelayDSP* delay = new DelayDSP();
+	delay->SetDelay(m_pitchShiftDSP->GetLatency());
+	track->AddDSP(delay);
+	m_delayDSPs.Add(DelayedTrack{ track, delay });
+}
+void AudioPlayback::m_CleanupLatencyCompensation()
+{
+	if(m_pitchShiftDSP)
+	{
+		m_GetDSPTrack()->RemoveDSP(m_pitchShiftDSP);
+		delete m_pitchShiftDSP;
+		m_pitchShiftDSP = nullptr;
+	}
+	for(DelayedTrack& delayed : m_delayDSPs)
+	{
+		delayed.track->RemoveDSP(delayed.dsp);
+		delete delayed.dsp;
 	}
+	m_delayDSPs.clear();
 }
 void AudioPlayback::m_SetLaserEffectParameter(float input)
 {
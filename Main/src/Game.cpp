@@ -6,6 +6,7 @@
 #include <unordered_set>
 #include <Beatmap/BeatmapPlayback.hpp>
 #include <Beatmap/MapDatabase.hpp>
+#include <Beatmap/BeatmapCache.hpp>
 #include <Shared/Profiling.hpp>
 #include "Scoring.hpp"
 #include <Audio/Audio.hpp>
@@ -32,22 +33,19 @@ extern "C"
 #include "GUI/HealthGauge.hpp"
 
 // Try load map helper
-Ref<Beatmap> TryLoadMap(const String& path)
+Ref<Beatmap> TryLoadMap(const String& path, uint64 lwt)
 {
-	// Load map file
+	// Load map file, charts that have been scanned or played before are loaded from the cache
+	Timer loadTimer;
+	BeatmapCache cache(BeatmapCache::GetDefaultFolder());
 	Beatmap* newMap = new Beatmap();
-	File mapFile;
-	if(!mapFile.OpenRead(path))
-	{
-		delete newMap;
-		return Ref<Beatmap>();
-	}
-	FileReader reader(mapFile);
-	if(!newMap->Load(reader))
+	if(!cache.Load(path, lwt, *newMap))
 	{
 		delete newMap;
 		return Ref<Beatmap>();
 	}
+	Logf("Loaded chart in %.2fms, %d objects using %d KB", Logger::Info, loadTimer.SecondsAsFloat() * 1000.0f,
+		(int32)newMap->GetLinearObjects().size(), (int32)(newMap->GetObjectMemoryUsage() / 1024));
 	return Ref<Beatmap>(newMap);
 }
 
@@ -124,8 +122,6 @@ private:
 
 	// Currently active timing point
 	const TimingPoint* m_currentTiming;
-	// Currently visible gameplay objects
-	Vector<ObjectState*> m_currentObjectSet;
 	MapTime m_lastMapTime;
 
 	// Rate to sample gauge;
@@ -233,7 +229,9 @@ public:
 			return false;
 		}
 
-		m_beatmap = TryLoadMap(m_mapPath);
+		// Use the write time the database scanned the chart at, that is what its cache entry was made with
+		uint64 lwt = m_diffIndex.id >= 0 ? m_diffIndex.lwt : File::GetLastWriteTime(m_mapPath);
+		m_beatmap = TryLoadMap(m_mapPath, lwt);
 
 		// Check failure of above loading attempts
 		if(!m_beatmap)
@@ -353,12 +351,27 @@ public:
 
 		// Load particle material
 		m_particleSystem = ParticleSystemRes::Create(g_gl);
+		m_particleSystem->SetJobSheduler(g_jobSheduler);
 
 
 		return true;
 	}
+	virtual bool AsyncFinalizeStep(float maxDuration, bool& finished) override
+	{
+		// Spread the asset uploads over multiple steps, the rest of the setup is done at once afterwards
+		finished = false;
+		bool loaderFinished = false;
+		if(!loader.FinalizeStep(maxDuration, loaderFinished))
+			return false;
+		if(!loaderFinished)
+			return true;
+
+		finished = true;
+		return AsyncFinalize();
+	}
 	virtual bool AsyncFinalize() override
 	{
+		// Does nothing if the loader was already finalized by AsyncFinalizeStep
 		if (!loader.Finalize())
 			return false;
 
@@ -417,6 +430,13 @@ public:
 		m_scoring.SetPlayback(m_playback);
 		m_scoring.SetEndTime(m_endTime);
 		m_scoring.SetInput(&g_input);
+		m_scoring.inputEventToMapTime.BindLambda([this](uint32 timestamp)
+		{
+			// Judge against the music clock at the time of the event, not the frame that processed it
+			if(!m_started)
+				return m_playback.GetLastTime();
+			return (MapTime)m_audioPlayback.GetPositionAtTimestamp(timestamp) - m_audioOffset;
+		});
 		m_scoring.Reset(); // Initialize
 
 		g_input.OnButtonPressed.Add(this, &Game_Impl::m_OnButtonPressed);
@@ -673,47 +693,24 @@ public:
 		{
 			msViewRange = 480000.0 / m_playback.cModSpeed;
 		}
-		m_currentObjectSet = m_playback.GetObjectsInRange(msViewRange);
-		// Sort objects to draw
-		// fx holds -> bt holds -> fx chips -> bt chips
-		m_currentObjectSet.Sort([](const TObjectState<void>* a, const TObjectState<void>* b)
-		{
-			auto ObjectRenderPriorty = [](const TObjectState<void>* a)
-			{
-				if (a->type == ObjectType::Single)
-					return (((ButtonObjectState*)a)->index < 4) ? 1 : 2;
-				else if (a->type == ObjectType::Hold)
-					return (((ButtonObjectState*)a)->index < 4) ? 3 : 4;
-				else
-					return 0;
-			};
-			uint32 renderPriorityA = ObjectRenderPriorty(a);
-			uint32 renderPriorityB = ObjectRenderPriorty(b);
-			return renderPriorityA > renderPriorityB;
-		});
-
-		//TODO: Set as bool on the button object during parsing(?)
-		std::unordered_set<MapTime> chipFXTimes[2];
-		for (const auto& obj : m_currentObjectSet) {
-			if (obj->type == ObjectType::Single) {
-				auto b = (ButtonObjectState*)obj;
-				if (b->index > 3) {
-					chipFXTimes[b->index - 4].insert(b->time);
-				}
-			}
-		}
+		m_playback.UpdateVisibleObjects(msViewRange);
 
 		/// TODO: Performance impact analysis.
-		m_track->DrawLaserBase(renderQueue, m_playback, m_currentObjectSet);
+		m_track->DrawLaserBase(renderQueue, m_playback, m_playback.GetVisibleObjects(BeatmapPlayback::Lasers));
 
 		// Draw the base track + time division ticks
 		m_track->DrawBase(renderQueue);
 
-		for(auto& object : m_currentObjectSet)
+		// Groups are in draw order: fx holds -> bt holds -> fx chips -> bt chips -> lasers
+		for(uint32 i = 0; i < BeatmapPlayback::NumVisibleObjectGroups; i++)
 		{
-			if(m_hiddenObjects.find(object) == m_hiddenObjects.end())
-				m_track->DrawObjectState(renderQueue, m_playback, object, m_scoring.IsObjectHeld(object), chipFXTimes);
+			for(ObjectState* object : m_playback.GetVisibleObjects((BeatmapPlayback::VisibleObjectGroup)i))
+			{
+				if(m_hiddenObjects.find(object) == m_hiddenObjects.end())
+					m_track->DrawObjectState(renderQueue, m_playback, object, m_scoring.IsObjectHeld(object));
+			}
 		}
+		m_track->FlushObjects(renderQueue);
 		if(m_showCover)
 			m_track->DrawTrackCover(renderQueue);
 
@@ -1327,6 +1324,7 @@ public:
 		textPos.y += RenderText(bms.artist, textPos).y;
 		textPos.y += RenderText(Utility::Sprintf("%.2f FPS", g_application->GetRenderFPS()), textPos).y;
 		textPos.y += RenderText(Utility::Sprintf("Audio Offset: %d ms", g_audio->audioLatency), textPos).y;
+		textPos.y += RenderText(Utility::Sprintf("Audio Overruns: %d", g_audio->GetOverrunCount()), textPos).y;
 
 		float currentBPM = (float)(60000.0 / tp.beatDuration);
 		textPos.y += RenderText(Utility::Sprintf("BPM: %.1f", currentBPM), textPos).y;
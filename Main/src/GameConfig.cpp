@@ -85,6 +85,8 @@ void GameConfig::InitDefaults()
 	Set(GameConfigKeys::Key_Back, SDLK_ESCAPE);
 	Set(GameConfigKeys::Key_Sensitivity, 3.0f);
 	Set(GameConfigKeys::Key_LaserReleaseTime, 0.0f);
+	Set(GameConfigKeys::Key_Polling, true);
+	Set(GameConfigKeys::Key_PollingRate, 1000);
 
 	// Default controller settings
 	Set(GameConfigKeys::Controller_DeviceID, 0); // First device
@@ -101,6 +103,8 @@ void GameConfig::InitDefaults()
 	Set(GameConfigKeys::Controller_Sensitivity, 1.0f);
 	Set(GameConfigKeys::Controller_Deadzone, 0.f);
 	Set(GameConfigKeys::Controller_DirectMode, false);
+	Set(GameConfigKeys::Controller_Polling, false);
+	Set(GameConfigKeys::Controller_PollingRate, 1000);
 
 	// Default mouse settings
 	Set(GameConfigKeys::Mouse_Laser0Axis, 0);
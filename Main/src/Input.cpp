@@ -61,9 +61,41 @@ void Input::Init(Graphics::Window& wnd)
 
 	// Init keyboard mapping
 	m_InitKeyboardMapping();
+
+	if(m_gamepad && g_gameConfig.GetBool(GameConfigKeys::Controller_Polling))
+	{
+		int32 pollRate = Math::Clamp(g_gameConfig.GetInt(GameConfigKeys::Controller_PollingRate), 100, 8000);
+		m_pollInterval = 1000000 / pollRate;
+		m_polledButtons.resize(m_gamepad->NumButtons());
+		m_prevPolledButtons.resize(m_gamepad->NumButtons());
+		m_polledAxes.resize(m_gamepad->NumAxes());
+
+		// Initial state, changes from here on are sent as events
+		m_gamepad->PollState(m_prevPolledButtons.data(), m_polledAxes.data());
+		for(uint32 i = 0; i < 2; i++)
+		{
+			if(m_controllerAxisMapping[i] < m_polledAxes.size())
+				m_prevLaserStates[i] = m_polledAxes[m_controllerAxisMapping[i]];
+		}
+		m_pollController = true;
+		m_pollTimer.Restart();
+		Logf("Polling controller at %d Hz", Logger::Info, pollRate);
+	}
+
+	if((m_buttonDevice == InputDevice::Keyboard || m_laserDevice == InputDevice::Keyboard) && g_gameConfig.GetBool(GameConfigKeys::Key_Polling))
+	{
+		int32 pollRate = Math::Clamp(g_gameConfig.GetInt(GameConfigKeys::Key_PollingRate), 100, 8000);
+		m_keyboardPollInterval = 1000000 / pollRate;
+		m_pollKeyboard = true;
+		m_keyboardPollTimer.Restart();
+		Logf("Polling keyboard at %d Hz", Logger::Info, pollRate);
+	}
 }
 void Input::Cleanup()
 {
+	m_pollController = false;
+	m_pollKeyboard = false;
+	m_polledEvents.clear();
 	if(m_gamepad)
 	{
 		m_gamepad->OnButtonPressed.RemoveAll(this);
@@ -79,8 +111,78 @@ void Input::Cleanup()
 	}
 }
 
+void Input::Poll()
+{
+	if(m_pollKeyboard && m_keyboardPollTimer.SecondsAsDouble() * 1000000.0 >= (double)m_keyboardPollInterval)
+	{
+		m_keyboardPollTimer.Restart();
+		m_window->PumpEvents();
+	}
+	if(m_pollController && m_pollTimer.SecondsAsDouble() * 1000000.0 >= (double)m_pollInterval)
+	{
+		m_pollTimer.Restart();
+		m_PollController();
+	}
+}
+uint32 Input::GetPollInterval() const
+{
+	uint32 interval = 0;
+	if(m_pollKeyboard)
+		interval = m_keyboardPollInterval;
+	if(m_pollController)
+		interval = interval > 0 ? Math::Min(interval, m_pollInterval) : m_pollInterval;
+	return interval;
+}
+void Input::m_PollController()
+{
+	m_gamepad->PollState(m_polledButtons.data(), m_polledAxes.data());
+	uint32 timestamp = SDL_GetTicks();
+
+	for(uint32 i = 0; i < (uint32)m_polledButtons.size(); i++)
+	{
+		if(m_polledButtons[i] != m_prevPolledButtons[i])
+		{
+			m_polledEvents.Add({ (uint8)i, m_polledButtons[i] != 0, timestamp });
+			m_prevPolledButtons[i] = m_polledButtons[i];
+		}
+	}
+
+	if(m_laserDevice == InputDevice::Controller)
+	{
+		for(uint32 i = 0; i < 2; i++)
+		{
+			if(m_controllerAxisMapping[i] >= m_polledAxes.size())
+				continue;
+			float axisState = m_polledAxes[m_controllerAxisMapping[i]];
+			float delta = axisState - m_prevLaserStates[i];
+			if (fabs(delta) > 1.5f)
+				delta += 2 * (Math::Sign(delta) * -1);
+			m_polledLaserDeltas[i] += delta;
+			m_prevLaserStates[i] = axisState;
+		}
+	}
+}
+void Input::m_ProcessPolledEvents()
+{
+	for(const PolledButtonEvent& evt : m_polledEvents)
+	{
+		auto it = m_controllerMap.equal_range(evt.button);
+		for(auto it1 = it.first; it1 != it.second; it1++)
+			m_OnButtonInput(it1->second, evt.pressed, evt.timestamp);
+	}
+	m_polledEvents.clear();
+}
+
 void Input::Update(float deltaTime)
 {
+	// Read the current controller state, then handle the changes seen since the last update with the time they were read
+	if(m_pollController)
+	{
+		m_PollController();
+		m_pollTimer.Restart();
+		m_ProcessPolledEvents();
+	}
+
 	for(auto it = m_mouseLocks.begin(); it != m_mouseLocks.end();)
 	{
 		if(it->GetRefCount() == 1)
@@ -150,17 +252,27 @@ void Input::Update(float deltaTime)
 		{
 			for(uint32 i = 0; i < 2; i++)
 			{
-				float axisState = m_gamepad->GetAxis(m_controllerAxisMapping[i]);
-				float delta = axisState;
-				if (!m_controllerDirectMode)
-					delta -= m_prevLaserStates[i];
-				if (fabs(delta) > 1.5f)
-					delta += 2 * (Math::Sign(delta) * -1);
+				float delta;
+				if(m_pollController)
+				{
+					// Movement accumulated by the polls since the last update
+					delta = m_controllerDirectMode ? m_prevLaserStates[i] : m_polledLaserDeltas[i];
+					m_polledLaserDeltas[i] = 0.0f;
+				}
+				else
+				{
+					float axisState = m_gamepad->GetAxis(m_controllerAxisMapping[i]);
+					delta = axisState;
+					if (!m_controllerDirectMode)
+						delta -= m_prevLaserStates[i];
+					if (fabs(delta) > 1.5f)
+						delta += 2 * (Math::Sign(delta) * -1);
+					m_prevLaserStates[i] = axisState;
+				}
 				if (fabs(delta) < m_controllerDeadzone)
 					m_laserStates[i] = 0.0f;
 				else
 					m_laserStates[i] = delta * m_controllerSensitivity;
-				m_prevLaserStates[i] = axisState;
 			}
 		}
 	}
@@ -191,6 +303,11 @@ bool Input::GetButton(Button button) const
 	return m_buttonStates[(size_t)button];
 }
 
+uint32 Input::GetButtonEventTime(Button button) const
+{
+	return m_buttonEventTimes[(size_t)button];
+}
+
 float Input::GetAbsoluteLaser(int laser) const
 {
 	return m_absoluteLaserStates[laser];
@@ -293,12 +410,14 @@ void Input::m_InitControllerMapping()
 	}
 }
 
-void Input::m_OnButtonInput(Button b, bool pressed)
+void Input::m_OnButtonInput(Button b, bool pressed, uint32 timestamp)
 {
 	bool& state = m_buttonStates[(size_t)b];
 	if(state != pressed)
 	{
 		state = pressed;
+		// Keep the time the event actually happened, the frame that handles it might be several ms later
+		m_buttonEventTimes[(size_t)b] = timestamp;
 		if(state)
 		{
 			if (b == Button::BT_S && m_backComboInstant && Are3BTsHeld())
@@ -338,17 +457,25 @@ void Input::m_OnButtonInput(Button b, bool pressed)
 
 void Input::m_OnGamepadButtonPressed(uint8 button)
 {
+	// Handled by the controller polling instead
+	if(m_pollController)
+		return;
+
 	// Handle button mappings
 	auto it = m_controllerMap.equal_range(button);
 	for(auto it1 = it.first; it1 != it.second; it1++)
-		m_OnButtonInput(it1->second, true);
+		m_OnButtonInput(it1->second, true, m_window->GetEventTimestamp());
 }
 void Input::m_OnGamepadButtonReleased(uint8 button)
 {
+	// Handled by the controller polling instead
+	if(m_pollController)
+		return;
+
 	// Handle button mappings
 	auto it = m_controllerMap.equal_range(button);
 	for(auto it1 = it.first; it1 != it.second; it1++)
-		m_OnButtonInput(it1->second, false);
+		m_OnButtonInput(it1->second, false, m_window->GetEventTimestamp());
 }
 
 void Input::OnKeyPressed(int32 key)
@@ -356,14 +483,14 @@ void Input::OnKeyPressed(int32 key)
 	// Handle button mappings
 	auto it = m_buttonMap.equal_range(key);
 	for(auto it1 = it.first; it1 != it.second; it1++)
-		m_OnButtonInput(it1->second, true);
+		m_OnButtonInput(it1->second, true, m_window->GetEventTimestamp());
 }
 void Input::OnKeyReleased(int32 key)
 {
 	// Handle button mappings
 	auto it = m_buttonMap.equal_range(key);
 	for(auto it1 = it.first; it1 != it.second; it1++)
-		m_OnButtonInput(it1->second, false);
+		m_OnButtonInput(it1->second, false, m_window->GetEventTimestamp());
 }
 
 void Input::OnMouseMotion(int32 x, int32 y)
@@ -0,0 +1,119 @@
+#include "stdafx.h"
+#include "JacketCache.hpp"
+#include "Shared/Files.hpp"
+
+namespace JacketCache
+{
+	static const char cacheMagic[4] = { 'U', 'J', 'C', '2' };
+	static const char* cacheExtension = "ujc";
+
+	// Followed by the source path and the pixels
+	struct CacheHeader
+	{
+		char magic[4];
+		int32 width;
+		int32 height;
+		uint32 sourcePathLength;
+		uint64 sourceWriteTime;
+	};
+
+	// FNV-1a hash of the source path, used as the file name
+	static uint64 HashPath(const String& path)
+	{
+		uint64 hash = 14695981039346656037ULL;
+		for(char c : path)
+		{
+			hash ^= (uint8)c;
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+	static String GetCachePath(const String& sourcePath, Vector2i requestedSize)
+	{
+		return GetCacheFolder() + Path::sep + Utility::Sprintf("%016llx_%dx%d.%s",
+			(unsigned long long)HashPath(sourcePath), requestedSize.x, requestedSize.y, cacheExtension);
+	}
+
+	String GetCacheFolder()
+	{
+		return Path::Absolute("jacketcache");
+	}
+
+	Image Load(const String& sourcePath, Vector2i requestedSize)
+	{
+		File file;
+		String cachePath = GetCachePath(sourcePath, requestedSize);
+		if(!Path::FileExists(cachePath) || !file.OpenRead(cachePath))
+			return Image();
+
+		CacheHeader header;
+		if(file.Read(&header, sizeof(header)) != sizeof(header) || memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0)
+			return Image();
+
+		// Different paths can have the same hash
+		if(header.sourcePathLength != sourcePath.size())
+			return Image();
+		String storedPath;
+		storedPath.resize(header.sourcePathLength);
+		if(file.Read(&storedPath[0], storedPath.size()) != storedPath.size() || storedPath != sourcePath)
+			return Image();
+
+		// Outdated entries get replaced after the source image is loaded
+		if(header.sourceWriteTime != File::GetLastWriteTime(sourcePath))
+			return Image();
+
+		if(header.width <= 0 || header.height <= 0 || header.width > requestedSize.x || header.height > requestedSize.y)
+			return Image();
+
+		// Read the pixels straight into the image
+		Image image = ImageRes::Create(Vector2i(header.width, header.height));
+		size_t dataSize = header.width * header.height * sizeof(Colori);
+		if(file.GetSize() != sizeof(header) + header.sourcePathLength + dataSize || file.Read(image->GetBits(), dataSize) != dataSize)
+			return Image();
+
+		return image;
+	}
+
+	bool Store(const String& sourcePath, Vector2i requestedSize, Image thumbnail)
+	{
+		CacheHeader header = {};
+		memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+		header.width = thumbnail->GetSize().x;
+		header.height = thumbnail->GetSize().y;
+		header.sourcePathLength = (uint32)sourcePath.size();
+		header.sourceWriteTime = File::GetLastWriteTime(sourcePath);
+
+		// Write to a temporary file first so other threads never read a partially written entry
+		String cachePath = GetCachePath(sourcePath, requestedSize);
+		String tempPath = cachePath + ".tmp";
+		{
+			File file;
+			if(!file.OpenWrite(tempPath))
+				return false;
+			size_t dataSize = header.width * header.height * sizeof(Colori);
+			if(file.Write(&header, sizeof(header)) != sizeof(header) ||
+				file.Write(sourcePath.data(), sourcePath.size()) != sourcePath.size() ||
+				file.Write(thumbnail->GetBits(), dataSize) != dataSize)
+			{
+				file.Close();
+				Path::Delete(tempPath);
+				return false;
+			}
+		}
+
+		if(!Path::Rename(tempPath, cachePath, true))
+		{
+			Path::Delete(tempPath);
+			return false;
+		}
+		return true;
+	}
+
+	void Evict(uint64 maxSize)
+	{
+		// Leftover temporary files are not matched by the extension filter, they are overwritten by the next store of the same entry
+		uint32 numDeleted = Files::DeleteOldest(GetCacheFolder(), maxSize, cacheExtension);
+		if(numDeleted > 0)
+			Logf("Removed %d old jacket cache entries", Logger::Info, numDeleted);
+	}
+}
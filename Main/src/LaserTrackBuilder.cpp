@@ -19,13 +19,18 @@ LaserTrackBuilder::LaserTrackBuilder(class OpenGL* gl, class Track* track, uint3
 	laserTextureSize = track->laserTextures[0]->GetSize(); // NOTE: expects left/right textures to be the same size!
 	laserEntryTextureSize = track->laserTailTextures[0]->GetSize();
 	laserExitTextureSize = track->laserTailTextures[2]->GetSize();
+
+	// Room for a few hundred segments, more than are ever visible at once
+	m_bufferSize = 16384;
+	m_vertexBuffer = m_CreateVertexBuffer();
 }
-Mesh LaserTrackBuilder::GenerateTrackMesh(class BeatmapPlayback& playback, LaserObjectState* laser)
+MeshRange LaserTrackBuilder::GenerateTrackMesh(class BeatmapPlayback& playback, LaserObjectState* laser)
 {
-	if(m_objectCache.Contains(laser))
-		return m_objectCache[laser];
+	auto it = m_objectCache.find(laser);
+	if(it != m_objectCache.end())
+		return it->second;
 
-	Mesh newMesh = MeshRes::Create(m_gl);
+	Vector<MeshGenerators::SimpleVertex> verts;
 
 	float length = playback.DurationToViewDistanceAtTime(laser->time, laser->duration);
 
@@ -70,7 +75,7 @@ Mesh LaserTrackBuilder::GenerateTrackMesh(class BeatmapPlayback& playback, Laser
 		Rect3D centerTop = centerBottom;
 		centerTop.pos.y = centerMiddle.Top();
 
-		Vector<MeshGenerators::SimpleVertex> verts =
+		verts =
 		{
 			{ { centerMiddle.Left() + offsetB, centerMiddle.Bottom(),  0.0f },{ uvB, 0.0f } }, // BL
 			{ { centerMiddle.Right() + offsetB, centerMiddle.Bottom(),  0.0f },{ uvB, 1.0f } }, // BR
@@ -162,9 +167,6 @@ Mesh LaserTrackBuilder::GenerateTrackMesh(class BeatmapPlayback& playback, Laser
 			for (auto& v : rightVerts)
 				verts.Add(v);
 		}
-
-		newMesh->SetData(verts);
-		newMesh->SetPrimitiveType(PrimitiveType::TriangleList);
 	}
 	else
 	{
@@ -192,7 +194,7 @@ Mesh LaserTrackBuilder::GenerateTrackMesh(class BeatmapPlayback& playback, Laser
 		float vMin = 0.0f;
 		float vMax = (int)((length * laserLengthScale) / actualLaserHeight);
 
-		Vector<MeshGenerators::SimpleVertex> verts =
+		verts =
 		{
 			{ { points[0].x - actualLaserWidth, points[0].y,  0.0f },{ uMin, vMax } }, // BL
 			{ { points[0].x + actualLaserWidth, points[0].y,  0.0f },{ uMax, vMax } }, // BR
@@ -202,24 +204,17 @@ Mesh LaserTrackBuilder::GenerateTrackMesh(class BeatmapPlayback& playback, Laser
 			{ { points[1].x + actualLaserWidth, points[1].y,  0.0f },{ uMax, vMin } }, // TR
 			{ { points[1].x - actualLaserWidth, points[1].y,  0.0f },{ uMin, vMin } }, // TL
 		};
-
-
-		newMesh->SetData(verts);
-		newMesh->SetPrimitiveType(PrimitiveType::TriangleList);
 	}
 
-	// Cache this mesh
-	m_objectCache.Add(laser, newMesh);
-	return newMesh;
+	return m_AddSegment(m_objectCache, laser, verts);
 }
 
-Mesh LaserTrackBuilder::GenerateTrackEntry(class BeatmapPlayback& playback, LaserObjectState* laser)
+MeshRange LaserTrackBuilder::GenerateTrackEntry(class BeatmapPlayback& playback, LaserObjectState* laser)
 {
 	assert(laser->prev == nullptr);
-	if(m_cachedEntries.Contains(laser))
-		return m_cachedEntries[laser];
-
-	Mesh newMesh = MeshRes::Create(m_gl);
+	auto it = m_cachedEntries.find(laser);
+	if(it != m_cachedEntries.end())
+		return it->second;
 
 	// Starting point of laser
 	float startingX = laser->points[0] * effectiveWidth - effectiveWidth * 0.5f;
@@ -236,21 +231,14 @@ Mesh LaserTrackBuilder::GenerateTrackEntry(class BeatmapPlayback& playback, Lase
 	Rect uv = Rect(-0.5f, 0.0f, 1.5f, 1.0f);
 	MeshGenerators::GenerateSimpleXYQuad(pos, uv, verts);
 
-	newMesh->SetData(verts);
-	newMesh->SetPrimitiveType(PrimitiveType::TriangleList);
-
-	// Cache this mesh
-	m_cachedEntries.Add(laser, newMesh);
-	return newMesh;
-
+	return m_AddSegment(m_cachedEntries, laser, verts);
 }
-Mesh LaserTrackBuilder::GenerateTrackExit(class BeatmapPlayback& playback, LaserObjectState* laser)
+MeshRange LaserTrackBuilder::GenerateTrackExit(class BeatmapPlayback& playback, LaserObjectState* laser)
 {
 	assert(laser->next == nullptr);
-	if(m_cachedExits.Contains(laser))
-		return m_cachedExits[laser];
-
-	Mesh newMesh = MeshRes::Create(m_gl);
+	auto it = m_cachedExits.find(laser);
+	if(it != m_cachedExits.end())
+		return it->second;
 
 	// Ending point of laser 
 	float startingX = laser->points[1] * effectiveWidth - effectiveWidth * 0.5f;
@@ -276,12 +264,7 @@ Mesh LaserTrackBuilder::GenerateTrackExit(class BeatmapPlayback& playback, Laser
 	Rect uv = Rect(-0.5f, 0.0f, 1.5f, 1.0f);
 	MeshGenerators::GenerateSimpleXYQuad(pos, uv, verts);
 
-	newMesh->SetData(verts);
-	newMesh->SetPrimitiveType(PrimitiveType::TriangleList);
-
-	// Cache this mesh
-	m_cachedExits.Add(laser, newMesh);
-	return newMesh;
+	return m_AddSegment(m_cachedExits, laser, verts);
 }
 
 float LaserTrackBuilder::GetLaserLengthScaleAt(MapTime time)
@@ -317,9 +300,54 @@ void LaserTrackBuilder::m_RecalculateConstants()
 	effectiveWidth = m_trackWidth - m_laserWidth;
 }
 
-void LaserTrackBuilder::m_Cleanup(MapTime newTime, Map<LaserObjectState*, Mesh>& arr)
+MeshRange LaserTrackBuilder::m_AddSegment(Map<LaserObjectState*, MeshRange>& cache, LaserObjectState* laser, const Vector<MeshGenerators::SimpleVertex>& verts)
+{
+	uint32 count = (uint32)verts.size();
+
+	MeshRange range;
+	if(count <= m_bufferSize)
+	{
+		if(m_bufferSize - m_head < count)
+		{
+			// Continue in a new buffer instead of overwriting the start of this one, which may still be read by draws in flight
+			// the old buffer is released once the last segment that uses it is released
+			m_vertexBuffer = m_CreateVertexBuffer();
+			m_head = 0;
+		}
+		m_vertexBuffer->UpdateData(verts, m_head);
+		range = MeshRange(m_vertexBuffer, m_head, count);
+		m_head += count;
+	}
+	else
+	{
+		// Too big for the shared buffer, use a separate mesh for this segment
+		Mesh mesh = MeshRes::Create(m_gl);
+		mesh->SetData(verts);
+		mesh->SetPrimitiveType(PrimitiveType::TriangleList);
+		range = MeshRange(mesh);
+	}
+
+	cache.Add(laser, range);
+	return range;
+}
+Mesh LaserTrackBuilder::m_CreateVertexBuffer()
+{
+	Mesh mesh = MeshRes::Create(m_gl);
+	mesh->Allocate<MeshGenerators::SimpleVertex>(m_bufferSize);
+	mesh->SetPrimitiveType(PrimitiveType::TriangleList);
+	return mesh;
+}
+void LaserTrackBuilder::m_ReleaseAll()
+{
+	// The write position is kept so segments that were already queued for drawing are not overwritten
+	m_objectCache.clear();
+	m_cachedEntries.clear();
+	m_cachedExits.clear();
+}
+
+void LaserTrackBuilder::m_Cleanup(MapTime newTime, Map<LaserObjectState*, MeshRange>& arr)
 {
-	// Cleanup unused meshes
+	// Cleanup unused segments
 	for(auto it = arr.begin(); it != arr.end();)
 	{
 		LaserObjectState* obj = it->first;
@@ -334,9 +362,7 @@ void LaserTrackBuilder::m_Cleanup(MapTime newTime, Map<LaserObjectState*, Mesh>&
 }
 void LaserTrackBuilder::Reset()
 {
-	m_objectCache.clear();
-	m_cachedEntries.clear();
-	m_cachedExits.clear();
+	m_ReleaseAll();
 	m_RecalculateConstants();
 }
 void LaserTrackBuilder::Update(MapTime newTime)
@@ -8,6 +8,7 @@
 #include "GameConfig.hpp"
 #include "cpr/util.h"
 #include "SongSelect.hpp"
+#include <Beatmap/BeatmapCache.hpp>
 #include "SettingsScreen.hpp"
 #include "SkinConfig.hpp"
 
@@ -576,17 +577,10 @@ void  MultiplayerScreen::GetMapBPMForSpeed(String path, struct MultiplayerBPMInf
 
 	// Load map
 	Beatmap* newMap = new Beatmap();
-	File mapFile;
-	if (!mapFile.OpenRead(path))
-	{
-		Logf("Could not read path for beatmap: %s", Logger::Error, path);
-		delete newMap;
-		info = { 0 };
-		return;
-	}
-	FileReader reader(mapFile);
-	if (!newMap->Load(reader))
+	BeatmapCache cache(BeatmapCache::GetDefaultFolder());
+	if (!cache.Load(path, File::GetLastWriteTime(path), *newMap))
 	{
+		Logf("Could not load beatmap: %s", Logger::Error, path);
 		delete newMap;
 		info = { 0 };
 		return;
@@ -1244,6 +1238,8 @@ bool MultiplayerScreen::AsyncFinalize()
 
 	// Start the map database
 	m_mapDatabase.AddSearchPath(g_gameConfig.GetString(GameConfigKeys::SongFolder));
+	m_mapDatabase.SetJobSheduler(g_jobSheduler);
+	m_mapDatabase.SetChartCacheFolder(BeatmapCache::GetDefaultFolder());
 	m_mapDatabase.OnSearchStatusUpdated.Add(this, &MultiplayerScreen::OnSearchStatusUpdated);
 	m_mapDatabase.StartSearching();
 
@@ -767,10 +767,8 @@ void Scoring::m_UpdateTicks()
 		}
 	}
 }
-ObjectState* Scoring::m_ConsumeTick(uint32 buttonCode)
+ObjectState* Scoring::m_ConsumeTick(uint32 buttonCode, MapTime currentTime)
 {
-	MapTime currentTime = m_playback->GetLastTime();
-
 	assert(buttonCode < 8);
 
 	if (m_ticks[buttonCode].size() > 0)
@@ -1172,17 +1170,18 @@ void Scoring::m_OnButtonPressed(Input::Button buttonCode)
 
 	if (buttonCode < Input::Button::BT_S)
 	{
-		int32 guardDelta = m_playback->GetLastTime() - m_buttonGuardTime[(uint32)buttonCode];
-		if (guardDelta < m_bounceGuard && guardDelta >= 0 && m_playback->GetLastTime() > 0.0)
+		MapTime inputTime = m_GetInputTime(buttonCode);
+		int32 guardDelta = inputTime - m_buttonGuardTime[(uint32)buttonCode];
+		if (guardDelta < m_bounceGuard && guardDelta >= 0 && inputTime > 0.0)
 		{
-			//Logf("Button %d press bounce guard hit at %dms", Logger::Info, buttonCode, m_playback->GetLastTime());
+			//Logf("Button %d press bounce guard hit at %dms", Logger::Info, buttonCode, inputTime);
 			return;
 		}
 
-		//Logf("Button %d pressed at %dms", Logger::Info, buttonCode, m_playback->GetLastTime());
-		m_buttonHitTime[(uint32)buttonCode] = m_playback->GetLastTime();
-		m_buttonGuardTime[(uint32)buttonCode] = m_playback->GetLastTime();
-		ObjectState* obj = m_ConsumeTick((uint32)buttonCode);
+		//Logf("Button %d pressed at %dms", Logger::Info, buttonCode, inputTime);
+		m_buttonHitTime[(uint32)buttonCode] = inputTime;
+		m_buttonGuardTime[(uint32)buttonCode] = inputTime;
+		ObjectState* obj = m_ConsumeTick((uint32)buttonCode, inputTime);
 		if (!obj)
 		{
 			// Fire event for idle hits
@@ -1192,29 +1191,38 @@ void Scoring::m_OnButtonPressed(Input::Button buttonCode)
 	else if (buttonCode > Input::Button::BT_S)
 	{
 		ObjectState* obj = nullptr;
+		MapTime inputTime = m_GetInputTime(buttonCode);
 		if (buttonCode < Input::Button::LS_1Neg)
-			obj = m_ConsumeTick(6); // Laser L
+			obj = m_ConsumeTick(6, inputTime); // Laser L
 		else
-			obj = m_ConsumeTick(7); // Laser R
+			obj = m_ConsumeTick(7, inputTime); // Laser R
 	}
 }
 void Scoring::m_OnButtonReleased(Input::Button buttonCode)
 {
 	if (buttonCode < Input::Button::BT_S)
 	{
-		int32 guardDelta = m_playback->GetLastTime() - m_buttonGuardTime[(uint32)buttonCode];
+		MapTime inputTime = m_GetInputTime(buttonCode);
+		int32 guardDelta = inputTime - m_buttonGuardTime[(uint32)buttonCode];
 		if (guardDelta < m_bounceGuard && guardDelta >= 0)
 		{
-			//Logf("Button %d release bounce guard hit at %dms", Logger::Info, buttonCode, m_playback->GetLastTime());
+			//Logf("Button %d release bounce guard hit at %dms", Logger::Info, buttonCode, inputTime);
 			return;
 		}
-		m_buttonGuardTime[(uint32)buttonCode] = m_playback->GetLastTime();
+		m_buttonGuardTime[(uint32)buttonCode] = inputTime;
 	}
 
 	//Logf("Button %d released at %dms", Logger::Info, buttonCode, m_playback->GetLastTime());
 	m_ReleaseHoldObject((uint32)buttonCode);
 }
 
+MapTime Scoring::m_GetInputTime(Input::Button button)
+{
+	if (m_input && inputEventToMapTime.IsBound())
+		return inputEventToMapTime.Call(m_input->GetButtonEventTime(button));
+	return m_playback->GetLastTime();
+}
+
 MapTotals Scoring::CalculateMapTotals() const
 {
 	MapTotals ret = { 0 };
@@ -3,6 +3,7 @@
 #include "TitleScreen.hpp"
 #include "Application.hpp"
 #include <Shared/Profiling.hpp>
+#include <Beatmap/BeatmapCache.hpp>
 #include "Scoring.hpp"
 #include "Input.hpp"
 #include "Game.hpp"
@@ -1157,6 +1158,8 @@ public:
 		m_selectionWheel->OnDifficultySelected.Add(this, &SongSelect_Impl::OnDifficultySelected);
 		// Setup the map database
 		m_mapDatabase.AddSearchPath(g_gameConfig.GetString(GameConfigKeys::SongFolder));
+		m_mapDatabase.SetJobSheduler(g_jobSheduler);
+		m_mapDatabase.SetChartCacheFolder(BeatmapCache::GetDefaultFolder());
 
 		m_mapDatabase.OnMapsAdded.Add(m_selectionWheel.GetData(), &SelectionWheel::OnMapsAdded);
 		m_mapDatabase.OnMapsUpdated.Add(m_selectionWheel.GetData(), &SelectionWheel::OnMapsUpdated);
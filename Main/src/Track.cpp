@@ -7,7 +7,6 @@
 #include <Beatmap/BeatmapPlayback.hpp>
 #include <Beatmap/BeatmapObjects.hpp>
 #include "AsyncAssetLoader.hpp"
-#include <unordered_set>
 
 const float Track::trackWidth = 1.0f;
 const float Track::buttonWidth = 1.0f / 6;
@@ -102,13 +101,32 @@ bool Track::AsyncLoad()
 
 	return loader->Load();
 }
-bool Track::AsyncFinalize()
+bool Track::AsyncFinalizeStep(float maxDuration, bool& finished)
 {
-	// Finalizer loading textures/material/etc.
-	bool success = loader->Finalize();
+	// Upload the textures/materials over multiple steps, everything else is done at once when they are finished
+	finished = false;
+	bool loaderFinished = false;
+	bool success = loader->FinalizeStep(maxDuration, loaderFinished);
+	if(!loaderFinished)
+		return true;
 	delete loader;
 	loader = nullptr;
 
+	finished = true;
+	return AsyncFinalize() && success;
+}
+bool Track::AsyncFinalize()
+{
+	// Finalizer loading textures/material/etc.
+	// (already done when finalized through AsyncFinalizeStep)
+	bool success = true;
+	if(loader)
+	{
+		success = loader->Finalize();
+		delete loader;
+		loader = nullptr;
+	}
+
 	// Load track cover material & texture here for skin back-compat
 	trackCoverMaterial = g_application->LoadMaterial("trackCover");
 	trackCoverTexture = g_application->LoadTexture("trackCover.png");
@@ -144,6 +162,22 @@ bool Track::AsyncFinalize()
 
 	holdButtonMaterial->opaque = false;
 
+#ifndef EMBEDDED
+	// Instanced button shaders are optional, skins without them draw every object separately
+	String shaderPath = Path::Absolute("skins/" + g_application->GetCurrentSkin() + "/shaders/");
+	if(Path::FileExists(shaderPath + "buttonInstanced.vs") && Path::FileExists(shaderPath + "holdbuttonInstanced.vs"))
+	{
+		buttonInstancedMaterial = g_application->LoadMaterial("buttonInstanced");
+		holdButtonInstancedMaterial = g_application->LoadMaterial("holdbuttonInstanced");
+	}
+	m_useInstancing = buttonInstancedMaterial.IsValid() && holdButtonInstancedMaterial.IsValid();
+	if(m_useInstancing)
+	{
+		buttonInstancedMaterial->opaque = false;
+		holdButtonInstancedMaterial->opaque = false;
+	}
+#endif
+
 	for (uint32 i = 0; i < 2; i++)
 	{
 		laserTextures[i]->SetMipmaps(true);
@@ -353,7 +387,7 @@ void Track::DrawLaserBase(RenderQueue& rq, class BeatmapPlayback& playback, cons
 			float position = playback.TimeToViewDistance(obj->time);
 			float posmult = trackLength / (m_viewRange * laserSpeedOffset);
 
-			Mesh laserMesh = m_laserTrackBuilder[laser->index]->GenerateTrackMesh(playback, laser);
+			MeshRange laserMesh = m_laserTrackBuilder[laser->index]->GenerateTrackMesh(playback, laser);
 
 			MaterialParameterSet laserParams;
 			laserParams.SetParameter("mainTex", laserTextures[laser->index]);
@@ -362,7 +396,7 @@ void Track::DrawLaserBase(RenderQueue& rq, class BeatmapPlayback& playback, cons
 			Transform laserTransform = trackOrigin;
 			laserTransform *= Transform::Translation(Vector3{ 0.0f, posmult * position, 0.0f });
 
-			if (laserMesh)
+			if (laserMesh.IsValid())
 			{
 				rq.Draw(laserTransform, laserMesh, blackLaserMaterial, laserParams);
 			}
@@ -392,11 +426,42 @@ void Track::DrawBase(class RenderQueue& rq)
 
 	// Draw the main beat ticks on the track
 	params.SetParameter("mainTex", trackTickTexture);
+	params.SetParameter("trackScale", 1.0f / trackLength);
+	params.SetParameter("hiddenCutoff", hiddenCutoff);
+	params.SetParameter("hiddenFadeWindow", hiddenFadewindow);
+	params.SetParameter("suddenCutoff", suddenCutoff);
+	params.SetParameter("suddenFadeWindow", suddenFadewindow);
+	if (m_useInstancing)
+	{
+		Vector<ButtonInstance> ticks;
+		ticks.reserve(m_barTicks.size());
+		for (float f : m_barTicks)
+		{
+			float y = trackLength * (f / m_viewRange) - trackTickLength * 0.5f;
+			ButtonInstance& tick = ticks.Add();
+			tick.offsetScale = Vector4(0.0f, y, 1.0f, 1.0f);
+			tick.params = Vector4(y / trackLength, 1.0f / trackLength, 0.0f, 0.0f);
+		}
+
+		Transform tickTransform = trackOrigin * Transform::Translation({ 0.0f, 0.0f, 0.01f });
+		if (centerSplit != 0.0f)
+		{
+			rq.DrawInstanced(tickTransform * Transform::Translation({ centerSplit * 0.5f * buttonWidth, 0.0f, 0.0f }), splitTrackTickMesh[0], buttonInstancedMaterial, ticks, params);
+			rq.DrawInstanced(tickTransform * Transform::Translation({ -centerSplit * 0.5f * buttonWidth, 0.0f, 0.0f }), splitTrackTickMesh[1], buttonInstancedMaterial, ticks, params);
+		}
+		else
+		{
+			rq.DrawInstanced(tickTransform, trackTickMesh, buttonInstancedMaterial, ticks, params);
+		}
+		return;
+	}
+
 	params.SetParameter("hasSample", false);
 	for (float f : m_barTicks)
 	{
 		float fLocal = f / m_viewRange;
 		Vector3 tickPosition = Vector3(0.0f, trackLength * fLocal - trackTickLength * 0.5f, 0.01f);
+		params.SetParameter("trackPos", tickPosition.y / trackLength);
 		Transform tickTransform = trackOrigin;
 		tickTransform *= Transform::Translation(tickPosition);
 		if (centerSplit != 0.0f)
@@ -411,7 +476,7 @@ void Track::DrawBase(class RenderQueue& rq)
 	}
 	
 }
-void Track::DrawObjectState(RenderQueue& rq, class BeatmapPlayback& playback, ObjectState* obj, bool active, const std::unordered_set<MapTime> chipFXTimes[2])
+void Track::DrawObjectState(RenderQueue& rq, class BeatmapPlayback& playback, ObjectState* obj, bool active)
 {
 	// Calculate height based on time on current track
 	float viewRange = GetViewRange();
@@ -425,6 +490,7 @@ void Track::DrawObjectState(RenderQueue& rq, class BeatmapPlayback& playback, Ob
 		MaterialParameterSet params;
 		Material mat = buttonMaterial;
 		Mesh mesh;
+		Texture texture;
 		float xscale = 1.0f;
 		float width;
 		float xposition;
@@ -435,7 +501,6 @@ void Track::DrawObjectState(RenderQueue& rq, class BeatmapPlayback& playback, Ob
 		{
 			width = buttonWidth;
 			xposition = buttonTrackWidth * -0.5f + width * mobj->button.index;
-			int fxIdx = 0;
 			if (mobj->button.index < 2)
 			{
 				xposition -= 0.5 * centerSplit * buttonWidth;
@@ -443,16 +508,14 @@ void Track::DrawObjectState(RenderQueue& rq, class BeatmapPlayback& playback, Ob
 			else 
 			{
 				xposition += 0.5 * centerSplit * buttonWidth;
-				fxIdx = 1;
 			}
-			if (!isHold && chipFXTimes[fxIdx].count(mobj->time))
+			if (!isHold && mobj->button.overlapsFXChip)
 			{
 				xscale = m_btOverFxScale;
 				xposition += width * ((1.0 - xscale) / 2.0);
 			}
 			length = buttonLength;
-			params.SetParameter("hasSample", mobj->button.hasSample);
-			params.SetParameter("mainTex", isHold ? buttonHoldTexture : buttonTexture);
+			texture = isHold ? buttonHoldTexture : buttonTexture;
 			mesh = buttonMesh;
 		}
 		else // FX Button
@@ -468,40 +531,62 @@ void Track::DrawObjectState(RenderQueue& rq, class BeatmapPlayback& playback, Ob
 				xposition += 0.5 * centerSplit * buttonWidth;
 			}
 			length = fxbuttonLength;
-			params.SetParameter("hasSample", mobj->button.hasSample);
-			params.SetParameter("mainTex", isHold ? fxbuttonHoldTexture : fxbuttonTexture);
+			texture = isHold ? fxbuttonHoldTexture : fxbuttonTexture;
 			mesh = fxbuttonMesh;
 		}
 
-		params.SetParameter("trackPos", position);
-
+		int hitState = 0;
 		if(isHold)
 		{
 			if(!active && mobj->hold.GetRoot()->time > playback.GetLastTime())
-				params.SetParameter("hitState", 1);
+				hitState = 1;
 			else
-				params.SetParameter("hitState", currentObjectGlowState);
-
-			params.SetParameter("objectGlow", currentObjectGlow);
+				hitState = currentObjectGlowState;
 			mat = holdButtonMaterial;
 		}
 
-		Vector3 buttonPos = Vector3(xposition, trackLength * position, 0.0f);
-
-		Transform buttonTransform = trackOrigin;
-		buttonTransform *= Transform::Translation(buttonPos);
 		float scale = 1.0f;
+		float trackScale;
 		if(isHold) // Hold Note?
 		{
-			float trackScale = (playback.DurationToViewDistanceAtTime(mobj->time, mobj->hold.duration) / viewRange) / length;
+			trackScale = (playback.DurationToViewDistanceAtTime(mobj->time, mobj->hold.duration) / viewRange) / length;
 			scale = trackScale * trackLength;
-
-			params.SetParameter("trackScale", trackScale);
 		}
 		else {
 			//Use actual distance from camera instead of position on the track?
 			scale = 1.0f + (Math::Max(1.0f, distantButtonScale) - 1.0f) * position;
-			params.SetParameter("trackScale", 1.0f / trackLength);
+			trackScale = 1.0f / trackLength;
+		}
+
+		if(m_useInstancing)
+		{
+			mat = isHold ? holdButtonInstancedMaterial : buttonInstancedMaterial;
+			// Objects are drawn in order, so a batch can only continue while the objects look the same
+			if(mesh != m_buttonInstanceMesh || mat != m_buttonInstanceMaterial || texture != m_buttonInstanceTexture)
+			{
+				FlushObjects(rq);
+				m_buttonInstanceMesh = mesh;
+				m_buttonInstanceMaterial = mat;
+				m_buttonInstanceTexture = texture;
+			}
+
+			ButtonInstance& instance = m_buttonInstances.Add();
+			instance.offsetScale = Vector4(xposition, trackLength * position, xscale, scale);
+			if(isHold)
+				instance.params = Vector4(position, trackScale, currentObjectGlow, (float)hitState);
+			else
+				instance.params = Vector4(position, trackScale, mobj->button.hasSample ? 1.0f : 0.0f, 0.0f);
+			return;
+		}
+
+		params.SetParameter("hasSample", mobj->button.hasSample);
+		params.SetParameter("mainTex", texture);
+		params.SetParameter("trackPos", position);
+		params.SetParameter("trackScale", trackScale);
+		if(isHold)
+		{
+			params.SetParameter("hitState", hitState);
+			params.SetParameter("objectGlow", currentObjectGlow);
 		}
 
 		params.SetParameter("hiddenCutoff", hiddenCutoff); // Hidden cutoff (% of track)
@@ -509,20 +594,24 @@ void Track::DrawObjectState(RenderQueue& rq, class BeatmapPlayback& playback, Ob
 		params.SetParameter("suddenCutoff", suddenCutoff); // Sudden cutoff (% of track)
 		params.SetParameter("suddenFadeWindow", suddenFadewindow); // Sudden cutoff (% of track)
 
+		Vector3 buttonPos = Vector3(xposition, trackLength * position, 0.0f);
 
+		Transform buttonTransform = trackOrigin;
+		buttonTransform *= Transform::Translation(buttonPos);
 		buttonTransform *= Transform::Scale({ xscale, scale, 1.0f });
 		rq.Draw(buttonTransform, mesh, mat, params);
 	}
 	else if(obj->type == ObjectType::Laser) // Draw laser
 	{
-		
+		// Keep lasers above the buttons drawn before them
+		FlushObjects(rq);
 
 		position = playback.TimeToViewDistance(obj->time);
 		float posmult = trackLength / (m_viewRange * laserSpeedOffset);
 		LaserObjectState* laser = (LaserObjectState*)obj;
 
 		// Draw segment function
-		auto DrawSegment = [&](Mesh mesh, Texture texture, int part)
+		auto DrawSegment = [&](const MeshRange& mesh, Texture texture, int part)
 		{
 			MaterialParameterSet laserParams;
 			laserParams.SetParameter("trackPos", posmult * position / trackLength);
@@ -554,7 +643,7 @@ void Track::DrawObjectState(RenderQueue& rq, class BeatmapPlayback& playback, Ob
 			// Set laser color
 			laserParams.SetParameter("color", laserColors[laser->index]);
 
-			if(mesh)
+			if(mesh.IsValid())
 			{
 				rq.Draw(laserTransform, mesh, laserMaterial, laserParams);
 			}
@@ -563,22 +652,36 @@ void Track::DrawObjectState(RenderQueue& rq, class BeatmapPlayback& playback, Ob
 		// Draw entry?
 		if(!laser->prev)
 		{
-			Mesh laserTail = m_laserTrackBuilder[laser->index]->GenerateTrackEntry(playback, laser);
+			MeshRange laserTail = m_laserTrackBuilder[laser->index]->GenerateTrackEntry(playback, laser);
 			DrawSegment(laserTail, laserTailTextures[laser->index], 1);
 		}
 
 		// Body
-		Mesh laserMesh = m_laserTrackBuilder[laser->index]->GenerateTrackMesh(playback, laser);
+		MeshRange laserMesh = m_laserTrackBuilder[laser->index]->GenerateTrackMesh(playback, laser);
 		DrawSegment(laserMesh, laserTextures[laser->index], 0);
 
 		// Draw exit?
 		if(!laser->next && (laser->flags & LaserObjectState::flag_Instant) != 0) // Only draw exit on slams
 		{
-			Mesh laserTail = m_laserTrackBuilder[laser->index]->GenerateTrackExit(playback, laser);
+			MeshRange laserTail = m_laserTrackBuilder[laser->index]->GenerateTrackExit(playback, laser);
 			DrawSegment(laserTail, laserTailTextures[2 + laser->index], 2);
 		}
 	}
 }
+void Track::FlushObjects(RenderQueue& rq)
+{
+	if(m_buttonInstances.empty())
+		return;
+
+	MaterialParameterSet params;
+	params.SetParameter("mainTex", m_buttonInstanceTexture);
+	params.SetParameter("hiddenCutoff", hiddenCutoff); // Hidden cutoff (% of track)
+	params.SetParameter("hiddenFadeWindow", hiddenFadewindow); // Hidden cutoff (% of track)
+	params.SetParameter("suddenCutoff", suddenCutoff); // Sudden cutoff (% of track)
+	params.SetParameter("suddenFadeWindow", suddenFadewindow); // Sudden cutoff (% of track)
+	rq.DrawInstanced(trackOrigin, m_buttonInstanceMesh, m_buttonInstanceMaterial, m_buttonInstances, params);
+	m_buttonInstances.clear();
+}
 void Track::DrawOverlays(class RenderQueue& rq)
 {
 	// Draw button hit effect sprites
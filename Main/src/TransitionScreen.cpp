@@ -33,6 +33,10 @@ class TransitionScreen_Impl : public TransitionScreen
 	bool m_stopped = false;
 	bool m_canCancel = true;
 	bool m_initialized = false;
+	// Set while the loaded tickable is being finalized over multiple frames
+	bool m_finalizing = false;
+	// Time spent finalizing per frame, in seconds
+	const float m_finalizeTimeSlice = 0.008f;
 
 	//0 = normal, 1 = song
 	bool m_legacy[2] = { false, false };
@@ -54,6 +58,7 @@ class TransitionScreen_Impl : public TransitionScreen
 		m_bgMesh = MeshGenerators::Quad(g_gl, Vector2(0, g_resolution.y), Vector2(g_resolution.x, -g_resolution.y));
 		m_tickableToLoad = next;
 		m_stopped = false;
+		m_finalizing = false;
 		m_loadComplete = false;
 		m_transitionTimer = 0.0f;
 		m_lastComplete = false;
@@ -87,6 +92,9 @@ public:
 	virtual void Tick(float deltaTime)
 	{
 		m_transitionTimer += deltaTime;
+
+		if(m_finalizing)
+			m_FinalizeStep();
 		
 		if(m_transition == Wait && m_lastComplete)
 		{
@@ -326,30 +334,45 @@ public:
 
 	void OnFinished(Job job)
 	{
-		// Finalize?
-		IAsyncLoadable* loadable = dynamic_cast<IAsyncLoadable*>(m_tickableToLoad);
 		if(job->IsSuccessfull())
 		{
-			if(loadable && !loadable->AsyncFinalize())
-			{
-				Log("[Transition] Failed to finalize loading of tickable", Logger::Error);
-				delete m_tickableToLoad;
-				m_tickableToLoad = nullptr;
-			}
-			if (m_tickableToLoad && !m_tickableToLoad->Init()) //if it isn't null and init fails
-			{
-				Log("[Transition] Failed to initialize tickable", Logger::Error);
-				delete m_tickableToLoad;
-				m_tickableToLoad = nullptr;
-			}
+			// Finalize over multiple frames so the transition keeps animating while resources are uploaded
+			m_finalizing = true;
+			m_FinalizeStep();
 		}
 		else
 		{
 			Log("[Transition] Failed to load tickable", Logger::Error);
 			delete m_tickableToLoad;
 			m_tickableToLoad = nullptr;
+			m_OnLoadingComplete();
+		}
+	}
+	void m_FinalizeStep()
+	{
+		IAsyncLoadable* loadable = dynamic_cast<IAsyncLoadable*>(m_tickableToLoad);
+		bool finished = true;
+		if(loadable && !loadable->AsyncFinalizeStep(m_finalizeTimeSlice, finished))
+		{
+			Log("[Transition] Failed to finalize loading of tickable", Logger::Error);
+			delete m_tickableToLoad;
+			m_tickableToLoad = nullptr;
+			finished = true;
 		}
+		if(!finished)
+			return;
 
+		m_finalizing = false;
+		if (m_tickableToLoad && !m_tickableToLoad->Init()) //if it isn't null and init fails
+		{
+			Log("[Transition] Failed to initialize tickable", Logger::Error);
+			delete m_tickableToLoad;
+			m_tickableToLoad = nullptr;
+		}
+		m_OnLoadingComplete();
+	}
+	void m_OnLoadingComplete()
+	{
 		OnLoadingComplete.Call(m_tickableToLoad);
 
 		for (void* v : m_handlesToRemove)
@@ -394,6 +417,7 @@ public:
 		if (key == SDLK_ESCAPE && !m_stopped && m_canCancel)
 		{
 			m_stopped = true;
+			m_finalizing = false;
 			if(m_loadingJob->IsQueued())
 				m_loadingJob->Terminate();
 			if (m_tickableToLoad)
@@ -30,6 +30,8 @@ public:
 
 	// Get the last write time of a file at a given path
 	static uint64 GetLastWriteTime(const String& path);
+	// Sets the last write time of a file at a given path to the current time
+	static bool UpdateLastWriteTime(const String& path);
 };
 
 /* 
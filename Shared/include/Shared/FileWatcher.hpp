@@ -0,0 +1,87 @@
+#pragma once
+#include "Shared/Files.hpp"
+#include "Shared/Unique.hpp"
+#include "Shared/Map.hpp"
+#include <chrono>
+
+/*
+	A change to a watched file or folder
+*/
+struct FileChange
+{
+	enum Action : uint8
+	{
+		// Written to, created or moved into a watched folder
+		// for folders: files in it that are not tracked because of an extension filter changed
+		Modified = 0,
+		Removed,
+		// Changes were lost, everything in the watched folders should be considered changed
+		Overflow,
+	};
+	Action action;
+	FileType type;
+	String fullPath;
+};
+
+/*
+	Finds changes by comparing snapshots of the watched folders
+	this is a full walk of the folder trees, so it runs less often the longer nothing changes
+*/
+class PollingFileWatcher : public Unique
+{
+public:
+	// Only files with this extension are tracked, other files are summarized per folder and only in folders that contain a tracked file
+	// a change to them is reported as a modification of the folder, has to be set before watching
+	void SetExtensionFilter(const String& extension);
+	// Starts watching a folder, the folder is scanned right away unless scan is false
+	// in that case AddToSnapshot has to be called with a scan of the folder made after this call
+	bool Watch(const String& folder, bool scan = true);
+	// Adds files scanned by the caller to the state the next poll is compared against
+	void AddToSnapshot(const Vector<FileInfo>& files);
+	Vector<FileChange> Poll(uint32 timeout);
+
+private:
+	struct Snapshot
+	{
+		// File path to last write time
+		Map<String, uint64> files;
+		// Folder path to a hash of the untracked files in it
+		Map<String, uint64> folders;
+	};
+	void m_Scan(const String& folder, Snapshot& snapshot) const;
+	bool m_IsTracked(const String& path) const;
+
+	Vector<String> m_folders;
+	String m_extension;
+	Snapshot m_snapshot;
+	std::chrono::steady_clock::time_point m_nextScan;
+	std::chrono::milliseconds m_interval;
+};
+
+/*
+	Watches folders and all their subfolders for file changes
+	uses inotify on Linux, other platforms (or running out of inotify watches) fall back to PollingFileWatcher
+*/
+class FileWatcher : public Unique
+{
+public:
+	FileWatcher();
+	~FileWatcher();
+
+	// Only used by the polling fallback, see PollingFileWatcher::SetExtensionFilter
+	void SetExtensionFilter(const String& extension);
+	// Starts watching a folder, returns false if the folder can not be watched
+	// if scan is false the polling fallback does not scan the folder, AddToSnapshot has to be called with a scan of it made after this call
+	bool Watch(const String& folder, bool scan = true);
+	// Passes files scanned by the caller to the polling fallback, see PollingFileWatcher::AddToSnapshot
+	void AddToSnapshot(const Vector<FileInfo>& files);
+	// Waits at most timeout milliseconds for changes and returns them in the order they happened
+	// files in folders that get created or moved into a watched folder are reported as modified
+	Vector<FileChange> Poll(uint32 timeout);
+
+	// True if changes are reported by the OS instead of by rescanning
+	bool IsNative() const;
+
+private:
+	class FileWatcher_Impl* m_impl;
+};
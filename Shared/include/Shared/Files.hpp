@@ -34,4 +34,8 @@ public:
 	// uses the given extension filter if specified
 	// Additional interruptible flag can contain a boolean which can interrupt the search when set to true
 	static Vector<FileInfo> ScanFilesRecursive(const String& folder, String extFilter = String(), bool* interrupt = nullptr);
+
+	// Deletes the least recently written files in a folder until the remaining ones take up at most maxSize bytes
+	// uses the given extension filter if specified, returns the number of deleted files
+	static uint32 DeleteOldest(const String& folder, uint64 maxSize, String extFilter = String());
 };
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+#include <atomic>
+
+/*
+	Bounded single-producer single-consumer queue
+	Push and Pop never lock or allocate, which makes this safe to use from real-time threads (audio, input polling)
+	When multiple threads need to push, they should serialize their calls to Push with a mutex of their own,
+	the consumer side stays lock-free regardless.
+	Capacity must be a power of 2
+*/
+template<typename T, size_t Capacity>
+class LockFreeQueue
+{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "LockFreeQueue capacity must be a power of 2");
+public:
+	// Returns false if the queue is full
+	bool Push(const T& item)
+	{
+		const size_t tail = m_tail.load(std::memory_order_relaxed);
+		if(tail - m_head.load(std::memory_order_acquire) >= Capacity)
+			return false;
+		m_items[tail & (Capacity - 1)] = item;
+		m_tail.store(tail + 1);
+		return true;
+	}
+	// Returns false if the queue is empty
+	bool Pop(T& item)
+	{
+		const size_t head = m_head.load(std::memory_order_relaxed);
+		if(head == m_tail.load())
+			return false;
+		item = m_items[head & (Capacity - 1)];
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool IsEmpty() const
+	{
+		return m_head.load() == m_tail.load();
+	}
+	size_t GetSize() const
+	{
+		return m_tail.load() - m_head.load();
+	}
+	static constexpr size_t GetCapacity()
+	{
+		return Capacity;
+	}
+
+private:
+	T m_items[Capacity];
+	// Producer and consumer indices are kept on separate cache lines
+	alignas(64) std::atomic<size_t> m_head = { 0 };
+	alignas(64) std::atomic<size_t> m_tail = { 0 };
+};
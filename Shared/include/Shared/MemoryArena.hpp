@@ -0,0 +1,57 @@
+#pragma once
+#include "Shared/Vector.hpp"
+#include "Shared/Unique.hpp"
+#include <type_traits>
+#include <new>
+
+/*
+	Bump allocator that hands out memory from a list of large blocks
+	Objects allocated one after another end up next to each other in memory,
+	everything is released at once when the arena is reset or destroyed.
+	Destructors are never called, so only trivially destructible types can be allocated
+*/
+class MemoryArena : public Unique
+{
+public:
+	MemoryArena(size_t blockSize = 64 * 1024);
+	~MemoryArena();
+	MemoryArena(MemoryArena&& other);
+	MemoryArena& operator=(MemoryArena&& other);
+
+	void* Allocate(size_t size, size_t alignment);
+
+	// Allocates and constructs a new object
+	template<typename T, typename... Args>
+	T* New(Args&&... args)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "Arena objects are never destructed");
+		return new(Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+	}
+
+	// Makes sure the next size bytes can be allocated from a single block
+	// use this to keep a known number of objects contiguous
+	void Reserve(size_t size);
+
+	// Releases all memory, any pointers returned by this arena are invalid after this
+	void Reset();
+
+	// Total size of the blocks allocated by this arena
+	size_t GetCapacity() const;
+	// Number of bytes handed out, including alignment padding
+	size_t GetUsed() const;
+	size_t GetNumBlocks() const;
+
+private:
+	struct Block
+	{
+		uint8* data;
+		size_t size;
+		size_t used;
+	};
+	void m_AddBlock(size_t minSize);
+
+	Vector<Block> m_blocks;
+	size_t m_blockSize;
+	size_t m_capacity = 0;
+	size_t m_used = 0;
+};
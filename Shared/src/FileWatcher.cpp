@@ -0,0 +1,158 @@
+#include "stdafx.h"
+#include "FileWatcher.hpp"
+#include "Path.hpp"
+#include "Math.hpp"
+#include "Set.hpp"
+#include <thread>
+#include <functional>
+
+// Rescan interval while changes are being found, doubles for every scan without changes up to the maximum
+static const std::chrono::milliseconds minScanInterval(2000);
+static const std::chrono::milliseconds maxScanInterval(30000);
+
+void PollingFileWatcher::SetExtensionFilter(const String& extension)
+{
+	m_extension = extension;
+}
+bool PollingFileWatcher::Watch(const String& folder, bool scan /*= true*/)
+{
+	if(!Path::IsDirectory(folder))
+		return false;
+	String normalized = Path::Normalize(folder);
+	if(!m_folders.Contains(normalized))
+	{
+		m_folders.Add(normalized);
+		if(scan)
+			m_Scan(normalized, m_snapshot);
+	}
+	m_interval = minScanInterval;
+	m_nextScan = std::chrono::steady_clock::now() + m_interval;
+	return true;
+}
+void PollingFileWatcher::AddToSnapshot(const Vector<FileInfo>& files)
+{
+	for(const FileInfo& fi : files)
+	{
+		if(fi.type == FileType::Regular && m_IsTracked(fi.fullPath))
+			m_snapshot.files[fi.fullPath] = fi.lastWriteTime;
+	}
+}
+Vector<FileChange> PollingFileWatcher::Poll(uint32 timeout)
+{
+	Vector<FileChange> changes;
+	auto now = std::chrono::steady_clock::now();
+	if(now < m_nextScan)
+	{
+		auto wait = std::chrono::milliseconds(timeout);
+		if(now + wait < m_nextScan)
+		{
+			std::this_thread::sleep_for(wait);
+			return changes;
+		}
+		std::this_thread::sleep_until(m_nextScan);
+	}
+
+	auto scanStart = std::chrono::steady_clock::now();
+	Snapshot snapshot;
+	for(const String& folder : m_folders)
+		m_Scan(folder, snapshot);
+	for(auto& f : snapshot.files)
+	{
+		auto it = m_snapshot.files.find(f.first);
+		if(it == m_snapshot.files.end() || it->second != f.second)
+			changes.Add({ FileChange::Modified, FileType::Regular, f.first });
+	}
+	for(auto& f : m_snapshot.files)
+	{
+		if(!snapshot.files.Contains(f.first))
+			changes.Add({ FileChange::Removed, FileType::Regular, f.first });
+	}
+	// Folders that just got a tracked file don't need to be reported, the file itself is
+	for(auto& f : snapshot.folders)
+	{
+		auto it = m_snapshot.folders.find(f.first);
+		if(it != m_snapshot.folders.end() && it->second != f.second)
+			changes.Add({ FileChange::Modified, FileType::Folder, f.first });
+	}
+	m_snapshot = std::move(snapshot);
+
+	// Changes tend to come in groups (copying a chart folder), so check again soon after finding some
+	auto scanEnd = std::chrono::steady_clock::now();
+	if(changes.empty())
+		m_interval = Math::Min(m_interval * 2, maxScanInterval);
+	else
+		m_interval = minScanInterval;
+	// Never spend more than a tenth of the time scanning on slow drives
+	auto scanDuration = std::chrono::duration_cast<std::chrono::milliseconds>(scanEnd - scanStart);
+	m_nextScan = scanEnd + Math::Max(m_interval, scanDuration * 10);
+	return changes;
+}
+void PollingFileWatcher::m_Scan(const String& folder, Snapshot& snapshot) const
+{
+	Map<String, uint64> untracked;
+	Set<String> trackedFolders;
+	for(FileInfo& fi : Files::ScanFilesRecursive(folder))
+	{
+		if(fi.type != FileType::Regular)
+			continue;
+		String parent = Path::RemoveLast(fi.fullPath);
+		if(m_IsTracked(fi.fullPath))
+		{
+			snapshot.files[fi.fullPath] = fi.lastWriteTime;
+			trackedFolders.Add(parent);
+		}
+		else
+		{
+			// Order independent, so a file being added, removed, renamed or written changes the hash
+			uint64 hash = std::hash<std::string>()(fi.fullPath) ^ (fi.lastWriteTime * 0x9E3779B97F4A7C15ull);
+			untracked[parent] += hash;
+		}
+	}
+	for(auto& f : untracked)
+	{
+		if(trackedFolders.Contains(f.first))
+			snapshot.folders[f.first] = f.second;
+	}
+}
+bool PollingFileWatcher::m_IsTracked(const String& path) const
+{
+	return m_extension.empty() || Path::GetExtension(path) == m_extension;
+}
+
+// Linux uses inotify, see Linux/FileWatcher.cpp
+#ifndef __linux__
+class FileWatcher_Impl
+{
+public:
+	PollingFileWatcher m_poller;
+};
+
+FileWatcher::FileWatcher()
+{
+	m_impl = new FileWatcher_Impl();
+}
+FileWatcher::~FileWatcher()
+{
+	delete m_impl;
+}
+void FileWatcher::SetExtensionFilter(const String& extension)
+{
+	m_impl->m_poller.SetExtensionFilter(extension);
+}
+bool FileWatcher::Watch(const String& folder, bool scan /*= true*/)
+{
+	return m_impl->m_poller.Watch(folder, scan);
+}
+void FileWatcher::AddToSnapshot(const Vector<FileInfo>& files)
+{
+	m_impl->m_poller.AddToSnapshot(files);
+}
+Vector<FileChange> FileWatcher::Poll(uint32 timeout)
+{
+	return m_impl->m_poller.Poll(timeout);
+}
+bool FileWatcher::IsNative() const
+{
+	return false;
+}
+#endif
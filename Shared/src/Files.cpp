@@ -0,0 +1,49 @@
+#include "stdafx.h"
+#include "Files.hpp"
+#include "File.hpp"
+#include "Path.hpp"
+#include <algorithm>
+
+uint32 Files::DeleteOldest(const String& folder, uint64 maxSize, String extFilter)
+{
+	if(!Path::IsDirectory(folder))
+		return 0;
+
+	struct SizedFile
+	{
+		String path;
+		uint64 lastWriteTime;
+		uint64 size;
+	};
+	Vector<SizedFile> files;
+	uint64 totalSize = 0;
+	for(FileInfo& fi : ScanFiles(folder, extFilter))
+	{
+		if(fi.type != FileType::Regular)
+			continue;
+		File file;
+		if(!file.OpenRead(fi.fullPath))
+			continue;
+		files.Add({ fi.fullPath, fi.lastWriteTime, (uint64)file.GetSize() });
+		totalSize += files.back().size;
+	}
+	if(totalSize <= maxSize)
+		return 0;
+
+	std::sort(files.begin(), files.end(), [](const SizedFile& a, const SizedFile& b)
+	{
+		return a.lastWriteTime < b.lastWriteTime;
+	});
+	uint32 numDeleted = 0;
+	for(const SizedFile& file : files)
+	{
+		if(totalSize <= maxSize)
+			break;
+		if(Path::Delete(file.path))
+		{
+			totalSize -= file.size;
+			numDeleted++;
+		}
+	}
+	return numDeleted;
+}
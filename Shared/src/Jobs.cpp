@@ -136,6 +136,7 @@ private:
 	{
 		while(!myThread->terminate)
 		{
+			bool processedJob = false;
 			if(!m_jobQueue.empty())
 			{
 				m_lock.lock();
@@ -161,6 +162,7 @@ private:
 
 						// Clear the active job
 						myThread->activeJob.Release();
+						processedJob = true;
 					}
 					else
 					{
@@ -174,6 +176,10 @@ private:
 				}
 			}
 
+			// Keep going without sleeping while there is work left, short per-frame jobs would otherwise wait a full idle cycle
+			if(processedJob)
+				continue;
+
 			// Various idle levels
 			if(myThread->idleDuration.Minutes() > 1)
 				std::this_thread::sleep_for(std::chrono::milliseconds(1000));
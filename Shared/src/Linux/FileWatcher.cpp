@@ -0,0 +1,236 @@
+#include "stdafx.h"
+#include "FileWatcher.hpp"
+#include "Path.hpp"
+#include "Log.hpp"
+#include "Map.hpp"
+
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <errno.h>
+
+class FileWatcher_Impl
+{
+public:
+	int m_fd = -1;
+	// Watch descriptor to folder path
+	Map<int, String> m_watches;
+	// Folders passed to Watch
+	Vector<String> m_folders;
+	// Passed on to the polling fallback
+	String m_extension;
+	// Used instead of inotify once the inotify instance or watch limits are reached
+	PollingFileWatcher* m_poller = nullptr;
+	// Set when adding a watch failed because of the watch limit
+	bool m_outOfWatches = false;
+
+	FileWatcher_Impl()
+	{
+		m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if(m_fd < 0)
+		{
+			int error = errno;
+			Logf("Failed to initialize inotify (errno %d), falling back to rescanning watched folders", Logger::Warning, error);
+			m_poller = new PollingFileWatcher();
+		}
+	}
+	~FileWatcher_Impl()
+	{
+		if(m_fd >= 0)
+			close(m_fd);
+		delete m_poller;
+	}
+
+	// Drops all inotify watches and rescans the watched folders instead
+	void FallBackToPolling(bool scan)
+	{
+		Log("Out of inotify watches, falling back to rescanning watched folders", Logger::Warning);
+		close(m_fd);
+		m_fd = -1;
+		m_watches.clear();
+		m_poller = new PollingFileWatcher();
+		m_poller->SetExtensionFilter(m_extension);
+		for(const String& folder : m_folders)
+			m_poller->Watch(folder, scan);
+	}
+
+	// Adds watches for a folder and all its subfolders
+	// optionally reports all files found as modified, for folders that were just created or moved in
+	bool AddWatchRecursive(const String& folder, Vector<FileChange>* changes)
+	{
+		const uint32 mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE | IN_ONLYDIR;
+		int wd = inotify_add_watch(m_fd, *folder, mask);
+		if(wd < 0)
+		{
+			// Folders can be removed again before their creation is processed
+			if(errno == ENOENT)
+				return false;
+			// Reached max_user_watches, the caller switches to polling
+			if(errno == ENOSPC)
+			{
+				m_outOfWatches = true;
+				return false;
+			}
+			Logf("Failed to watch folder \"%s\" (errno %d)", Logger::Warning, folder, errno);
+			return false;
+		}
+		m_watches[wd] = folder;
+
+		// Not using Files::ScanFiles here since that also stats every file
+		DIR* dir = opendir(*folder);
+		if(dir == nullptr)
+			return true;
+		while(dirent* ent = readdir(dir))
+		{
+			String filename = ent->d_name;
+			if(filename == "." || filename == "..")
+				continue;
+
+			String fullPath = Path::Normalize(folder + Path::sep + filename);
+			if(ent->d_type == DT_DIR || (ent->d_type == DT_UNKNOWN && Path::IsDirectory(fullPath)))
+			{
+				AddWatchRecursive(fullPath, changes);
+				if(m_outOfWatches)
+					break;
+			}
+			else if(changes)
+			{
+				changes->Add({ FileChange::Modified, FileType::Regular, fullPath });
+			}
+		}
+		closedir(dir);
+		return !m_outOfWatches;
+	}
+
+	void RemoveWatchRecursive(const String& folder)
+	{
+		const String prefix = folder + Path::sep;
+		for(auto it = m_watches.begin(); it != m_watches.end();)
+		{
+			if(it->second == folder || it->second.compare(0, prefix.size(), prefix) == 0)
+			{
+				inotify_rm_watch(m_fd, it->first);
+				it = m_watches.erase(it);
+			}
+			else
+				it++;
+		}
+	}
+
+	Vector<FileChange> Poll(uint32 timeout)
+	{
+		if(m_poller)
+			return m_poller->Poll(timeout);
+
+		Vector<FileChange> changes;
+		if(m_fd < 0)
+			return changes;
+
+		pollfd pfd = { m_fd, POLLIN, 0 };
+		if(poll(&pfd, 1, (int)timeout) <= 0)
+			return changes;
+
+		alignas(inotify_event) char buffer[0x4000];
+		while(true)
+		{
+			ssize_t len = read(m_fd, buffer, sizeof(buffer));
+			if(len <= 0)
+				break; // No more events
+
+			for(char* ptr = buffer; ptr < buffer + len; ptr += sizeof(inotify_event) + ((inotify_event*)ptr)->len)
+			{
+				const inotify_event* evt = (const inotify_event*)ptr;
+				if(evt->mask & IN_Q_OVERFLOW)
+				{
+					changes.Add({ FileChange::Overflow, FileType::Folder, String() });
+					continue;
+				}
+				if(evt->mask & IN_IGNORED)
+				{
+					// Watched folder was removed
+					m_watches.erase(evt->wd);
+					continue;
+				}
+
+				auto it = m_watches.find(evt->wd);
+				if(it == m_watches.end() || evt->len == 0)
+					continue;
+				String fullPath = Path::Normalize(it->second + Path::sep + evt->name);
+
+				if(evt->mask & IN_ISDIR)
+				{
+					if(evt->mask & (IN_CREATE | IN_MOVED_TO))
+						AddWatchRecursive(fullPath, &changes);
+					else if(evt->mask & (IN_DELETE | IN_MOVED_FROM))
+					{
+						// Moved folders keep their watches, which would report the old path from now on
+						if(evt->mask & IN_MOVED_FROM)
+							RemoveWatchRecursive(fullPath);
+						changes.Add({ FileChange::Removed, FileType::Folder, fullPath });
+					}
+				}
+				else
+				{
+					// Creation is ignored for files, they are reported once they have been written
+					if(evt->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+						changes.Add({ FileChange::Modified, FileType::Regular, fullPath });
+					else if(evt->mask & (IN_DELETE | IN_MOVED_FROM))
+						changes.Add({ FileChange::Removed, FileType::Regular, fullPath });
+				}
+			}
+		}
+
+		// Folders that were added could not all be watched, changes in them would be missed
+		if(m_outOfWatches)
+		{
+			FallBackToPolling(true);
+			changes.Add({ FileChange::Overflow, FileType::Folder, String() });
+		}
+		return changes;
+	}
+};
+
+FileWatcher::FileWatcher()
+{
+	m_impl = new FileWatcher_Impl();
+}
+FileWatcher::~FileWatcher()
+{
+	delete m_impl;
+}
+void FileWatcher::SetExtensionFilter(const String& extension)
+{
+	m_impl->m_extension = extension;
+	if(m_impl->m_poller)
+		m_impl->m_poller->SetExtensionFilter(extension);
+}
+bool FileWatcher::Watch(const String& folder, bool scan /*= true*/)
+{
+	if(m_impl->m_poller)
+		return m_impl->m_poller->Watch(folder, scan);
+	if(m_impl->m_fd < 0 || !Path::IsDirectory(folder))
+		return false;
+	String normalized = Path::Normalize(folder);
+	m_impl->m_folders.AddUnique(normalized);
+	if(!m_impl->AddWatchRecursive(normalized, nullptr))
+	{
+		if(!m_impl->m_outOfWatches)
+			return false;
+		m_impl->FallBackToPolling(scan);
+	}
+	return true;
+}
+void FileWatcher::AddToSnapshot(const Vector<FileInfo>& files)
+{
+	if(m_impl->m_poller)
+		m_impl->m_poller->AddToSnapshot(files);
+}
+Vector<FileChange> FileWatcher::Poll(uint32 timeout)
+{
+	return m_impl->Poll(timeout);
+}
+bool FileWatcher::IsNative() const
+{
+	return m_impl->m_poller == nullptr;
+}
@@ -0,0 +1,92 @@
+#include "stdafx.h"
+#include "MemoryArena.hpp"
+#include "Math.hpp"
+
+MemoryArena::MemoryArena(size_t blockSize) : m_blockSize(blockSize)
+{
+}
+MemoryArena::~MemoryArena()
+{
+	Reset();
+}
+MemoryArena::MemoryArena(MemoryArena&& other)
+{
+	m_blockSize = other.m_blockSize;
+	*this = std::move(other);
+}
+MemoryArena& MemoryArena::operator=(MemoryArena&& other)
+{
+	Reset();
+	m_blocks = std::move(other.m_blocks);
+	m_blockSize = other.m_blockSize;
+	m_capacity = other.m_capacity;
+	m_used = other.m_used;
+	other.m_blocks.clear();
+	other.m_capacity = 0;
+	other.m_used = 0;
+	return *this;
+}
+
+void* MemoryArena::Allocate(size_t size, size_t alignment)
+{
+	assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+	if(!m_blocks.empty())
+	{
+		Block& block = m_blocks.back();
+		// Block data is aligned for any fundamental type, so aligning the offset is enough
+		size_t offset = (block.used + alignment - 1) & ~(alignment - 1);
+		if(offset + size <= block.size)
+		{
+			m_used += offset + size - block.used;
+			block.used = offset + size;
+			return block.data + offset;
+		}
+	}
+
+	m_AddBlock(size);
+	Block& block = m_blocks.back();
+	block.used = size;
+	m_used += size;
+	return block.data;
+}
+void MemoryArena::Reserve(size_t size)
+{
+	if(!m_blocks.empty())
+	{
+		const Block& block = m_blocks.back();
+		if(block.size - block.used >= size)
+			return;
+	}
+	m_AddBlock(size);
+}
+void MemoryArena::Reset()
+{
+	for(Block& block : m_blocks)
+		delete[] block.data;
+	m_blocks.clear();
+	m_capacity = 0;
+	m_used = 0;
+}
+
+size_t MemoryArena::GetCapacity() const
+{
+	return m_capacity;
+}
+size_t MemoryArena::GetUsed() const
+{
+	return m_used;
+}
+size_t MemoryArena::GetNumBlocks() const
+{
+	return m_blocks.size();
+}
+
+void MemoryArena::m_AddBlock(size_t minSize)
+{
+	Block block;
+	block.size = Math::Max(minSize, m_blockSize);
+	block.data = new uint8[block.size];
+	block.used = 0;
+	m_blocks.Add(block);
+	m_capacity += block.size;
+}
@@ -134,6 +134,12 @@ String Path::GetModuleName()
 bool Path::CreateDirRecursive(String path)
 {
 	String path1;
+	// Keep the root of absolute paths
+	if(!path.empty() && path[0] == Path::sep)
+	{
+		path1 += Path::sep;
+		path = path.substr(1);
+	}
 	while(!path.empty())
 	{
 		String segment = path;
@@ -151,7 +157,7 @@ bool Path::CreateDirRecursive(String path)
 			path.clear();
 		}
 
-		if(!path1.empty())
+		if(!path1.empty() && path1.back() != Path::sep)
 			path1 += Path::sep;
 		path1 += segment;
 
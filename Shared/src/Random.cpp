@@ -2,6 +2,7 @@
 #include "Random.hpp"
 #include <random>
 #include <ctime>
+#include <thread>
 
 namespace Random
 {
@@ -9,7 +10,8 @@ namespace Random
 	using std::uniform_int_distribution;
 	using std::uniform_real_distribution;
 
-	mt19937 gen((uint32)time(0));
+	// One generator per thread so particle simulation jobs can sample random values
+	thread_local mt19937 gen((uint32)time(0) ^ (uint32)std::hash<std::thread::id>()(std::this_thread::get_id()));
 
 	float Float()
 	{
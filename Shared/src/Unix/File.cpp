@@ -18,6 +18,8 @@
 // for fstat
 #include <sys/types.h>
 #include <sys/stat.h>
+// for utimes
+#include <sys/time.h>
 
 class File_Impl
 {
@@ -143,6 +145,11 @@ uint64 File::GetLastWriteTime(const String& path)
 	#endif
 }
 
+bool File::UpdateLastWriteTime(const String& path)
+{
+	return utimes(*path, nullptr) == 0;
+}
+
 bool LoadResourceInternal(const char* name, const char* type, Buffer& out)
 {
 	return false;
@@ -42,7 +42,7 @@ bool Path::Rename(const String& srcFile, const String& dstFile, bool overwrite)
 	{
 		if(!overwrite)
 			return false;
-		if(Delete(*dstFile))
+		if(!Delete(*dstFile))
 		{
 			Log("Failed to rename file, overwrite was true but the destination could not be removed", Logger::Warning);
 			return false;
@@ -155,6 +155,21 @@ uint64 File::GetLastWriteTime(const String& path)
 	return (uint64&)ftWrite;
 }
 
+bool File::UpdateLastWriteTime(const String& path)
+{
+	WString wstringPath = Utility::ConvertToWString(path);
+	HANDLE h = CreateFileW(*wstringPath,
+		FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE, 0, OPEN_EXISTING, 0, 0);
+	if(h == INVALID_HANDLE_VALUE)
+		return false;
+
+	FILETIME ftNow;
+	GetSystemTimeAsFileTime(&ftNow);
+	bool r = SetFileTime(h, nullptr, nullptr, &ftNow) != 0;
+	CloseHandle(h);
+	return r;
+}
+
 bool LoadResourceInternal(const char* name, const char* type, Buffer& out)
 {
 	HMODULE module = GetModuleHandle(nullptr);
@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include <Audio/Audio.hpp>
 #include <Audio/DSP.hpp>
+#include <Audio/AudioKernels.hpp>
 #include <float.h>
 #include "TestMusicPlayer.hpp"
 
@@ -45,6 +46,317 @@ Test("Audio.Playback")
 	delete audio;
 }
 
+// Checks the vectorized mixer kernels against the scalar path and reports their throughput
+Test("Audio.Kernels")
+{
+	const uint32 count = 2 * 384; // One mixer block of stereo samples
+	const uint32 iterations = 20000;
+
+	Vector<float> input(count);
+	for(auto& v : input)
+		v = Random::FloatRange(-1.5f, 1.5f);
+	const float gain = 0.731f;
+
+	// Reference results
+	AudioKernels::SetActivePath(AudioKernels::Path::Scalar);
+	Vector<float> refMix(count, 0.25f);
+	AudioKernels::MixGain(refMix.data(), input.data(), gain, count);
+	Vector<int16> refInt(count);
+	AudioKernels::ConvertToInt16(refInt.data(), input.data(), count);
+	const float refPeak = AudioKernels::PeakAbs(input.data(), count);
+	const float rampStep = -0.0013f;
+	Vector<float> refRamp(count);
+	AudioKernels::GainRampClamp(refRamp.data(), input.data(), gain, rampStep, 0.9f, count / 2);
+
+	for(uint8 p = 0; p <= (uint8)AudioKernels::GetSupportedPath(); p++)
+	{
+		AudioKernels::Path path = (AudioKernels::Path)p;
+		AudioKernels::SetActivePath(path);
+
+		Vector<float> mix(count, 0.25f);
+		AudioKernels::MixGain(mix.data(), input.data(), gain, count);
+		TestEnsure(memcmp(mix.data(), refMix.data(), count * sizeof(float)) == 0);
+		Vector<int16> conv(count);
+		AudioKernels::ConvertToInt16(conv.data(), input.data(), count);
+		TestEnsure(memcmp(conv.data(), refInt.data(), count * sizeof(int16)) == 0);
+		TestEnsure(AudioKernels::PeakAbs(input.data(), count) == refPeak);
+		Vector<float> ramp(count);
+		AudioKernels::GainRampClamp(ramp.data(), input.data(), gain, rampStep, 0.9f, count / 2);
+		TestEnsure(memcmp(ramp.data(), refRamp.data(), count * sizeof(float)) == 0);
+
+		auto Measure = [&](const char* name, auto&& kernel)
+		{
+			Timer t;
+			for(uint32 i = 0; i < iterations; i++)
+				kernel();
+			double seconds = t.SecondsAsDouble();
+			Logf("[%s] %s: %.1f Msamples/s", Logger::Info, AudioKernels::GetPathName(path), name,
+				(double)count * iterations / seconds / 1000000.0);
+		};
+		Measure("MixGain", [&]() { AudioKernels::MixGain(mix.data(), input.data(), gain, count); });
+		Measure("ConvertToInt16", [&]() { AudioKernels::ConvertToInt16(conv.data(), input.data(), count); });
+		Measure("PeakAbs", [&]() { AudioKernels::PeakAbs(input.data(), count); });
+		Measure("GainRampClamp", [&]() { AudioKernels::GainRampClamp(ramp.data(), input.data(), gain, rampStep, 0.9f, count / 2); });
+	}
+	AudioKernels::SetActivePath(AudioKernels::GetSupportedPath());
+}
+
+// The biquad filter as it was before the coefficients were normalized up front, used as reference for BQFDSP
+struct ReferenceBQF
+{
+	float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f;
+	float a0 = 1.0f, a1 = 0.0f, a2 = 0.0f;
+	float zb[2][2] = { { 0.0f } };
+	float za[2][2] = { { 0.0f } };
+
+	void SetLowPass(float q, float freq, float sampleRate)
+	{
+		q = Math::Max(q, 0.01f);
+		double w0 = (2 * Math::pi * freq) / sampleRate;
+		double cw0 = cos(w0);
+		float alpha = (float)(sin(w0) / (2 * q));
+		b0 = (float)((1 - cw0) / 2);
+		b1 = (float)(1 - cw0);
+		b2 = (float)((1 - cw0) / 2);
+		a0 = 1 + alpha;
+		a1 = (float)(-2 * cw0);
+		a2 = 1 - alpha;
+	}
+	void Process(float* out, uint32 numSamples)
+	{
+		for(uint32 c = 0; c < 2; c++)
+		{
+			for(uint32 i = 0; i < numSamples; i++)
+			{
+				float& sample = out[i * 2 + c];
+				float src = sample;
+				float filtered = (b0 / a0) * src + (b1 / a0) * zb[c][0] + (b2 / a0) * zb[c][1] - (a1 / a0) * za[c][0] - (a2 / a0) * za[c][1];
+				zb[c][1] = zb[c][0];
+				zb[c][0] = src;
+				za[c][1] = za[c][0];
+				za[c][0] = filtered;
+				sample = filtered;
+			}
+		}
+	}
+};
+
+// Checks the biquad kernels against the scalar path and the reference filter,
+// then measures them on the filter sweep used by Audio.Music.LPF (new parameters every mixer block)
+Test("Audio.BQF")
+{
+	const uint32 numSamples = 384; // One mixer block
+	const uint32 iterations = 20000;
+	const float sampleRate = 44100.0f;
+
+	Vector<float> input(numSamples * 2);
+	for(auto& v : input)
+		v = Random::FloatRange(-1.0f, 1.0f);
+
+	auto SweepFrequency = [](uint32 block)
+	{
+		float t = (float)(block % 400) / 400.0f;
+		return 200.0f + (10000.0f - 200.0f) * t * t;
+	};
+
+	// With fixed parameters the output should be the same as the reference up to rounding
+	{
+		ReferenceBQF reference;
+		reference.SetLowPass(1.0f, 500.0f, sampleRate);
+		BQFDSP filter;
+		filter.SetLowPass(1.0f, 500.0f, sampleRate);
+		float maxError = 0.0f;
+		for(uint32 block = 0; block < 16; block++)
+		{
+			Vector<float> a = input;
+			Vector<float> b = input;
+			reference.Process(a.data(), numSamples);
+			filter.Process(b.data(), numSamples);
+			for(uint32 i = 0; i < numSamples * 2; i++)
+				maxError = Math::Max(maxError, fabsf(a[i] - b[i]));
+		}
+		Logf("Max difference from reference: %g", Logger::Info, maxError);
+		TestEnsure(maxError < 1e-4f);
+	}
+
+	// Reference output of the scalar path while sweeping
+	AudioKernels::SetActivePath(AudioKernels::Path::Scalar);
+	Vector<float> refSweep;
+	{
+		BQFDSP filter;
+		for(uint32 block = 0; block < 16; block++)
+		{
+			Vector<float> buf = input;
+			filter.SetLowPass(1.0f, SweepFrequency(block), sampleRate);
+			filter.Process(buf.data(), numSamples);
+			refSweep.insert(refSweep.end(), buf.begin(), buf.end());
+		}
+	}
+
+	auto Measure = [&](const char* name, auto&& filter)
+	{
+		Vector<float> buf = input;
+		Timer t;
+		for(uint32 i = 0; i < iterations; i++)
+		{
+			filter.SetLowPass(1.0f, SweepFrequency(i), sampleRate);
+			filter.Process(buf.data(), numSamples);
+		}
+		double seconds = t.SecondsAsDouble();
+		Logf("[%s] Sweeping low pass: %.1f Msamples/s", Logger::Info, name, (double)numSamples * iterations / seconds / 1000000.0);
+	};
+	ReferenceBQF reference;
+	Measure("Reference", reference);
+
+	for(uint8 p = 0; p <= (uint8)AudioKernels::GetSupportedPath(); p++)
+	{
+		AudioKernels::Path path = (AudioKernels::Path)p;
+		AudioKernels::SetActivePath(path);
+
+		BQFDSP filter;
+		for(uint32 block = 0; block < 16; block++)
+		{
+			Vector<float> buf = input;
+			filter.SetLowPass(1.0f, SweepFrequency(block), sampleRate);
+			filter.Process(buf.data(), numSamples);
+			TestEnsure(memcmp(buf.data(), refSweep.data() + block * numSamples * 2, numSamples * 2 * sizeof(float)) == 0);
+		}
+
+		BQFDSP benchmarkFilter;
+		Measure(AudioKernels::GetPathName(path), benchmarkFilter);
+	}
+	AudioKernels::SetActivePath(AudioKernels::GetSupportedPath());
+}
+
+// With the mix at 0 the pitch shifter only delays the input, by the same amount as a DelayDSP of its latency
+Test("Audio.PitchShift.Latency")
+{
+	Audio* audio = new Audio();
+	TestEnsure(audio->Init(false));
+
+	const uint32 numSamples = 384;
+	const uint32 numBlocks = 200;
+	PitchShiftDSP pitchShift;
+	pitchShift.amount = 7.0f;
+	pitchShift.mix = 0.0f;
+	uint32 latency = pitchShift.GetLatency();
+	TestEnsure(latency > 0 && latency < numSamples * numBlocks);
+
+	DelayDSP delay;
+	delay.SetDelay(latency);
+	TestEnsure(delay.GetLatency() == latency);
+
+	Vector<float> input;
+	Vector<float> shifted;
+	Vector<float> delayed;
+	for(uint32 block = 0; block < numBlocks; block++)
+	{
+		Vector<float> buf(numSamples * 2);
+		for(auto& v : buf)
+			v = Random::FloatRange(-1.0f, 1.0f);
+		input.insert(input.end(), buf.begin(), buf.end());
+
+		Vector<float> a = buf;
+		pitchShift.Process(a.data(), numSamples);
+		shifted.insert(shifted.end(), a.begin(), a.end());
+		delay.Process(buf.data(), numSamples);
+		delayed.insert(delayed.end(), buf.begin(), buf.end());
+	}
+
+	bool silentStart = true;
+	for(uint32 i = 0; i < latency * 2; i++)
+		silentStart &= shifted[i] == 0.0f;
+	TestEnsure(silentStart);
+	TestEnsure(memcmp(shifted.data() + latency * 2, input.data(), (numSamples * numBlocks - latency) * 2 * sizeof(float)) == 0);
+	TestEnsure(memcmp(delayed.data(), shifted.data(), delayed.size() * sizeof(float)) == 0);
+
+	delete audio;
+}
+
+Test("Audio.Limiter")
+{
+	Audio* audio = new Audio();
+	TestEnsure(audio->Init(false));
+
+	const uint32 numSamples = 384;
+	const uint32 numBlocks = 40;
+
+	// A step from silence to a loud signal never gets past the ceiling
+	LimiterDSP stepLimiter;
+	stepLimiter.audio = audio->GetImpl();
+	float maxOutput = 0.0f;
+	for(uint32 block = 0; block < numBlocks; block++)
+	{
+		Vector<float> buf(numSamples * 2);
+		for(auto& v : buf)
+			v = block < numBlocks / 4 ? 0.0f : Random::FloatRange(-3.0f, 3.0f);
+		stepLimiter.Process(buf.data(), numSamples);
+		maxOutput = Math::Max(maxOutput, AudioKernels::PeakAbs(buf.data(), numSamples * 2));
+	}
+	TestEnsure(maxOutput > 0.0f && maxOutput <= stepLimiter.ceiling);
+
+	// Input below the ceiling comes out at unity gain, only delayed
+	LimiterDSP quietLimiter;
+	quietLimiter.audio = audio->GetImpl();
+	uint32 latency = quietLimiter.GetLatency();
+	Vector<float> input;
+	Vector<float> output;
+	for(uint32 block = 0; block < numBlocks; block++)
+	{
+		Vector<float> buf(numSamples * 2);
+		for(auto& v : buf)
+			v = Random::FloatRange(-0.5f, 0.5f);
+		input.insert(input.end(), buf.begin(), buf.end());
+		quietLimiter.Process(buf.data(), numSamples);
+		output.insert(output.end(), buf.begin(), buf.end());
+	}
+	TestEnsure(memcmp(output.data() + latency * 2, input.data(), (numSamples * numBlocks - latency) * 2 * sizeof(float)) == 0);
+
+	delete audio;
+}
+
+// Plays a preloaded stream in large blocks, so playback gets ahead of the background decoder
+//	it should wait for the decoder instead of skipping samples, and still reach the end
+Test("Audio.Stream.DecodeOutrun")
+{
+	Audio* audio = new Audio();
+	TestEnsure(audio->Init(false));
+
+	// Number of non-silent frames output until the stream ended
+	auto PlayToEnd = [&](bool preload)
+	{
+		Ref<AudioStream> stream = audio->CreateStream(testSongPath, preload);
+		TestEnsure(stream);
+		// Processed from here instead of the mixer
+		stream->Deregister();
+		stream->Play();
+
+		const uint32 numSamples = audio->GetSampleRate() * 4;
+		Vector<float> buf(numSamples * 2);
+		uint64 numPlayed = 0;
+		Timer t;
+		while(!stream->HasEnded() && t.SecondsAsDouble() < 60.0)
+		{
+			memset(buf.data(), 0, buf.size() * sizeof(float));
+			stream->Process(buf.data(), numSamples);
+			for(uint32 i = 0; i < numSamples; i++)
+			{
+				if(buf[i * 2] != 0.0f || buf[i * 2 + 1] != 0.0f)
+					numPlayed++;
+			}
+		}
+		TestEnsure(stream->HasEnded());
+		return numPlayed;
+	};
+
+	uint64 streamed = PlayToEnd(false);
+	uint64 preloaded = PlayToEnd(true);
+	TestEnsure(streamed > 0);
+	TestEnsure(preloaded + streamed / 100 >= streamed && preloaded <= streamed + streamed / 100);
+
+	delete audio;
+}
+
 Test("Audio.Music.Phaser")
 {
 	class MusicPlayer : public TestMusicPlayer
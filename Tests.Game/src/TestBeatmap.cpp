@@ -1,8 +1,11 @@
 #include "stdafx.h"
 #include <Audio/Audio.hpp>
 #include <Beatmap/BeatmapPlayback.hpp>
+#include <Beatmap/BeatmapCache.hpp>
+#include <Shared/Files.hpp>
 #include <Audio/DSP.hpp>
 #include "TestMusicPlayer.hpp"
+#include <thread>
 
 // Normal test map
 static String testBeatmapPath = Path::Normalize("songs/love is insecurable/love_is_insecurable.ksh");
@@ -51,6 +54,176 @@ Test("Beatmap.Loading")
 	Logf("Jacket File: %s", Logger::Info, settings.jacketPath);
 }
 
+// Objects should be stored in the order they appear in the chart, with intact hold/laser links
+Test("Beatmap.ObjectLayout")
+{
+	Beatmap beatmap = LoadTestBeatmap();
+	const Vector<ObjectState*>& objects = beatmap.GetLinearObjects();
+	for(size_t i = 1; i < objects.size(); i++)
+	{
+		TestEnsure((uint8*)objects[i - 1] < (uint8*)objects[i]);
+	}
+	for(auto obj : objects)
+	{
+		MultiObjectState* mobj = *obj;
+		if(mobj->type == ObjectType::Hold && mobj->hold.next)
+		{
+			TestEnsure(mobj->hold.next->prev == (HoldObjectState*)mobj);
+		}
+		else if(mobj->type == ObjectType::Laser && mobj->laser.next)
+		{
+			TestEnsure(mobj->laser.next->prev == (LaserObjectState*)mobj);
+		}
+	}
+	Logf("%d objects using %d KB", Logger::Info, (int32)objects.size(), (int32)(beatmap.GetObjectMemoryUsage() / 1024));
+}
+
+// Cached charts should load exactly the same as the parsed chart
+Test("Beatmap.Cache")
+{
+	// Start from an empty folder, entries left by an earlier run would skip the first parse
+	String cacheFolder = Path::Absolute(TestBasePath + Path::sep + context.GetName() + "_Cache");
+	if(Path::IsDirectory(cacheFolder))
+		TestEnsure(Path::DeleteDir(cacheFolder));
+	TestEnsure(Path::CreateDirRecursive(cacheFolder));
+	uint64 lwt = File::GetLastWriteTime(testBeatmapPath);
+
+	Timer timer;
+	Beatmap parsed = LoadTestBeatmap();
+	float parseTime = timer.SecondsAsFloat() * 1000.0f;
+
+	Beatmap first, cached;
+	TestEnsure(BeatmapCache(cacheFolder).Load(testBeatmapPath, lwt, first));
+	Vector<FileInfo> entries = Files::ScanFiles(cacheFolder, "fxmm");
+	TestEnsure(entries.size() == 1);
+	uint64 storedTime = File::GetLastWriteTime(entries[0].fullPath);
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	timer.Restart();
+	TestEnsure(BeatmapCache(cacheFolder).Load(testBeatmapPath, lwt, cached));
+	float cachedTime = timer.SecondsAsFloat() * 1000.0f;
+	Logf("Parsed in %.2fms, loaded from cache in %.2fms", Logger::Info, parseTime, cachedTime);
+
+	// Loading an entry marks it as used, so eviction keeps it over entries that were not loaded since
+	TestEnsure(File::GetLastWriteTime(entries[0].fullPath) > storedTime);
+
+	// The first load parsed the chart and wrote the cache entry, saving both should give the same data
+	Buffer firstData, cachedData;
+	MemoryWriter firstWriter(firstData), cachedWriter(cachedData);
+	TestEnsure(first.Save(firstWriter));
+	TestEnsure(cached.Save(cachedWriter));
+	TestEnsure(firstData.size() == cachedData.size());
+	TestEnsure(memcmp(firstData.data(), cachedData.data(), firstData.size()) == 0);
+
+	TestEnsure(parsed.GetLinearObjects().size() == cached.GetLinearObjects().size());
+	TestEnsure(parsed.GetLinearTimingPoints().size() == cached.GetLinearTimingPoints().size());
+	TestEnsure(parsed.GetMapSettings().title == cached.GetMapSettings().title);
+
+	// A changed write time replaces the entry instead of adding one
+	Beatmap changed;
+	TestEnsure(BeatmapCache(cacheFolder).Load(testBeatmapPath, lwt + 1, changed));
+	TestEnsure(Files::ScanFiles(cacheFolder, "fxmm").size() == 1);
+
+	BeatmapCache(cacheFolder).Evict(0);
+	TestEnsure(Files::ScanFiles(cacheFolder, "fxmm").empty());
+	Path::DeleteDir(cacheFolder);
+}
+
+// Converting view distances back and forth should match on a map with many BPM changes and stops
+// also measures the conversion cost of rendering a frame
+Test("Beatmap.ViewDistance")
+{
+	Beatmap beatmap = LoadTestBeatmap(testBeatmapPath1);
+	BeatmapPlayback playback(beatmap);
+	TestEnsure(playback.Reset(0));
+
+	const float viewRange = 10.0f;
+	MapTime endTime = beatmap.GetLinearObjects().back()->time;
+	uint32 numFrames = 0;
+	Timer timer;
+	for(MapTime time = 0; time < endTime; time += 16, numFrames++)
+	{
+		playback.Update(time);
+		MapTime range = playback.ViewDistanceToDuration(viewRange);
+		// The duration is rounded down to whole ms
+		float distance = playback.DurationToViewDistance(range);
+		TestEnsure(distance <= viewRange + 0.001f && distance > viewRange - 0.05f);
+
+		for(auto obj : playback.GetObjectsInRange(range))
+		{
+			playback.TimeToViewDistance(obj->time);
+			if(obj->type == ObjectType::Hold)
+				playback.DurationToViewDistanceAtTime(obj->time, ((HoldObjectState*)obj)->duration);
+		}
+	}
+	Logf("%d frames, %.2f us per frame", Logger::Info, numFrames, timer.SecondsAsFloat() * 1000000.0f / numFrames);
+}
+
+// The incrementally updated visible object groups should contain exactly the objects in range that have not passed yet
+Test("Beatmap.VisibleObjects")
+{
+	Beatmap beatmap = LoadTestBeatmap();
+	BeatmapPlayback playback(beatmap);
+	TestEnsure(playback.Reset(0));
+	const Vector<ObjectState*>& objects = beatmap.GetLinearObjects();
+
+	MapTime endTime = objects.back()->time;
+	for(MapTime time = 0; time < endTime; time += 50)
+	{
+		playback.Update(time);
+		// Change the range now and then to also test shrinking it
+		MapTime range = (time / 1000) % 2 == 0 ? 2000 : 800;
+		playback.UpdateVisibleObjects(range);
+
+		MapTime passTime = time - playback.hittableObjectLeave;
+		size_t numExpected = 0;
+		for(ObjectState* obj : objects)
+		{
+			MultiObjectState* mobj = *obj;
+			if(mobj->time > time + range)
+				break;
+			MapTime objectEnd = mobj->time;
+			if(mobj->type == ObjectType::Hold)
+				objectEnd += mobj->hold.duration;
+			else if(mobj->type == ObjectType::Laser)
+				objectEnd += mobj->laser.duration;
+			if(mobj->type != ObjectType::Event && objectEnd >= passTime)
+				numExpected++;
+		}
+
+		size_t numVisible = 0;
+		for(uint32 i = 0; i < BeatmapPlayback::NumVisibleObjectGroups; i++)
+		{
+			const Vector<ObjectState*>& group = playback.GetVisibleObjects((BeatmapPlayback::VisibleObjectGroup)i);
+			for(size_t j = 0; j < group.size(); j++)
+			{
+				TestEnsure(group[j]->time <= time + range);
+				if(j > 0)
+				{
+					TestEnsure(group[j - 1]->time <= group[j]->time);
+				}
+			}
+			numVisible += group.size();
+		}
+		TestEnsure(numVisible == numExpected);
+	}
+
+	// BT chips are narrower when there is an FX chip on the same side at the same time
+	for(ObjectState* obj : objects)
+	{
+		MultiObjectState* mobj = *obj;
+		if(mobj->type != ObjectType::Single || mobj->button.index >= 4)
+			continue;
+		bool overlaps = false;
+		for(ObjectState* other : objects)
+		{
+			MultiObjectState* mother = *other;
+			if(mother->time == mobj->time && mother->type == ObjectType::Single && mother->button.index == (mobj->button.index < 2 ? 4 : 5))
+				overlaps = true;
+		}
+		TestEnsure(mobj->button.overlapsFXChip == overlaps);
+	}
+}
+
 // Test 4/4 single bpm map
 Test("Beatmap.Playback")
 {
@@ -2,6 +2,7 @@
 #include <Shared/Enum.hpp>
 #include <Tests/Tests.hpp>
 #include <Shared/Files.hpp>
+#include <Shared/FileWatcher.hpp>
 
 void CreateDummyFile(const String& filename)
 {
@@ -92,6 +93,101 @@ Test("File.ScanFiles")
 	}
 	TestEnsure(expectedPaths.empty());
 }
+// Checks that new files and folders and removed files get reported
+template<typename T>
+void TestWatcher(T& watcher, const String& folder)
+{
+	TestEnsure(watcher.Watch(folder));
+
+	// Files in new folders should be reported as well
+	String folder1 = folder + Path::sep + "Folder";
+	CreateDummyFolderWithFiles(folder1);
+	CreateDummyFile(folder + Path::sep + "fileD");
+
+	Set<String> expectedPaths;
+	expectedPaths.Add(folder1 + Path::sep + "fileA");
+	expectedPaths.Add(folder1 + Path::sep + "fileB");
+	expectedPaths.Add(folder1 + Path::sep + "fileC");
+	expectedPaths.Add(folder + Path::sep + "fileD");
+
+	// The polling fallback only rescans every few seconds
+	for(uint32 i = 0; i < 10 && !expectedPaths.empty(); i++)
+	{
+		for(FileChange& change : watcher.Poll(1000))
+		{
+			if(change.action == FileChange::Modified)
+				expectedPaths.erase(change.fullPath);
+		}
+	}
+	TestEnsure(expectedPaths.empty());
+
+	TestEnsure(Path::Delete(folder + Path::sep + "fileD"));
+	bool removed = false;
+	for(uint32 i = 0; i < 10 && !removed; i++)
+	{
+		for(FileChange& change : watcher.Poll(1000))
+		{
+			if(change.action == FileChange::Removed && change.fullPath == folder + Path::sep + "fileD")
+				removed = true;
+		}
+	}
+	TestEnsure(removed);
+}
+Test("File.Watcher")
+{
+	String folder = Path::Absolute(TestBasePath + Path::sep + context.GetName() + "_TestFolder");
+	TestEnsure(Path::CreateDir(folder));
+
+	FileWatcher watcher;
+	TestWatcher(watcher, folder);
+}
+Test("File.PollingWatcher")
+{
+	String folder = Path::Absolute(TestBasePath + Path::sep + context.GetName() + "_TestFolder");
+	TestEnsure(Path::CreateDir(folder));
+
+	PollingFileWatcher watcher;
+	TestWatcher(watcher, folder);
+}
+// With an extension filter only matching files are reported, other files only as a change to a folder with matching files
+Test("File.PollingWatcher.Filter")
+{
+	String folder = Path::Absolute(TestBasePath + Path::sep + context.GetName() + "_TestFolder");
+	String chartFolder = folder + Path::sep + "Chart";
+	String otherFolder = folder + Path::sep + "Other";
+	TestEnsure(Path::CreateDirRecursive(chartFolder));
+	TestEnsure(Path::CreateDir(otherFolder));
+	CreateDummyFile(chartFolder + Path::sep + "chart.ksh");
+	CreateDummyFile(chartFolder + Path::sep + "audio.ogg");
+
+	// The initial state comes from a scan made by the caller
+	PollingFileWatcher watcher;
+	watcher.SetExtensionFilter("ksh");
+	TestEnsure(watcher.Watch(folder, false));
+	watcher.AddToSnapshot(Files::ScanFilesRecursive(folder, "ksh"));
+	// Longer than the scan interval, so this always scans
+	TestEnsure(watcher.Poll(3000).empty());
+
+	CreateDummyFile(chartFolder + Path::sep + "chart1.ksh");
+	CreateDummyFile(chartFolder + Path::sep + "audio1.ogg");
+	CreateDummyFile(otherFolder + Path::sep + "image.png");
+
+	bool chartAdded = false;
+	bool folderChanged = false;
+	bool otherChanges = false;
+	for(FileChange& change : watcher.Poll(5000))
+	{
+		if(change.action == FileChange::Modified && change.type == FileType::Regular && change.fullPath == chartFolder + Path::sep + "chart1.ksh")
+			chartAdded = true;
+		else if(change.action == FileChange::Modified && change.type == FileType::Folder && change.fullPath == chartFolder)
+			folderChanged = true;
+		else
+			otherChanges = true;
+	}
+	TestEnsure(chartAdded);
+	TestEnsure(folderChanged);
+	TestEnsure(!otherChanges);
+}
 Test("File.Dir")
 {
 	String folder = TestFilename;
@@ -0,0 +1,31 @@
+// Draws all holds of one kind at once, not used on embedded platforms
+#extension GL_ARB_separate_shader_objects : enable
+layout(location=0) in vec2 inPos;
+layout(location=1) in vec2 inTex;
+// Per instance: xy = position on the track, zw = scale
+layout(location=2) in vec4 inOffsetScale;
+// Per instance: x = trackPos, y = trackScale, z = objectGlow, w = hitState
+layout(location=3) in vec4 inParams;
+
+out gl_PerVertex
+{
+	vec4 gl_Position;
+};
+layout(location=1) out vec2 fsTex;
+out vec4 position;
+flat out vec4 objectParams;
+
+uniform mat4 proj;
+uniform mat4 camera;
+uniform mat4 world;
+
+void main()
+{
+	fsTex = inTex;
+	objectParams = inParams;
+
+	position = vec4(inPos.xy, 0, 1);
+
+	vec2 trackPos = inPos.xy * inOffsetScale.zw + inOffsetScale.xy;
+	gl_Position = proj * camera * world * vec4(trackPos, 0, 1);
+}